@@ -0,0 +1,221 @@
+#ifndef __CSRBIN_HEADER_H__
+#define __CSRBIN_HEADER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*---------------------------------------------------------------------
+| Binary sparse matrix cache (.csrb). The file is a 64-byte header
+| followed by three sections, each starting on a 64-byte boundary and
+| zero padded:
+|
+|   ptr[np+1]  offsets of the compressed rows (or columns), idxw bytes
+|   ind[nnz]   column (or row) indices, idxw bytes
+|   val[nnz]   doubles, or (re,im) pairs when CSRB_COMPLEX is set
+|
+| where np = nrow, or ncol when CSRB_CSC is set. All indices are
+| 0-based and stored in the byte order of the writer, which is checked
+| through the bom field. The checksum covers everything after the
+| header, so the sections can be used in place once the file is
+| mapped and checked. This header is shared by ITSOL and the mex
+| loaders, so it is kept free of other dependencies.
+|
+| csrb_create maps a new file for writing, the caller fills the
+| sections and csrb_close stores the checksum. csrb_open maps and
+| validates an existing file read-only.
+|--------------------------------------------------------------------*/
+
+#define CSRB_MAGIC    "CSRBIN\0\0"
+#define CSRB_VERSION  1
+#define CSRB_BOM      0x01020304u
+#define CSRB_ALIGN    64
+#define CSRB_CSC      1       /* sections hold compressed columns      */
+#define CSRB_COMPLEX  2       /* values are (re,im) pairs              */
+
+typedef struct CsrbHead {
+  char magic[8];              /* CSRB_MAGIC                            */
+  uint32_t version;           /* CSRB_VERSION                          */
+  uint32_t bom;               /* CSRB_BOM in the writer's byte order   */
+  uint32_t idxw;              /* bytes per offset and index: 4 or 8    */
+  uint32_t flags;             /* CSRB_CSC | CSRB_COMPLEX               */
+  int64_t nrow;               /* number of rows                        */
+  int64_t ncol;               /* number of columns                     */
+  int64_t nnz;                /* number of stored entries              */
+  uint64_t cksum;             /* csrb_cksum of the sections            */
+  char pad[8];
+} CsrbHead;
+
+static inline size_t csrb_align(size_t x)
+{
+  return (x + CSRB_ALIGN-1) / CSRB_ALIGN * CSRB_ALIGN;
+}
+
+static inline size_t csrb_layout(const CsrbHead *h, size_t *optr,
+				 size_t *oind, size_t *oval)
+{
+/*-------------------- offsets of the sections and size of the file */
+  size_t np = (size_t)((h->flags & CSRB_CSC) ? h->ncol : h->nrow);
+  size_t vw = (h->flags & CSRB_COMPLEX) ? 2*sizeof(double)
+    : sizeof(double);
+  *optr = csrb_align(sizeof(CsrbHead));
+  *oind = *optr + csrb_align((np+1)*h->idxw);
+  *oval = *oind + csrb_align((size_t)h->nnz*h->idxw);
+  return *oval + csrb_align((size_t)h->nnz*vw);
+}
+
+static inline uint64_t csrb_cksum(const void *p, size_t len)
+{
+/*----------------------------------------------------------------------
+| 64-bit checksum of len bytes (a multiple of CSRB_ALIGN). Four FNV-1a
+| style lanes over 8-byte words keep the multiplies independent, so
+| checking a mapped file costs about as much as reading it once.
+|--------------------------------------------------------------------*/
+  const uint64_t prime = 0x100000001b3ULL;
+  uint64_t h0 = 0xcbf29ce484222325ULL, h1 = h0 ^ 1, h2 = h0 ^ 2,
+    h3 = h0 ^ 3, w[4];
+  const char *q = (const char *)p;
+  size_t k;
+  for (k=0; k+32<=len; k+=32, q+=32) {
+    memcpy(w, q, 32);
+    h0 = (h0 ^ w[0]) * prime;
+    h1 = (h1 ^ w[1]) * prime;
+    h2 = (h2 ^ w[2]) * prime;
+    h3 = (h3 ^ w[3]) * prime;
+  }
+  return ((((h0 * prime) ^ h1) * prime ^ h2) * prime ^ h3) * prime;
+}
+
+static inline int64_t csrb_get(const void *p, uint32_t w, size_t k)
+{
+/*-------------------- entry k of an offsets or indices section */
+  return w == 4 ? (int64_t)((const int32_t *)p)[k]
+    : ((const int64_t *)p)[k];
+}
+
+static inline void csrb_set(void *p, uint32_t w, size_t k, int64_t v)
+{
+  if (w == 4)
+    ((int32_t *)p)[k] = (int32_t)v;
+  else
+    ((int64_t *)p)[k] = v;
+}
+
+typedef struct CsrbMap {
+  CsrbHead *h;                /* header at the start of the mapping    */
+  void *ptr;                  /* offsets section                       */
+  void *ind;                  /* indices section                       */
+  double *val;                /* values section                        */
+  size_t len;                 /* length of the mapping                 */
+  int write;                  /* mapped by csrb_create                 */
+} CsrbMap;
+
+static inline void csrb_sections(CsrbMap *m)
+{
+  size_t optr, oind, oval;
+  csrb_layout(m->h, &optr, &oind, &oval);
+  m->ptr = (char *)m->h + optr;
+  m->ind = (char *)m->h + oind;
+  m->val = (double *)((char *)m->h + oval);
+}
+
+static inline int csrb_open(const char *fname, CsrbMap *m, int check)
+{
+/*----------------------------------------------------------------------
+| Map a .csrb file read-only. Returns 0 on success, 1 if the file
+| cannot be opened or mapped, 2 if it is not a .csrb file of this
+| version and byte order, 3 if it is truncated and 4 (only when check
+| is nonzero) if the checksum does not match.
+|--------------------------------------------------------------------*/
+  struct stat st;
+  CsrbHead h;
+  size_t optr, oind, oval, len;
+  void *map;
+  int fd;
+
+  if ((fd = open(fname, O_RDONLY)) < 0) return 1;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return 1;
+  }
+  len = (size_t)st.st_size;
+  if (len < sizeof(CsrbHead) || pread(fd, &h, sizeof(h), 0) !=
+      (ssize_t)sizeof(h)) {
+    close(fd);
+    return 2;
+  }
+  if (memcmp(h.magic, CSRB_MAGIC, 8) || h.version != CSRB_VERSION ||
+      h.bom != CSRB_BOM || (h.idxw != 4 && h.idxw != 8) || h.nrow < 0
+      || h.ncol < 0 || h.nnz < 0) {
+    close(fd);
+    return 2;
+  }
+  if (csrb_layout(&h, &optr, &oind, &oval) > len) {
+    close(fd);
+    return 3;
+  }
+  map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return 1;
+  m->h = (CsrbHead *)map;
+  m->len = len;
+  m->write = 0;
+  csrb_sections(m);
+  if (check && csrb_cksum((char *)map + optr, len - optr) != h.cksum) {
+    munmap(map, len);
+    return 4;
+  }
+  return 0;
+}
+
+static inline int csrb_create(const char *fname, const CsrbHead *h,
+			      CsrbMap *m)
+{
+/*----------------------------------------------------------------------
+| Create a .csrb file for the sizes and flags of h and map it for
+| writing. The sections are zero filled. Returns 0 on success, 1 if
+| the file cannot be created or mapped.
+|--------------------------------------------------------------------*/
+  size_t optr, oind, oval, len;
+  void *map;
+  int fd;
+
+  len = csrb_layout(h, &optr, &oind, &oval);
+  if ((fd = open(fname, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) return 1;
+  if (ftruncate(fd, (off_t)len) < 0) {
+    close(fd);
+    return 1;
+  }
+  map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return 1;
+  m->h = (CsrbHead *)map;
+  memcpy(m->h, h, sizeof(CsrbHead));
+  memcpy(m->h->magic, CSRB_MAGIC, 8);
+  m->h->version = CSRB_VERSION;
+  m->h->bom = CSRB_BOM;
+  m->len = len;
+  m->write = 1;
+  csrb_sections(m);
+  return 0;
+}
+
+static inline int csrb_close(CsrbMap *m)
+{
+/*-------------------- unmap, storing the checksum of a new file */
+  size_t off = csrb_align(sizeof(CsrbHead));
+  int ierr = 0;
+  if (m->write) {
+    m->h->cksum = csrb_cksum((char *)m->h + off, m->len - off);
+    if (msync(m->h, m->len, MS_SYNC) < 0) ierr = 1;
+  }
+  munmap(m->h, m->len);
+  m->h = NULL;
+  return ierr;
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef __VBLOCK_HEADER_H__
 #define __VBLOCK_HEADER_H__
 
+#include <limits.h>
+
 #define MAX_BLOCK_SIZE   100
 
 /* FORTRAN style vblock format, compatible for many FORTRAN routines */
@@ -9,15 +11,38 @@
 /* the dimension of ith Block */
 #define B_DIM(bs,i)      (bs[i+1]-bs[i])
 
+/* integer type of the offsets into the arenas of SpaFmt structs and
+   into other arrays that may hold more than 2^31-1 entries. Build with
+   -DITS_LONG_INDEX to use 64-bit offsets. */
+#ifdef ITS_LONG_INDEX
+typedef long nnzint;
+#define NNZINT_MAX LONG_MAX
+#else
+typedef int nnzint;
+#define NNZINT_MAX INT_MAX
+#endif
+
 typedef struct SpaFmt {
 /*--------------------------------------------- 
 | C-style CSR format - used internally
 | for all matrices in CSR format 
+| The rows are stored contiguously in one
+| arena of column indices (jall) and one of
+| nonzero entries (mall): row i starts at
+| offset ia[i]. Rows must be allocated with
+| csAllocRow, never with Malloc. ja[i] and
+| ma[i] point into the arenas and are kept
+| as a view for row-wise access.
 |---------------------------------------------*/
   int n;
   int *nzcount;  /* length of each row */
   int **ja;      /* pointer-to-pointer to store column indices  */
   double **ma;   /* pointer-to-pointer to store nonzero entries */
+  nnzint *ia;    /* offset of each row in the arenas, -1 if none */
+  int *jall;     /* arena of column indices of all rows         */
+  double *mall;  /* arena of nonzero entries of all rows        */
+  nnzint nnzall; /* number of entries used in the arenas        */
+  nnzint nnzmax; /* capacity of the arenas                      */
 } SparMat, *csptr;
 
 typedef double *BData;
@@ -55,6 +80,25 @@ typedef struct ILUfac {
     int *work;    /* working buffer */
 } ILUSpar, LDUmat, *iluptr;
 
+typedef struct ILUKsym {
+/*------------------------------------------------------------
+| symbolic ILUK factorization, see ilukSymbolic
+| n       = size of matrix
+| L, U    = patterns of the factors (SpaFmt, ma is NULL)
+| nlev    = number of levels of the dependency graph of L
+| ilev    = the rows of level l are lrow[ilev[l]:ilev[l+1]-1]
+|           (nlev+1 entries)
+| lrow    = rows sorted by level, in increasing order within
+|           a level
+|----------------------------------------------------------*/
+  int n;
+  csptr L;
+  csptr U;
+  int nlev;
+  int *ilev;
+  int *lrow;
+} ILUKSym, *iluksptr;
+
 typedef struct PerMat4 *p4ptr;
 typedef struct PerMat4 {
 /*------------------------------------------------------------
@@ -78,10 +122,19 @@ typedef struct PerMat4 {
 |           (at any level) before anything else is done. 
 | wk     = a work vector of length n needed for various tasks
 |            [reduces number of calls to malloc]           
+| nbnd    = number of diagonal blocks of B
+| bnd     = boundaries of the diagonal blocks of B (nbnd+1
+|           entries) given by the independent set ordering,
+|           NULL if B is not known to be block diagonal
+| nthreads= number of threads for descend and ascend. The
+|           diagonal blocks of B are solved concurrently.
 |----------------------------------------------------------*/ 
   int n;                  
   int nB; 
   int symperm;
+  int nbnd;
+  int *bnd;
+  int nthreads;
 /*   LU factors  */
   struct SpaFmt *L;
   struct SpaFmt *U;
@@ -147,6 +200,7 @@ typedef struct arms_st {
   |---------------------------------------------- */
   int n;                   /* dimension of matrix */
   int nlev;                /* number of levels    */
+  int nthreads;            /* number of threads for the solves */
   ilutptr ilus;            /* ILU for last level  */
   p4ptr levmat;            /* level structure     */
 } armsMat;
@@ -164,6 +218,12 @@ typedef struct _SMat {
   csptr CS;            /* place holder for a CSR/CSC type matrix */
   iluptr LDU;          /* struct for an LDU type matrix          */
   vbsptr VBCSR;        /* place holder for a block matrix        */
+  int nthreads;        /* number of threads for the matvec       */
+  int *part;           /* partition of the rows among the threads,
+                          nthreads+1 entries -- see setupSMat.
+                          An SMat not set up by setupSMat must
+                          have nthreads = 1 and part = NULL, the
+                          matvecs are then serial               */
   void (*matvec)(struct _SMat*, double *, double *);
 } SMat, *SMatptr;
 
@@ -5,6 +5,7 @@
 #define MM0  2
 #define MM1  3
 #define UNK  4
+#define CSRB 5
 
 typedef struct _io_t {
     FILE *fout;                 /* output file handle              */
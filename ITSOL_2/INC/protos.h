@@ -145,10 +145,15 @@ extern void   dgetri(int *n, double *a, int *lda, int *ipvt, double
 /* sets.c */
 extern int nnz_arms (arms PreSt,  FILE *ft);
 extern void errexit(char *f_str, ...);
-extern void *Malloc(int nbytes, char *msg); 
+extern void *Malloc(size_t nbytes, char *msg); 
+extern void *Realloc(void *ptr, size_t nbytes, char *msg); 
 extern int setupCS(csptr amat, int len, int job); 
 extern int cleanCS(csptr amat);
-extern int nnz_cs (csptr A) ;
+extern int csReserve(csptr amat, nnzint nnz);
+extern int csAllocRow(csptr amat, int row, int len);
+extern int csTrim(csptr amat);
+extern int csMerge(csptr amat, csptr *parts, int nparts);
+extern nnzint nnz_cs (csptr A) ;
 extern int cscpy(csptr amat, csptr bmat);
 extern int setupP4 (p4ptr amat, int Bn, int Cn,  csptr F,  csptr E);
 extern int setupVBMat(vbsptr vbmat, int n, int *nB);
@@ -173,6 +178,8 @@ extern int col2vbcol( int col, vbsptr vbmat );
 extern int nnz_vbilu(vbiluptr lu); 
 extern int nnz_lev4(p4ptr levmat, int *lev, FILE *ft);
 extern int setupILU( iluptr lu, int n );
+extern int setupILUK( iluptr lu, iluksptr sym );
+extern int cleanILUKSym( iluksptr sym );
 extern int CS2lum( int n, csptr Amat, iluptr mat, int typ);
 extern int COOcs(int n, int nnz,  double *a, int *ja, int *ia, csptr bmat);
 void coocsr_(int*, int*, double*, int*, int*, double*, int*, int*);
@@ -184,7 +191,15 @@ extern void matvec(csptr mata, double *x, double *y);
 extern void matvecCSR(SMatptr mat, double *x, double *y);
 extern void matvecz(csptr mata, double *x, double *y, double *z);
 extern void vbmatvec(vbsptr vbmat, double *x, double *y);
-extern void luinv(int n, double *a, double *x, double *y); 
+extern void matvec_omp(csptr mata, double *x, double *y, int nthreads,
+		       int *part);
+extern void matvecz_omp(csptr mata, double *x, double *y, double *z,
+			int nthreads, int *part);
+extern void vbmatvec_omp(vbsptr vbmat, double *x, double *y, int nthreads,
+			 int *part);
+extern int csPartition(csptr mata, int nthreads, int *part);
+extern int vbPartition(vbsptr vbmat, int nthreads, int *part);
+extern int setupSMat(SMatptr mat, int nthreads);
 extern int vblusolC(double *y, double *x, vbiluptr lu); 
 extern int lusolC( double *y, double *x, iluptr lu ); 
 extern int rpermC(csptr mat, int *perm); 
@@ -234,8 +249,14 @@ extern int vbilukC( int lofM, vbsptr vbmat, vbiluptr lu, FILE *fp );
 extern int vbilutC( vbsptr vbmat, vbiluptr lu, int lfil, double tol,
 		    BData *w, FILE *fp ); 
 extern int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop,
-		 FILE *fp ); 
+		 FILE *fp );
+extern int ilutc_batch(int nmat, iluptr *mt, iluptr *lu, int lfil,
+		       double tol, int drop, int *ierr, int nthreads,
+		       FILE *fp); 
 extern int ilukC( int lofM, csptr csmat, iluptr lu, FILE *fp );
+extern int ilukSymbolic( int lofM, csptr csmat, iluksptr sym, FILE *fp );
+extern int ilukNumeric( csptr csmat, iluksptr sym, iluptr lu,
+			int nthreads, FILE *fp );
 extern int ilut( csptr csmat, iluptr lu, int lfil, double tol,
 		 FILE *fp );
 extern   int fgmr(SMatptr Amat, SPreptr lu, double *rhs, double *sol, double tol,
@@ -295,7 +316,7 @@ extern int PQperm(csptr mat, int bsize, int *Pord, int *Qord, int
 extern int add2com(int *nback, int nod, int *iord, int *riord);
 extern int add2is(int *last, int nod, int *iord, int *riord);
 extern int indsetC(csptr mat, int bsize, int *iord, int *nnod, double
-		   tol); 
+		   tol, int *bnd, int *nbnd); 
 extern int preSel(csptr mat, int *icor, int *jcor, int job, double
 		  tol, int *count);
 /* indsetC.c */
@@ -313,4 +334,21 @@ extern double sys_timer(void);
 /*auxill.c */
 extern void randvec (double *v, int n);		   	       
 
+/* blkops.c */
+extern void bgemv(int m, int n, double alpha, BData a, double *x,
+		  double beta, double *y);
+extern void bgemm(int m, int n, int k, double alpha, BData a, BData b,
+		  double beta, BData c);
+extern void luinv(int n, double *a, double *x, double *y);
+
+/* readmm.c */
+extern int readmm(char *fname, int base, int job, int nthreads, int *nrow,
+		  int *ncol, int *nnz, double **val, int **row, int **col);
+extern int readmm_csr(char *fname, int base, int job, int nthreads,
+		      int *nrow, int *ncol, double **a, int **ja, int **ia);
+
+/* csrbin.c */
+extern int readcsrb(char *fname, csptr mat);
+extern int writecsrb(char *fname, csptr mat);
+
 #endif 
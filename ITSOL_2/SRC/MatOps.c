@@ -2,9 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h> 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "globheads.h"
 #include "protos.h"
 
+static void matvec_rows(csptr mata, double *x, double *y, int i0, int i1);
+static void matvecz_rows(csptr mata, double *x, double *y, double *z,
+			 int i0, int i1);
+static void vbmatvec_rows(vbsptr vbmat, double *x, double *y, int i0,
+			  int i1);
+static void Lsol_rows(csptr mata, double *b, double *x, int i0, int i1);
+static void Usol_rows(csptr mata, double *b, double *x, int i0, int i1);
+
 
 int diag_scal( vbsptr vbmat ){
 /*----------------------------------------------------------------------------
@@ -65,8 +76,7 @@ int diag_scal( vbsptr vbmat ){
         for( j = 0; j < nzcount; j++ ) {
             col = ja[j];
             sz = B_DIM( bsz, col );
-	    DGEMM ("n","n",  dim, sz, dim, one,D[i], dim, ba[j], dim,
-		   zero, buf,dim) ; 
+	    bgemm( dim, sz, dim, one, D[i], ba[j], zero, buf );
 	    copyBData( dim, sz, ba[j], buf, 0 );
         }
     }
@@ -87,13 +97,12 @@ int diagvec( vbsptr vbmat, BData x, BData y )
 | on return
 | y     = the product inv(D) * x
 |--------------------------------------------------------------------*/
-    int i, n = vbmat->n, *bsz = vbmat->bsz, dim, sz = 1;
+    int i, n = vbmat->n, *bsz = vbmat->bsz, dim;
     double zero=0.0, one = 1.0;
     BData *D = vbmat->D;
     for (i = 0; i < n; i++ ) {
         dim = B_DIM( bsz, i );
-	DGEMM ("n","n", dim,sz,dim,one,D[i],dim,x+bsz[i],dim,zero,
-	       y+bsz[i],dim) ;  
+	bgemv( dim, dim, one, D[i], x+bsz[i], zero, y+bsz[i] );
     }
     return 0;
 }
@@ -111,28 +120,76 @@ void matvec( csptr mata, double *x, double *y )
 | on return
 | y     = the product A * x
 |--------------------------------------------------------------------*/
-/*   local variables    */
-   int i, k, *ki;
-   double *kr;
-   for (i=0; i<mata->n; i++) {
-      y[i] = 0.0;
-      kr = mata->ma[i];
-      ki = mata->ja[i];
-      for (k=0; k<mata->nzcount[i]; k++)
-         y[i] += kr[k] * x[ki[k]];
-   }
+   matvec_rows(mata, x, y, 0, mata->n);
    return;
 }
 
+static void matvec_rows(csptr mata, double *x, double *y, int i0, int i1)
+{
+/*-------------------- y = A x for the rows i0 to i1-1 */
+   int i, *ja = mata->jall;
+  nnzint k, k1, *ia = mata->ia;
+   double *ma = mata->mall, t;
+   for (i=i0; i<i1; i++) {
+      t = 0.0;
+      k1 = ia[i] + mata->nzcount[i];
+      for (k=ia[i]; k<k1; k++)
+         t += ma[k] * x[ja[k]];
+      y[i] = t;
+   }
+}
+
+void matvec_omp(csptr mata, double *x, double *y, int nthreads, int *part)
+{
+/*---------------------------------------------------------------------
+| This function does the matrix vector product y = A x with OpenMP.
+|----------------------------------------------------------------------
+| on entry:
+| mata     = the matrix (in SpaFmt form)
+| x        = a vector
+| nthreads = number of threads
+| part     = partition of the rows among the threads computed by 
+|            csPartition. Thread t computes the rows part[t] to 
+|            part[t+1]-1.
+|
+| on return
+| y     = the product A * x
+|
+| Falls back to matvec if nthreads <= 1, part is NULL or without
+| OpenMP.
+|--------------------------------------------------------------------*/
+#ifdef _OPENMP
+  if (nthreads > 1 && part != NULL) {
+#pragma omp parallel num_threads(nthreads)
+    {
+      int t;
+      /* the runtime may provide fewer threads than requested */
+      for (t = omp_get_thread_num(); t < nthreads; 
+	   t += omp_get_num_threads())
+	matvec_rows(mata, x, y, part[t], part[t+1]);
+    }
+    return;
+  }
+#endif
+  matvec_rows(mata, x, y, 0, mata->n);
+}
+
 void vbmatvec(vbsptr vbmat, double *x, double *y )
 {
 /*-------------------- matrix -- vector product in VB format */
-  int i, j, nzcount, col, inc = 1, dim, sz, nBs, nBsj; 
-  int n = vbmat->n, *ja, *bsz = vbmat->bsz;
+  vbmatvec_rows(vbmat, x, y, 0, vbmat->n);
+}
+
+static void vbmatvec_rows(vbsptr vbmat, double *x, double *y, int i0,
+			  int i1)
+{
+/*-------------------- y = A x for the block rows i0 to i1-1 */
+  int i, j, nzcount, col, dim, sz, nBs, nBsj; 
+  int *ja, *bsz = vbmat->bsz;
   double one=1.0;
   BData *ba;
   
-  for( i = 0; i < n; i++ ) {
+  for( i = i0; i < i1; i++ ) {
     nBs = bsz[i];
     dim = B_DIM(bsz,i);
     for( j = 0; j < dim; j++ ) 
@@ -145,11 +202,33 @@ void vbmatvec(vbsptr vbmat, double *x, double *y )
       nBsj = bsz[col];
       sz = B_DIM(bsz,col);
 /*-------------------- operation:  y = Block*x + y */
-      DGEMV ("n", dim, sz,one, ba[j],dim,&x[nBsj],inc,one,&y[nBs],inc);
+      bgemv( dim, sz, one, ba[j], &x[nBsj], one, &y[nBs] );
     }
   }
 }
 
+void vbmatvec_omp(vbsptr vbmat, double *x, double *y, int nthreads,
+		  int *part)
+{
+/*---------------------------------------------------------------------
+| matrix -- vector product in VB format with OpenMP. part is the 
+| partition of the block rows computed by vbPartition. See matvec_omp.
+|--------------------------------------------------------------------*/
+#ifdef _OPENMP
+  if (nthreads > 1 && part != NULL) {
+#pragma omp parallel num_threads(nthreads)
+    {
+      int t;
+      for (t = omp_get_thread_num(); t < nthreads; 
+	   t += omp_get_num_threads())
+	vbmatvec_rows(vbmat, x, y, part[t], part[t+1]);
+    }
+    return;
+  }
+#endif
+  vbmatvec_rows(vbmat, x, y, 0, vbmat->n);
+}
+
 
 void Lsol(csptr mata, double *b, double *x)
 {
@@ -164,21 +243,25 @@ void Lsol(csptr mata, double *b, double *x)
 | on return
 | x     = the solution of L x = b 
 |--------------------------------------------------------------------*/
-/*   local variables    */
-  int i, k;
-  double *kr;
-  int *ki;
-  for (i=0; i<mata->n; i++) {
-    x[i] = b[i];
-    if ( mata->nzcount[i] > 0 ) {
-      kr = mata->ma[i];
-      ki = mata->ja[i];
-      for (k=0; k<mata->nzcount[i]; k++)
-	x[i] -= kr[k]*x[ki[k]];
-    }
-  }
+  Lsol_rows(mata, b, x, 0, mata->n);
   return;
 }
+
+static void Lsol_rows(csptr mata, double *b, double *x, int i0, int i1)
+{
+/*-------------------- forward solve with the rows i0 to i1-1 of L,
+  which must not reference the unknowns i1 and above */
+  int i, *ja = mata->jall;
+  nnzint k, k1, *ia = mata->ia;
+  double *ma = mata->mall, t;
+  for (i=i0; i<i1; i++) {
+    t = b[i];
+    k1 = ia[i] + mata->nzcount[i];
+    for (k=ia[i]; k<k1; k++)
+      t -= ma[k]*x[ja[k]];
+    x[i] = t;
+  }
+}
 /*---------------end of Lsol-----------------------------------------
 ----------------------------------------------------------------------*/
 void Usol(csptr mata, double *b, double *x)
@@ -195,19 +278,26 @@ void Usol(csptr mata, double *b, double *x)
 | x     = the solution of U * x = b 
 |
 |---------------------------------------------------------------------*/
-/*   local variables    */
-  int i, k, *ki;
-  double *kr;
-  for (i=mata->n-1; i>=0; i--) {
-    kr = mata->ma[i];
-    ki = mata->ja[i];
-    x[i] = b[i] ;
-    for (k=1; k<mata->nzcount[i]; k++)
-      x[i] -= kr[k] * x[ki[k]];
-    x[i] *= kr[0];
-  }
+  Usol_rows(mata, b, x, 0, mata->n);
   return;
 }
+
+static void Usol_rows(csptr mata, double *b, double *x, int i0, int i1)
+{
+/*-------------------- backward solve with the rows i0 to i1-1 of U,
+  which must not reference the unknowns below i0 */
+  int i, *ja = mata->jall;
+  nnzint k, k0, k1, *ia = mata->ia;
+  double *ma = mata->mall, t;
+  for (i=i1-1; i>=i0; i--) {
+    k0 = ia[i];
+    k1 = k0 + mata->nzcount[i];
+    t = b[i] ;
+    for (k=k0+1; k<k1; k++)
+      t -= ma[k] * x[ja[k]];
+    x[i] = t * ma[k0];
+  }
+}
 /*----------------end of Usol----------------------------------------
 ----------------------------------------------------------------------*/
 
@@ -222,10 +312,36 @@ int descend(p4ptr levmat, double *x, double *wk)
 |     | EU^{-1}  I |  | wx2 |    | x2 |
 |     |            |  |     |    |    |
 | x used and not touched -- or can be the same as wk.
+| If the diagonal blocks of B are known (levmat->bnd), they are solved
+| concurrently with levmat->nthreads threads.
 |--------------------------------------------------------------------*/
 /*  local variables   */
   int j, len=levmat->n, lenB=levmat->nB, *iperm=levmat->rperm; 
   double *work = levmat->wk; 
+#ifdef _OPENMP
+  if (levmat->nthreads > 1 && levmat->bnd != NULL) {
+    int *bnd = levmat->bnd, nbnd = levmat->nbnd, nE = len-lenB;
+#pragma omp parallel num_threads(levmat->nthreads) private(j)
+    {
+      int b, t, nt;
+#pragma omp for schedule(static)
+      for (j=0; j<len; j++)
+	work[iperm[j]] = x[j] ;
+/*-------------------- the blocks of L and U are decoupled */
+#pragma omp for schedule(static)
+      for (b=0; b<nbnd; b++) {
+	Lsol_rows(levmat->L, work, wk, bnd[b], bnd[b+1]);
+	Usol_rows(levmat->U, wk, work, bnd[b], bnd[b+1]);
+      }
+/*-------------------- x[lenb:.] = x [lenb:.] - E * work(1) */
+      t = omp_get_thread_num();
+      nt = omp_get_num_threads();
+      matvecz_rows(levmat->E, work, &work[lenB], &wk[lenB],
+		   (int)((long)nE*t/nt), (int)((long)nE*(t+1)/nt));
+    }
+    return 0;
+  }
+#endif
 /*------------------------------------------------------
 |   apply permutation P to rhs 
 |-----------------------------------------------------*/
@@ -252,10 +368,40 @@ int ascend (p4ptr levmat, double *x, double *wk)
 |     |            |  |     |    |    |       and we need x1
 |
 |    with x2 = S^{-1} wk2 [assumed to have been computed ] 
+|
+| The diagonal blocks of B are processed concurrently as in descend.
 |--------------------------------------------------------------------*/
  /*--------------------  local variables  */
   int j, len=levmat->n, lenB=levmat->nB, *qperm=levmat->perm;
   double *work = levmat->wk; 
+#ifdef _OPENMP
+  if (levmat->nthreads > 1 && levmat->bnd != NULL) {
+    int *bnd = levmat->bnd, nbnd = levmat->nbnd;
+#pragma omp parallel num_threads(levmat->nthreads) private(j)
+    {
+      int b, i0, i1;
+/*-------------------- the rows of F, L and U of a block only 
+                       reference the unknowns of the block */
+#pragma omp for schedule(static)
+      for (b=0; b<nbnd; b++) {
+	i0 = bnd[b];
+	i1 = bnd[b+1];
+	matvec_rows(levmat->F, &x[lenB], work, i0, i1);
+	Lsol_rows(levmat->L, work, work, i0, i1);
+	for (j=i0; j<i1; j++)
+	  work[j] = x[j] - work[j];
+	Usol_rows(levmat->U, work, work, i0, i1);
+      }
+#pragma omp single
+      memcpy(&work[lenB],&x[lenB],(len-lenB)*sizeof(double));
+/*-------------------- apply reverse permutation, x may be wk */
+#pragma omp for schedule(static)
+      for (j=0; j<len; j++)
+	wk[j] = work[qperm[j]];     
+    }
+    return 0;
+  }
+#endif
   /*-------------------- copy x onto wk */  
   matvec(levmat->F, &x[lenB], work);   /*  work = F * x_2   */
   Lsol(levmat->L, work, work);         /*  work = L \ work    */
@@ -288,18 +434,132 @@ void matvecz(csptr mata, double *x, double *y, double *z)
 | z-location must be different from that of x 
 | i.e., y and x are used but not modified.
 |--------------------------------------------------------------------*/
-/*   local variables    */
-  int i, k, *ki;
-  double *kr, t;
-  for (i=0; i<mata->n; i++) {
-    kr = mata->ma[i];
-    ki = mata->ja[i];
+  matvecz_rows(mata, x, y, z, 0, mata->n);
+  return;
+}
+
+static void matvecz_rows(csptr mata, double *x, double *y, double *z,
+			 int i0, int i1)
+{
+/*-------------------- z = y - A x for the rows i0 to i1-1 */
+  int i, *ja = mata->jall;
+  nnzint k, k1, *ia = mata->ia;
+  double *ma = mata->mall, t;
+  for (i=i0; i<i1; i++) {
     t = y[i] ;
-    for (k=0; k<mata->nzcount[i]; k++)
-      t -= kr[k] * x[ki[k]];
+    k1 = ia[i] + mata->nzcount[i];
+    for (k=ia[i]; k<k1; k++)
+      t -= ma[k] * x[ja[k]];
     z[i] = t; 
   }
-  return;
+}
+
+void matvecz_omp(csptr mata, double *x, double *y, double *z, 
+		 int nthreads, int *part)
+{
+/*---------------------------------------------------------------------
+| This function does z = y - A x with OpenMP. See matvecz and
+| matvec_omp.
+|--------------------------------------------------------------------*/
+#ifdef _OPENMP
+  if (nthreads > 1 && part != NULL) {
+#pragma omp parallel num_threads(nthreads)
+    {
+      int t;
+      for (t = omp_get_thread_num(); t < nthreads; 
+	   t += omp_get_num_threads())
+	matvecz_rows(mata, x, y, z, part[t], part[t+1]);
+    }
+    return;
+  }
+#endif
+  matvecz_rows(mata, x, y, z, 0, mata->n);
+}
+
+int csPartition(csptr mata, int nthreads, int *part)
+{
+/*---------------------------------------------------------------------
+| Partition the rows of a matrix into nthreads contiguous blocks with 
+| about the same number of nonzeros, counting one for each row to 
+| account for the loop overhead.
+|----------------------------------------------------------------------
+| on entry:
+| mata     = the matrix (in SpaFmt form)
+| nthreads = number of blocks
+|
+| on return
+| part     = array of length nthreads+1. Block t consists of the rows
+|            part[t] to part[t+1]-1.
+|--------------------------------------------------------------------*/
+  int i, t, n = mata->n;
+  double total = 0.0, acc = 0.0;
+  for (i=0; i<n; i++)
+    total += mata->nzcount[i] + 1;
+  part[0] = 0;
+  t = 1;
+  for (i=0; i<n && t<nthreads; i++) {
+    acc += mata->nzcount[i] + 1;
+    while (t < nthreads && acc * nthreads >= t * total)
+      part[t++] = i+1;
+  }
+  while (t <= nthreads)
+    part[t++] = n;
+  return 0;
+}
+
+int vbPartition(vbsptr vbmat, int nthreads, int *part)
+{
+/*---------------------------------------------------------------------
+| Partition the block rows of a matrix in VBSpaFmt format into 
+| nthreads contiguous blocks with about the same number of scalar
+| nonzeros. See csPartition.
+|--------------------------------------------------------------------*/
+  int i, j, t, n = vbmat->n, *bsz = vbmat->bsz;
+  double total = 0.0, acc = 0.0, *w;
+  w = (double *) Malloc(n*sizeof(double), "vbPartition");
+  for (i=0; i<n; i++) {
+    w[i] = 1.0;
+    for (j=0; j<vbmat->nzcount[i]; j++)
+      w[i] += B_DIM(bsz,i) * B_DIM(bsz,vbmat->ja[i][j]);
+    total += w[i];
+  }
+  part[0] = 0;
+  t = 1;
+  for (i=0; i<n && t<nthreads; i++) {
+    acc += w[i];
+    while (t < nthreads && acc * nthreads >= t * total)
+      part[t++] = i+1;
+  }
+  while (t <= nthreads)
+    part[t++] = n;
+  free(w);
+  return 0;
+}
+
+int setupSMat(SMatptr mat, int nthreads)
+{
+/*---------------------------------------------------------------------
+| Set the number of threads for the matvecs of an SMat struct and
+| partition its matrix among them. mat->matvec and the matrix it uses
+| (mat->CS or mat->VBCSR) must be set, and mat->part must be NULL or
+| returned by a previous call. Call again when the matrix changes.
+|----------------------------------------------------------------------
+| on entry:
+| mat      = the SMat struct
+| nthreads = number of threads, 1 for serial matvecs
+|
+| on return
+| mat->nthreads, mat->part
+|--------------------------------------------------------------------*/
+  if (nthreads < 1) nthreads = 1;
+  mat->nthreads = nthreads;
+  mat->part = (int *) Realloc(mat->part, (nthreads+1)*sizeof(int),
+			      "setupSMat");
+  if (mat->matvec == matvecVBR)
+    vbPartition(mat->VBCSR, nthreads, mat->part);
+  else
+    csPartition(mat->CS, nthreads, mat->part);
+  return 0;
 }
 /*---------------end of matvecz----------------------------------------
  *--------------------------------------------------------------------*/
@@ -488,39 +748,6 @@ void SchUsol(ilutptr ilusch, double *y)
 /*---------------end of SchUsol---------------------------------------
 ----------------------------------------------------------------------*/
 
-void luinv( int n, double *a, double *x, double *y )
-{
-/*--------------------------------------------------------
- *    does the operation y = inv(a) * x
- *    where a has already been factored by Gauss.
- *    LUy = x
- *------------------------------------------------------*/
-    int i, j, bsA, bsB;
-    double sum;
-    /* Ly0 = x -- use Lsol ? */   
-    for( i = 0; i < n; i++ ) {
-        sum = x[i];
-        bsA = i - n;
-        for( j = 0; j < i; j++ ) {
-            bsA += n;
-            sum -= a[bsA] * y[j]; /* a(i,j) * y(j) */
-        }
-        y[i] = sum;
-    }
-    /* Uy = y0 */
-    bsB = i * n;
-    for( i = n-1; i >= 0; i-- ) {
-        sum = y[i];
-        bsB -= n;
-        bsA = i+bsB;
-        for( j = i+1; j < n; j++ ) {
-            bsA += n;
-            sum -= a[bsA] * y[j]; /* a(i,j) * y(j) */
-        }
-        y[i] = sum * a[bsB+i]; /* a(i,i) */
-    }
-}
-
 int lusolC( double *y, double *x, iluptr lu )
 {
 /*----------------------------------------------------------------------
@@ -530,8 +757,9 @@ int lusolC( double *y, double *x, iluptr lu )
  *    x  = solution on return 
  *    lu = LU matrix as produced by iluk. 
  *--------------------------------------------------------------------*/
-    int n = lu->n, i, j, nzcount, *ja;
-    double *D;
+    int n = lu->n, i, *ja;
+    nnzint j, j1, *ia;
+    double *D, *ma, t;
     csptr L, U;
 
     L = lu->L;
@@ -539,22 +767,28 @@ int lusolC( double *y, double *x, iluptr lu )
     D = lu->D;
 
     /* Block L solve */
+    ia = L->ia;
+    ja = L->jall;
+    ma = L->mall;
     for( i = 0; i < n; i++ ) {
-        x[i] = y[i];
-        nzcount = L->nzcount[i];
-        ja = L->ja[i];
-        for( j = 0; j < nzcount; j++ ) {
-            x[i] -= x[ja[j]] * L->ma[i][j];
+        t = y[i];
+        j1 = ia[i] + L->nzcount[i];
+        for( j = ia[i]; j < j1; j++ ) {
+            t -= x[ja[j]] * ma[j];
         }
+        x[i] = t;
     }
     /* Block -- U solve */
+    ia = U->ia;
+    ja = U->jall;
+    ma = U->mall;
     for( i = n-1; i >= 0; i-- ) {
-        nzcount = U->nzcount[i];
-        ja = U->ja[i];
-        for( j = 0; j < nzcount; j++ ) {
-            x[i] -= x[ja[j]] * U->ma[i][j];
+        t = x[i];
+        j1 = ia[i] + U->nzcount[i];
+        for( j = ia[i]; j < j1; j++ ) {
+            t -= x[ja[j]] * ma[j];
         }
-        x[i] *= D[i];
+        x[i] = t * D[i];
     }
     return (0); 
 }
@@ -567,31 +801,36 @@ int lumsolC(double *y, double *x, iluptr lu ){
  *    x  = solution on return
  *    lu = LU matrix as produced by iluc.
  *--------------------------------------------------------------------*/
-    int n = lu->n, i, j, nzcount, nnzL, *ia, *ja;
-    double *D = lu->D, *ma;
+    int n = lu->n, i, *ja;
+    nnzint j, j1, *ia;
+    double *D = lu->D, *ma, t;
     csptr L = lu->L;
     csptr U = lu->U;
 
     for(i = 0; i < n; i++ )
         x[i] = y[i];
-/*-------------------- L solve */
+/*-------------------- L solve, L is stored by columns */
+    ia = L->ia;
+    ja = L->jall;
+    ma = L->mall;
     for(i = 0; i < n; i++ ) {
-        nnzL = L->nzcount[i];
-        ia = L->ja[i];
-        ma = L->ma[i];
-        for(j = 0; j < nnzL; j++ ) {
-            x[ia[j]] -= ma[j] * x[i];
+        t = x[i];
+        j1 = ia[i] + L->nzcount[i];
+        for(j = ia[i]; j < j1; j++ ) {
+            x[ja[j]] -= ma[j] * t;
         }
     }
 /*-------------------- U solve */
+    ia = U->ia;
+    ja = U->jall;
+    ma = U->mall;
     for(i = n-1; i >= 0; i-- ) {
-        nzcount = U->nzcount[i];
-        ja = U->ja[i];
-        ma = U->ma[i];
-        for(j = 0; j < nzcount; j++ ) {
-            x[i] -= ma[j] * x[ja[j]];
+        t = x[i];
+        j1 = ia[i] + U->nzcount[i];
+        for(j = ia[i]; j < j1; j++ ) {
+            t -= ma[j] * x[ja[j]];
         }
-        x[i] *= D[i];
+        x[i] = t * D[i];
     }
 
     return 0;
@@ -609,7 +848,7 @@ int vblusolC( double *y, double *x, vbiluptr lu)
  *    note: lu->bf is used to store vector
  *--------------------------------------------------------------------*/
     int n = lu->n, *bsz = lu->bsz, i, j, bi, icol, dim, sz;
-    int nzcount, nBs, nID, *ja, inc = 1, OPT;
+    int nzcount, nBs, nID, *ja, OPT;
     double *data, alpha = -1.0, beta = 1.0, alpha2 = 1.0, beta2 = 0.0;
     vbsptr L, U;
     BData *D, *ba;
@@ -634,8 +873,7 @@ int vblusolC( double *y, double *x, vbiluptr lu)
             icol = ja[j];
             sz = B_DIM(bsz,icol);
             data = ba[j];
-            DGEMV( "n",  dim,  sz,  alpha, data, dim, x+bsz[icol],
-		   inc, beta, x+nBs, inc ); 
+            bgemv( dim, sz, alpha, data, x+bsz[icol], beta, x+nBs );
         }
     }
     /* Block -- U solve */
@@ -649,15 +887,13 @@ int vblusolC( double *y, double *x, vbiluptr lu)
             icol = ja[j];
             sz = B_DIM(bsz,icol);
             data = ba[j];
-            DGEMV( "n", dim, sz, alpha, data, dim, x+bsz[icol], inc,
-		   beta, x+nBs, inc ); 
+            bgemv( dim, sz, alpha, data, x+bsz[icol], beta, x+nBs );
         }
         data = D[i];
 	if (OPT == 1) 
 	  luinv( dim, data, x+nBs, lu->bf );
 	else
-	  DGEMV( "n", dim, dim, alpha2, data, dim, x+nBs, inc, beta2,
-		 lu->bf, inc ); 
+	  bgemv( dim, dim, alpha2, data, x+nBs, beta2, lu->bf );
 	
         for( bi = 0; bi < dim; bi++ ) {
             x[nBs+bi] = lu->bf[bi];
@@ -691,23 +927,28 @@ int rpermC(csptr mat, int *perm)
 |             1   --> memory allocation error.
 |---------------------------------------------------------------------*/
    int **addj, *nnz, i, size=mat->n;
+   nnzint *addi;
    double **addm;
    addj = (int **)Malloc( size*sizeof(int *), "rpermC" );
    addm = (double **) Malloc( size*sizeof(double *), "rpermC" );
    nnz = (int *) Malloc( size*sizeof(int), "rpermC" );
+   addi = (nnzint *) Malloc( size*sizeof(nnzint), "rpermC" );
    for (i=0; i<size; i++) {
       addj[perm[i]] = mat->ja[i];
       addm[perm[i]] = mat->ma[i];
       nnz[perm[i]] = mat->nzcount[i];
+      addi[perm[i]] = mat->ia[i];
    }
    for (i=0; i<size; i++) {
       mat->ja[i] = addj[i];
       mat->ma[i] = addm[i];
       mat->nzcount[i] = nnz[i];
+      mat->ia[i] = addi[i];
    }
    free(addj);
    free(addm);
    free(nnz);
+   free(addi);
    return 0;
 }
 
@@ -817,12 +1058,9 @@ int CSparTran( csptr amat, csptr bmat, CompressType *compress )
    }
 
 /*--------------------  allocate space  */
+   csReserve(bmat, nnz_cs(bmat));
    for (i=0; i<size; i++) {
-      if( ind[i] == 0 ) {
-        bmat->ja[i] = NULL;
-        continue;
-      }
-      bmat->ja[i] = (int *)Malloc( ind[i]*sizeof(int), "CSparTran" );
+      csAllocRow(bmat, i, ind[i]);
       ind[i] = 0; /* indicate next available position of each row */
    }
 /*--------------------  now do the actual copying  */
@@ -920,15 +1158,16 @@ void matvecC(csptr mat, double *x, double *y )
 | y     = the product A * x
 |--------------------------------------------------------------------*/
 /*   local variables    */
-  int n = mat->n, i, k, *ki;
-  double *kr;
+  int n = mat->n, i, *ja = mat->jall;
+  nnzint k, k1, *ia = mat->ia;
+  double *ma = mat->mall, t;
   for (i=0; i<n; i++)
     y[i] = 0.0;
   for (i=0; i<n; i++) {
-    kr = mat->ma[i];
-    ki = mat->ja[i];
-    for (k=0; k<mat->nzcount[i]; k++)
-      y[ki[k]] += kr[k] * x[i];
+    t = x[i];
+    k1 = ia[i] + mat->nzcount[i];
+    for (k=ia[i]; k<k1; k++)
+      y[ja[k]] += ma[k] * t;
   }
   return;
 }
@@ -936,7 +1175,7 @@ void matvecC(csptr mat, double *x, double *y )
 void matvecCSR(SMatptr mat, double *x, double *y)
 {
   /*-------------------- matvec for csr format using the SMatptr struct*/
-  matvec(mat->CS, x, y )  ;
+  matvec_omp(mat->CS, x, y, mat->nthreads, mat->part)  ;
 }
 
 void matvecCSC(SMatptr mat, double *x, double *y)
@@ -948,7 +1187,7 @@ void matvecCSC(SMatptr mat, double *x, double *y)
 void matvecVBR(SMatptr mat, double *x, double *y)
 {
   /*-------------------- matvec for vbr format using the SMat struct*/
-  vbmatvec(mat->VBCSR, x, y )  ;
+  vbmatvec_omp(mat->VBCSR, x, y, mat->nthreads, mat->part)  ;
 }
 
 /* for iluc -- now removed. 
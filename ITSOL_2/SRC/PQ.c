@@ -152,7 +152,8 @@ int add2com(int *nback, int nod, int *iord, int *riord)
 /*---------------------------------------------------------------------
 |---- end of add2com --------------------------------------------------
 |--------------------------------------------------------------------*/
-int indsetC(csptr mat, int bsize, int *iord, int *nnod, double tol) 
+int indsetC(csptr mat, int bsize, int *iord, int *nnod, double tol,
+	    int *bnd, int *nbnd) 
 {
 /*--------------------------------------------------------------------- 
 | greedy algorithm for independent set ordering -- 
@@ -177,6 +178,14 @@ int indsetC(csptr mat, int bsize, int *iord, int *nnod, double tol)
 |     permuted matrix.
 |     
 |     nnod   = (output) number of elements in the independent set. 
+|
+|     bnd    = (output) boundaries of the blocks of the independent set
+|     in the permuted ordering. Block k consists of the rows bnd[k] to 
+|     bnd[k+1]-1 and is not coupled to the other blocks, so B is block
+|     diagonal. bnd must have room for nnod+1 <= n+1 entries. Not
+|     referenced if NULL.
+|
+|     nbnd   = (output) number of blocks.
 |     
 |----------------------------------------------------------------------- 
 |     the algorithm searches nodes in lexicographic order and groups
@@ -204,6 +213,7 @@ int indsetC(csptr mat, int bsize, int *iord, int *nnod, double tol)
 +----------------------------------------------------------------------*/
    nback = n-1; 
    nod = 0;
+   *nbnd = 0;
    for(j=0; j<n; j++)
      iord[j] = -1; 
    for(j=0; j<n; j++) {
@@ -219,6 +229,7 @@ int indsetC(csptr mat, int bsize, int *iord, int *nnod, double tol)
      }
 /*-------------------- initialize level-set - contains nod (only)*/
      add2is(&last, nod, iord, riord);
+     if (bnd) bnd[(*nbnd)++] = last;
      begin   = last;
      begin0  = begin; 
      lastlev = begin;
@@ -298,6 +309,7 @@ label50:
    for (j=0; j<n; j++)
      iord[riord[j]] = j;
    (*nnod)++;
+   if (bnd) bnd[*nbnd] = *nnod;
    cleanCS(matT); 
    free(riord);
    free(w);
@@ -159,7 +159,7 @@ int arms2(csptr Amat, int *ipar, double *droptol, int *lfil,
 /*--------------------  local variables  (not initialized)   */
    int nA, nB, nC, j, n, ilev, symperm;
 /*--------------------    work arrays:    */
-   int *iwork, *uwork; 
+   int *iwork, *uwork, *bnd, nbnd; 
 /*   timer arrays:  */ 
 /*   double *symtime, *unstime, *factime, *tottime;*/
 /*---------------------------BEGIN ARMS-------------------------------*/
@@ -227,10 +227,14 @@ int arms2(csptr Amat, int *ipar, double *droptol, int *lfil,
 +--------------------------------------------------------------------*/
 /* if (SHIFTTOL > 0.0) shiftsD(schur,SHIFTTOL);    */
 //     printf("  ipar1 = %d \n", ipar[1]);
+     bnd = NULL;
+     nbnd = 0;
      if (ipar[1] == 1) 
        PQperm(schur, bsize, uwork, iwork, &nB, tolind) ; 
-     else
-       indsetC (schur, bsize, iwork, &nB, tolind) ; 
+     else {
+       bnd = (int *) Malloc((nA+1)*sizeof(int), "arms2:2.6" );
+       indsetC (schur, bsize, iwork, &nB, tolind, bnd, &nbnd) ; 
+     }
 /*---------------------------------------------------------------------
 | nB is the total number of nodes in the independent set.
 | nC : nA - nB = the size of the reduced system.
@@ -238,7 +242,10 @@ int arms2(csptr Amat, int *ipar, double *droptol, int *lfil,
      nC = nA - nB;
 /*   if the size of B or C is zero , exit the main loop  */
 /*   printf ("  nB %d nC %d \n",nB, nC); */
-     if ( nB == 0 || nC == 0 )  goto label1000; 
+     if ( nB == 0 || nC == 0 ) {
+       if (bnd) free(bnd);
+       goto label1000; 
+     }
 /*---------------------------------------------------------------------
 | The matrix for the current level is in (schur).
 | The permutations arrays are in iwork and uwork (row).
@@ -276,6 +283,11 @@ int arms2(csptr Amat, int *ipar, double *droptol, int *lfil,
       levc->symperm = symperm;
       levc->D1=dd1;
       levc->D2=dd2; 
+      levc->nthreads = PreMat->nthreads;
+      if (bnd) {
+	levc->nbnd = nbnd;
+	levc->bnd = (int *) Realloc(bnd, (nbnd+1)*sizeof(int), "arms2:6.5" );
+      }
 /*---------------------------------------------------------------------
 | a copy of the matrix (schur) has been permuted. Now perform the 
 | block factorization: 
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string.h> 
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "globheads.h"
 #include "protos.h"
 #include "ios.h"
@@ -115,7 +118,7 @@ int read_inputs( char *in_file, io_t *pio )
 
 /*-----------------------------------------------*/
 int get_matrix_info( FILE *fmat, io_t *pio ){
-  char path[MAX_LINE],  MatNam[MaxNamLen], Fmt[4];
+  char path[MAX_LINE],  MatNam[MaxNamLen], Fmt[8];
   int count;
 /*-------------------- READ LINE */
   fscanf(fmat,"%s %s %s\n",path,MatNam,Fmt); 
@@ -137,6 +140,9 @@ int get_matrix_info( FILE *fmat, io_t *pio ){
       if (strcmp(Fmt,"MM1")==0) 
         pio->Fmt = MM1;
       else 
+        if (strcmp(Fmt,"CSRB")==0) 
+          pio->Fmt = CSRB;
+        else 
 /*-------------------- UNKNOWN_FORMAT */
   return(ERR_AUXIL+2); 
 /* debug  printf(" Echo: %s %s %s \n", pio->Fname, pio->MatNam, Fmt); */
@@ -176,65 +182,39 @@ int read_coo(double **VAL, int **COL, int **ROW, io_t *pio,
 !  various other things are filled in pio  
 ! job = 0  - want C indexing 
 ! job = 1  - want FORTRAN indexing 
+!  the file is parsed by readmm: Matrix Market files (MM1) with or
+!  without banner, symmetric and pattern included, or 0-based (MM0)
 !------------------------------------------------------------*/
-  FILE *matf = NULL;
   double *aa;
   int *ii, *jj;
-  int k, n, nnz;
-  char str[MAX_LINE];
+  int k, n, m, nnz, ierr, nthreads = 1;
 /*-------------------- start */
-  if ((matf = fopen(pio->Fname,"r")) == NULL) {
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  ierr = readmm(pio->Fname, pio->Fmt == MM0 ? 0 : 1, job, nthreads,
+		&n, &m, &nnz, &aa, &ii, &jj);
+  if (ierr == 1) {
     fprintf(stdout, "Cannot Open Matrix\n");
     return(ERR_AUXIL+3);
   }
-/*-------------------- mtx format .. in some cases n, 
-                       nnz are read separately per line */
-/*-------------------- try a 100 lines max of comments */
-  for (k=0; k<100; k++){
-    fgets(str,MAX_LINE,matf);
-    if (memcmp(str,"%",sizeof(char)) !=0)
-      break; 
+  if (ierr) {
+    fprintf(stdout, "Error %d reading %s\n", ierr, pio->Fname);
+    return(ERR_AUXIL+3);
   }
-  if (k==99) 
-    return(ERR_AUXIL+3); 
-  sscanf(str," %d %d %d", &n, &k, &nnz); 
-  if (n != k) {
+  if (n != m) {
     fprintf(stdout,"This is not a square matrix -- stopping \n");
+    free(aa); free(ii); free(jj);
     return(ERR_AUXIL+4); 
-    } 
-  /* separate reads for n and nnz 
-     fscanf(matf," %d", &n); 
-     fscanf(matf," %d", &nnz);  
-  */
+  } 
   pio->ndim = n; 
   pio->nnz  = nnz;
-/*-------------------- allocate memory for matrix and rhs --- */
+  *ROW = ii;
+  *COL = jj;
+  *VAL = aa;
+/*-------------------- allocate memory for rhs --- */
   *rhs = (double *)Malloc( n*sizeof(double), "read_coo:1" );
   *sol = (double *)Malloc( n*sizeof(double), "read_coo:2" );
-   aa  = (double *)Malloc( nnz*sizeof(double),"read_coo:3" );
-   jj  = (int *)Malloc( nnz*sizeof(int), "read_coo:4" );
-   ii  = (int *)Malloc( nnz*sizeof(int), "read_coo:5" );
-/*-------------------- long live fortran77 --- */
-   for (k=0; k<nnz; k++) {
-     fscanf(matf,"%d  %d  %s", &ii[k],&jj[k],str) ;
-     aa[k] = atof(str);
-   }
-/*------- adjust for cases when indices start at one */
-   if (pio->Fmt == MM1 && job==0) {
-     for (k=0; k<nnz; k++){
-       ii[k]--;
-       jj[k]--;
-     }
-   }
-   if (pio->Fmt == MM0 && job==1) {
-     for (k=0; k<nnz; k++){
-       ii[k]++;
-       jj[k]++;
-     }
-   }
-   *ROW = ii;
-   *COL = jj;
-   *VAL = aa;
 /*-------------------- TO UPDATE 
   if rhs and sols are available load them -- otherwise
   generate artificial ones. */
@@ -243,9 +223,36 @@ int read_coo(double **VAL, int **COL, int **ROW, io_t *pio,
     (*rhs)[k] = 0.0;
   }
   for (k=0; k<nnz; k++)
-    (*rhs)[ii[k]] += aa[k] * (*sol)[jj[k]];
+    (*rhs)[ii[k]-job] += aa[k] * (*sol)[jj[k]-job];
 
-  fclose(matf);
+  return(0); 
+}
+
+
+int read_csrb(io_t *pio, csptr mat, double **rhs, double **sol)
+{
+/*-------------------- loads a matrix from a binary .csrb file 
+!  (written by writecsrb or by the mex layer) into mat.
+!  for rhs: memory allocation done + artificial rhs created.
+!  various other things are filled in pio  
+!------------------------------------------------------------*/
+  int i, k, n, ierr;
+  if ((ierr = readcsrb(pio->Fname, mat)) != 0) {
+    fprintf(stdout, "Error %d reading %s\n", ierr, pio->Fname);
+    return(ERR_AUXIL+8);
+  }
+  n = mat->n;
+  pio->ndim = n;
+  pio->nnz  = nnz_cs(mat);
+  *rhs = (double *)Malloc( n*sizeof(double), "read_csrb:1" );
+  *sol = (double *)Malloc( n*sizeof(double), "read_csrb:2" );
+  for (k=0; k<n; k++)
+    (*sol)[k]= 1.0;
+  for (i=0; i<n; i++) {
+    (*rhs)[i] = 0.0;
+    for (k=0; k<mat->nzcount[i]; k++)
+      (*rhs)[i] += mat->ma[i][k] * (*sol)[mat->ja[i][k]];
+  }
   return(0); 
 }
 
@@ -416,6 +423,63 @@ int readhb_2(int *NN, double **AA, int **JA, int **IA,
     return 0;
 }
 
+int read_matrix(io_t *pio, csptr mat, double **rhs, double **sol,
+		int *rsa, int job)
+{
+/*-------------------- reads the matrix described by pio into mat,
+!  from a binary .csrb file, a COO file (MM0, MM1) or a
+!  Harwell-Boeing file, according to pio->Fmt.
+!  for rhs: memory allocation done + artificial rhs created.
+!  various other things are filled in pio  
+! job = 0  - mat in compressed rows (CSR)
+! job = 1  - mat in compressed columns (CSC)
+! rsa      = 1 for a symmetric HB matrix, 0 otherwise
+!------------------------------------------------------------*/
+  double *AA = NULL;
+  int *JA = NULL, *IA = NULL;
+  int n, ierr = 0;
+  csptr tmp;
+  *rsa = 0;
+  if (pio->Fmt == CSRB) {
+    if (job == 0)
+      return read_csrb(pio, mat, rhs, sol);
+/*-------------------- .csrb files hold rows -- transpose */
+    tmp = (csptr)Malloc( sizeof(SparMat), "read_matrix" );
+    if ((ierr = read_csrb(pio, tmp, rhs, sol)) == 0) {
+      setupCS(mat, tmp->n, 1);
+      ierr = SparTran(tmp, mat, 1, 0);
+      cleanCS(tmp);
+    } else
+      free(tmp);
+  }
+  else if (pio->Fmt > HB) {
+    if ((ierr = read_coo(&AA, &JA, &IA, pio, rhs, sol, 0)) != 0)
+      return ierr;
+/*-------------------- rows and columns are swapped for CSC */
+    if (job == 0)
+      ierr = COOcs(pio->ndim, pio->nnz, AA, JA, IA, mat);
+    else
+      ierr = COOcs(pio->ndim, pio->nnz, AA, IA, JA, mat);
+  }
+  else if (pio->Fmt == HB) {
+    if (job == 0)
+      ierr = readhb_c(&n, &AA, &JA, &IA, pio, rhs, sol, rsa);
+    else
+      ierr = readhb_2(&n, &AA, &JA, &IA, pio, rhs, sol, rsa, 0);
+    if (ierr != 0)
+      return ierr;
+    ierr = CSRcs(n, AA, JA, IA, mat, *rsa);
+  }
+  else {
+    fprintf(stdout, "Unknown format of %s\n", pio->Fname);
+    return(ERR_AUXIL+9);
+  }
+  free(AA);
+  free(JA);
+  free(IA);
+  return ierr;
+}
+
 void output_header( io_t *pio )
 {
     FILE *f = pio->fout;
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "globheads.h"
+#include "protos.h"
+
+/*---------------------------------------------------------------------
+| Dense kernels on the blocks of VBSpaFmt matrices and VBILU factors.
+| The blocks are stored column-wise with a leading dimension equal to
+| their number of rows (see DATA in globheads.h).
+|
+| The blocks of most block matrices are small (2 to 6 unknowns per
+| node) and a BLAS call costs more than its arithmetic there. The
+| kernels below are written once as inline functions of the block
+| sizes and instantiated for the square sizes 1 to BLK_UNROLL, where
+| the compiler unrolls them completely and vectorizes the column
+| updates. Other blocks up to BLK_SMALL rows and columns use the same
+| loops with variable bounds, and only larger blocks call the BLAS.
+|--------------------------------------------------------------------*/
+
+#ifndef BLK_UNROLL
+#define BLK_UNROLL 6
+#endif
+#ifndef BLK_SMALL
+#define BLK_SMALL 16
+#endif
+
+#ifdef __GNUC__
+#define BLK_INLINE static inline __attribute__((always_inline))
+#else
+#define BLK_INLINE static inline
+#endif
+
+BLK_INLINE void gemv_core(int m, int n, double alpha, const double *a,
+			  const double *x, double beta, double *y)
+{
+/*-------------------- y = alpha*a*x + beta*y, m <= BLK_SMALL */
+  double t[BLK_SMALL], xj;
+  int i, j;
+  for (i=0; i<m; i++) t[i] = 0.0;
+  for (j=0; j<n; j++) {
+    xj = x[j];
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+    for (i=0; i<m; i++)
+      t[i] += a[j*m+i] * xj;
+  }
+  if (beta == 0.0)
+    for (i=0; i<m; i++) y[i] = alpha * t[i];
+  else
+    for (i=0; i<m; i++) y[i] = beta * y[i] + alpha * t[i];
+}
+
+BLK_INLINE void gemm_core(int m, int n, int k, double alpha,
+			  const double *a, const double *b, double beta,
+			  double *c)
+{
+/*-------------------- c = alpha*a*b + beta*c column by column */
+  int j;
+  for (j=0; j<n; j++)
+    gemv_core(m, k, alpha, a, b+j*k, beta, c+j*m);
+}
+
+BLK_INLINE void luinv_core(int n, const double *a, const double *x,
+			   double *y)
+{
+/*-------------------- y = inv(a)*x for a factored by Gauss */
+  int i, j;
+  double sum;
+  for (i=0; i<n; i++) {
+    sum = x[i];
+    for (j=0; j<i; j++)
+      sum -= a[j*n+i] * y[j];		/* a(i,j) * y(j) */
+    y[i] = sum;
+  }
+  for (i=n-1; i>=0; i--) {
+    sum = y[i];
+    for (j=i+1; j<n; j++)
+      sum -= a[j*n+i] * y[j];		/* a(i,j) * y(j) */
+    y[i] = sum * a[i*n+i];		/* a(i,i) */
+  }
+}
+
+/*-------------------- fixed size instances for the square blocks */
+#define BLK_INSTANCES(N)						\
+static void gemv_##N(double alpha, const double *a, const double *x,	\
+		     double beta, double *y)				\
+{ gemv_core(N, N, alpha, a, x, beta, y); }				\
+static void gemm_##N(int n, double alpha, const double *a,		\
+		     const double *b, double beta, double *c)		\
+{ gemm_core(N, n, N, alpha, a, b, beta, c); }				\
+static void luinv_##N(const double *a, const double *x, double *y)	\
+{ luinv_core(N, a, x, y); }
+
+BLK_INSTANCES(1)
+BLK_INSTANCES(2)
+BLK_INSTANCES(3)
+BLK_INSTANCES(4)
+BLK_INSTANCES(5)
+BLK_INSTANCES(6)
+
+void bgemv(int m, int n, double alpha, BData a, double *x, double beta,
+	   double *y)
+{
+/*----------------------------------------------------------------------
+| y = alpha * a * x + beta * y, for an m x n block a. As with DGEMV, y
+| is not read when beta is zero. x and y must not overlap.
+|--------------------------------------------------------------------*/
+  int inc = 1;
+  if (m == n && m <= BLK_UNROLL) {
+    switch (m) {
+    case 1: gemv_1(alpha, a, x, beta, y); return;
+    case 2: gemv_2(alpha, a, x, beta, y); return;
+    case 3: gemv_3(alpha, a, x, beta, y); return;
+    case 4: gemv_4(alpha, a, x, beta, y); return;
+    case 5: gemv_5(alpha, a, x, beta, y); return;
+    case 6: gemv_6(alpha, a, x, beta, y); return;
+    }
+  }
+  if (m <= BLK_SMALL && n <= BLK_SMALL) {
+    gemv_core(m, n, alpha, a, x, beta, y);
+    return;
+  }
+  if (m <= 0) return;
+  DGEMV("n", m, n, alpha, a, m, x, inc, beta, y, inc);
+}
+/*---------------------------------------------------------------------
+|     end of bgemv
+|--------------------------------------------------------------------*/
+
+void bgemm(int m, int n, int k, double alpha, BData a, BData b,
+	   double beta, BData c)
+{
+/*----------------------------------------------------------------------
+| c = alpha * a * b + beta * c, for an m x k block a and a k x n block
+| b. As with DGEMM, c is not read when beta is zero. c must not
+| overlap a or b.
+|--------------------------------------------------------------------*/
+  if (m == k && m <= BLK_UNROLL) {
+    switch (m) {
+    case 1: gemm_1(n, alpha, a, b, beta, c); return;
+    case 2: gemm_2(n, alpha, a, b, beta, c); return;
+    case 3: gemm_3(n, alpha, a, b, beta, c); return;
+    case 4: gemm_4(n, alpha, a, b, beta, c); return;
+    case 5: gemm_5(n, alpha, a, b, beta, c); return;
+    case 6: gemm_6(n, alpha, a, b, beta, c); return;
+    }
+  }
+  if (m <= BLK_SMALL && k <= BLK_SMALL) {
+    gemm_core(m, n, k, alpha, a, b, beta, c);
+    return;
+  }
+  if (m <= 0 || n <= 0) return;
+  DGEMM("n", "n", m, n, k, alpha, a, m, b, k, beta, c, m);
+}
+/*---------------------------------------------------------------------
+|     end of bgemm
+|--------------------------------------------------------------------*/
+
+void luinv( int n, double *a, double *x, double *y )
+{
+/*--------------------------------------------------------
+ *    does the operation y = inv(a) * x
+ *    where a has already been factored by Gauss.
+ *    LUy = x
+ *------------------------------------------------------*/
+  switch (n) {
+  case 1: luinv_1(a, x, y); return;
+  case 2: luinv_2(a, x, y); return;
+  case 3: luinv_3(a, x, y); return;
+  case 4: luinv_4(a, x, y); return;
+  case 5: luinv_5(a, x, y); return;
+  case 6: luinv_6(a, x, y); return;
+  }
+  luinv_core(n, a, x, y);
+}
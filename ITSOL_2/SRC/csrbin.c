@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "globheads.h"
+#include "protos.h"
+#include "csrbin.h"
+
+int readcsrb(char *fname, csptr mat)
+{
+/*----------------------------------------------------------------------
+| Load a square real matrix from a binary .csrb file (see csrbin.h)
+|----------------------------------------------------------------------
+| on entry:
+|==========
+| fname    = name of the file.
+|
+| On return:
+|===========
+| ( mat )  =  Matrix stored as SpaFmt struct. (C indexing)
+|             A CSR file with 4-byte indices is copied straight into
+|             the arenas; a CSC file (as written by the mex layer) is
+|             transposed on the fly.
+|
+|       integer value returned:
+|             0   --> successful return.
+|             1-4 --> error of csrb_open (open, format, size,
+|                     checksum).
+|             5   --> complex or rectangular matrix.
+|             6   --> sizes too large or inconsistent offsets and
+|                     indices.
+|--------------------------------------------------------------------*/
+  CsrbMap m;
+  CsrbHead *h;
+  int64_t n, nnz, k, k1, k2, j;
+  nnzint *next;
+  int i, ierr, w;
+
+  if ((ierr = csrb_open(fname, &m, 1)) != 0) return ierr;
+  h = m.h;
+  n = h->nrow;
+  nnz = h->nnz;
+  w = h->idxw;
+  if ((h->flags & CSRB_COMPLEX) || h->nrow != h->ncol) {
+    csrb_close(&m);
+    return 5;
+  }
+  if (n > INT_MAX || (sizeof(nnzint) == 4 && nnz > INT_MAX) ||
+      csrb_get(m.ptr, w, 0) != 0 || csrb_get(m.ptr, w, n) != nnz) {
+    csrb_close(&m);
+    return 6;
+  }
+  setupCS(mat, (int)n, 1);
+  csReserve(mat, (nnzint)nnz);
+  mat->nnzall = (nnzint)nnz;
+  ierr = 0;
+  if (!(h->flags & CSRB_CSC)) {
+/*-------------------- rows as stored */
+    for (i=0; i<n; i++) {
+      k1 = csrb_get(m.ptr, w, i);
+      k2 = csrb_get(m.ptr, w, i+1);
+      if (k2 < k1 || k2 > nnz) {
+	ierr = 6;
+	k2 = k1;
+      }
+      mat->ia[i] = (nnzint)k1;
+      mat->nzcount[i] = (int)(k2-k1);
+      mat->ja[i] = mat->jall + k1;
+      mat->ma[i] = mat->mall + k1;
+    }
+    if (w == 4)
+      memcpy(mat->jall, m.ind, (size_t)nnz*sizeof(int));
+    else
+      for (k=0; k<nnz; k++)
+	mat->jall[k] = (int)csrb_get(m.ind, w, k);
+    for (k=0; k<nnz; k++)
+      if (mat->jall[k] < 0 || mat->jall[k] >= n) ierr = 6;
+    memcpy(mat->mall, m.val, (size_t)nnz*sizeof(double));
+  } else {
+/*-------------------- transpose the columns into rows */
+    for (i=0; i<n; i++) mat->nzcount[i] = 0;
+    for (k=0; k<nnz; k++) {
+      j = csrb_get(m.ind, w, k);
+      if (j < 0 || j >= n) {
+	ierr = 6;
+	break;
+      }
+      mat->nzcount[j]++;
+    }
+    for (j=0; j<n && ierr==0; j++) {
+      k1 = csrb_get(m.ptr, w, j);
+      k2 = csrb_get(m.ptr, w, j+1);
+      if (k2 < k1 || k2 > nnz) ierr = 6;
+    }
+    if (ierr == 0) {
+      next = (nnzint *)Malloc(n*sizeof(nnzint), "readcsrb");
+      k1 = 0;
+      for (i=0; i<n; i++) {
+	mat->ia[i] = next[i] = (nnzint)k1;
+	mat->ja[i] = mat->jall + k1;
+	mat->ma[i] = mat->mall + k1;
+	k1 += mat->nzcount[i];
+      }
+      for (j=0; j<n; j++) {
+	k2 = csrb_get(m.ptr, w, j+1);
+	for (k=csrb_get(m.ptr, w, j); k<k2; k++) {
+	  i = (int)csrb_get(m.ind, w, k);
+	  mat->jall[next[i]] = (int)j;
+	  mat->mall[next[i]++] = m.val[k];
+	}
+      }
+      free(next);
+    }
+  }
+  csrb_close(&m);
+  if (ierr) {
+/*-------------------- release the arrays but not mat itself */
+    free(mat->ma);
+    free(mat->ja);
+    free(mat->nzcount);
+    free(mat->ia);
+    free(mat->jall);
+    free(mat->mall);
+  }
+  return ierr;
+}
+/*---------------------------------------------------------------------
+|     end of readcsrb
+|--------------------------------------------------------------------*/
+
+int writecsrb(char *fname, csptr mat)
+{
+/*----------------------------------------------------------------------
+| Save a SpaFmt matrix to a binary .csrb file (see csrbin.h)
+|----------------------------------------------------------------------
+| on entry:
+|==========
+| fname    = name of the file.
+| ( mat )  = Matrix stored as SpaFmt struct.
+|
+| The rows are written in CSR with 4-byte offsets and indices, or
+| 8-byte ones when the number of entries does not fit in an int.
+|
+|       integer value returned:
+|             0   --> successful return.
+|             1   --> the file cannot be created or written.
+|--------------------------------------------------------------------*/
+  CsrbHead h;
+  CsrbMap m;
+  int64_t nnz = 0;
+  int i, k, len;
+
+  for (i=0; i<mat->n; i++) nnz += mat->nzcount[i];
+  memset(&h, 0, sizeof(h));
+  h.idxw = nnz > INT_MAX ? 8 : 4;
+  h.flags = 0;
+  h.nrow = h.ncol = mat->n;
+  h.nnz = nnz;
+  if (csrb_create(fname, &h, &m)) return 1;
+  nnz = 0;
+  for (i=0; i<mat->n; i++) {
+    len = mat->nzcount[i];
+    csrb_set(m.ptr, h.idxw, i, nnz);
+    if (h.idxw == 4)
+      memcpy((int32_t *)m.ind + nnz, mat->ja[i], len*sizeof(int));
+    else
+      for (k=0; k<len; k++)
+	csrb_set(m.ind, h.idxw, nnz+k, mat->ja[i][k]);
+    memcpy(m.val + nnz, mat->ma[i], len*sizeof(double));
+    nnz += len;
+  }
+  csrb_set(m.ptr, h.idxw, mat->n, nnz);
+  return csrb_close(&m);
+}
+/*---------------------------------------------------------------------
+|     end of writecsrb
+|--------------------------------------------------------------------*/
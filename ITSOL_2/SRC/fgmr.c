@@ -51,12 +51,13 @@ int fgmr(SMatptr Amat, SPreptr lu, double *rhs, double *sol,
 |     preconditionning operation 
 +---------------------------------------------------------------------*/
   int n=Amat->n, maxits = *itmax; 
-  int i, i1, ii, j, k, k1, its, im1, pti, pti1, ptih=0, retval, one = 1;
+  int i, i1, ii, j, k, k1, its, im1, ptih=0, retval, one = 1;
+  size_t pti, pti1;   /* offsets of v_i, v_{i+1} in vv, may exceed 2^31 */
   double *hh, *c, *s, *rs, t;
   double negt, beta, eps1=0, gam, *vv, *z; 
   im1 = im+1;
-  vv = (double *)Malloc(im1*n*sizeof(double), "fgmres:vv");
-  z  = (double *)Malloc(im*n*sizeof(double), "fgmres:z");
+  vv = (double *)Malloc((size_t)im1*n*sizeof(double), "fgmres:vv");
+  z  = (double *)Malloc((size_t)im*n*sizeof(double), "fgmres:z");
   im1 = im+1;
   hh = (double *)Malloc((im1*(im+3))*sizeof(double), "fgmres:hh");
   c  = hh+im1*im ; s  = c+im1;  rs = s+im1;
@@ -89,8 +90,8 @@ int fgmr(SMatptr Amat, SPreptr lu, double *rhs, double *sol,
     while((i < im-1) && (beta > eps1) && (its++ < maxits))  {
       i++;
       i1   = i+1; 
-      pti  = i*n;
-      pti1 = i1*n;
+      pti  = (size_t)i*n;
+      pti1 = (size_t)i1*n;
 /*------------------------------------------------------------
 |  (Right) Preconditioning Operation   z_{j} = M^{-1} v_{j}
 +-----------------------------------------------------------*/
@@ -106,10 +107,10 @@ int fgmr(SMatptr Amat, SPreptr lu, double *rhs, double *sol,
 +------------------------------------------------------------*/
       ptih=i*im1;
       for (j=0; j<=i; j++) {
-	t = DDOT(n, &vv[j*n], one, &vv[pti1], one);
+	t = DDOT(n, &vv[(size_t)j*n], one, &vv[pti1], one);
 	hh[ptih+j] = t;
 	negt = -t;
-	DAXPY(n, negt, &vv[j*n], one, &vv[pti1], one);
+	DAXPY(n, negt, &vv[(size_t)j*n], one, &vv[pti1], one);
       }
 /*-------------------- h_{j+1,j} = ||w||_{2}    */
       t = DNRM2(n, &vv[pti1], one);
@@ -155,7 +156,7 @@ int fgmr(SMatptr Amat, SPreptr lu, double *rhs, double *sol,
     }
 /*---------- linear combination of z_j's to get sol. */
     for (j=0; j<= i; j++) 
-      DAXPY(n, rs[j], &z[j*n], one, sol, one);
+      DAXPY(n, rs[j], &z[(size_t)j*n], one, sol, one);
 /*--------------------  restart outer loop if needed */
     if (beta < eps1) 
       break;
@@ -13,7 +13,9 @@
 #endif
 
 /*--------------------protos */
-int lofC( int lofM, csptr csmat, iluptr lu, FILE *fp ); 
+static int lofC( int lofM, csptr csmat, csptr L, csptr U, int *iw );
+static int iluk_row( int i, csptr csmat, csptr L, csptr U, double *D,
+		     int *jw );
 /*--------------------end protos */
 
 int ilukC( int lofM, csptr csmat, iluptr lu, FILE *fp )
@@ -47,109 +49,229 @@ int ilukC( int lofM, csptr csmat, iluptr lu, FILE *fp )
  *----------------------------------------------------------------------------
  * Notes:
  * ======
- * All the diagonals of the input matrix must not be zero
+ * All the diagonals of the input matrix must not be zero.
+ * This is ilukSymbolic followed by one serial ilukNumeric; call those
+ * directly to refactor matrices with the same pattern.
  *--------------------------------------------------------------------------*/
     int ierr;
+    iluksptr sym;
+
+    sym = (iluksptr)Malloc( sizeof(ILUKSym), "ilukC" );
+    if( ilukSymbolic( lofM, csmat, sym, fp ) != 0 ) {
+      cleanILUKSym( sym );
+      return -1;
+    }
+    setupILUK( lu, sym );
+    ierr = ilukNumeric( csmat, sym, lu, 1, fp );
+    cleanILUKSym( sym );
+    return ierr;
+}
+
+int ilukSymbolic( int lofM, csptr csmat, iluksptr sym, FILE *fp )
+{
+/*----------------------------------------------------------------------------
+ * symbolic phase of ILUK: patterns of the factors and schedule of the
+ * numeric phase
+ *----------------------------------------------------------------------------
+ * on entry:
+ * =========
+ * lofM     = level of fill, lofM >= 0
+ * csmat    = matrix stored in SpaFmt format, only its pattern is used
+ * sym      = pointer to a ILUKSym struct
+ * fp       = file pointer for error log ( might be stderr )
+ *
+ * on return:
+ * ==========
+ * ierr     = return value.
+ *            ierr  = 0   --> successful return.
+ *            ierr  = -1  --> error in lofC
+ * sym->n   = dimension of the matrix
+ *    ->L   = pattern of the L part -- SpaFmt format, no values
+ *    ->U   = pattern of the U part -- SpaFmt format, no values
+ *    ->nlev, ilev, lrow = rows grouped by level: row i depends only on
+ *            the rows L->ja[i], so the rows lrow[ilev[l]:ilev[l+1]-1]
+ *            of level l can be factored concurrently once the levels
+ *            before l are done.
+ *--------------------------------------------------------------------------*/
     int n = csmat->n;
-    int *jw, i, j, k, col, jpos, jrow;
-    csptr L, U;
-    double *D;
+    int *level, *iw;
+    int i, j, l;
 
-    setupILU( lu, n );
-    L = lu->L;
-    U = lu->U;
-    D = lu->D;
+    sym->n = n;
+    sym->L = (csptr)Malloc( sizeof(SparMat), "ilukSymbolic" );
+    setupCS( sym->L, n, 0 );
+    sym->U = (csptr)Malloc( sizeof(SparMat), "ilukSymbolic" );
+    setupCS( sym->U, n, 0 );
+    sym->nlev = 0;
+    sym->ilev = NULL;
+    sym->lrow = (int *)Malloc( n*sizeof(int), "ilukSymbolic" );
 
-    /* symbolic factorization to calculate level of fill index arrays */
-    if( ( ierr = lofC( lofM, csmat, lu, fp ) ) != 0 ) {
+    iw = (int *)Malloc( n*sizeof(int), "ilukSymbolic" );
+    if( lofC( lofM, csmat, sym->L, sym->U, iw ) != 0 ) {
       fprintf( fp, "Error: lofC\n" );
+      free( iw );
       return -1;
     }
-
-    jw = lu->work;
-    /* set indicator array jw to -1 */
-    for( j = 0; j < n; j++ ) jw[j] = -1;
-
-    /* beginning of main loop */
+/*-------------------- level of each row in the dependency graph of L */
+    level = iw;
     for( i = 0; i < n; i++ ) {
-        /* set up the i-th row accroding to the nonzero information from
-           symbolic factorization */
-        mallocRow( lu, i );
+        l = 0;
+        for( j = 0; j < sym->L->nzcount[i]; j++ )
+            l = max( l, level[sym->L->ja[i][j]]+1 );
+        level[i] = l;
+        sym->nlev = max( sym->nlev, l+1 );
+    }
+/*-------------------- sort the rows by level, stable */
+    sym->ilev = (int *)Malloc( (sym->nlev+1)*sizeof(int), "ilukSymbolic" );
+    for( l = 0; l <= sym->nlev; l++ ) sym->ilev[l] = 0;
+    for( i = 0; i < n; i++ ) sym->ilev[level[i]+1]++;
+    for( l = 0; l < sym->nlev; l++ ) sym->ilev[l+1] += sym->ilev[l];
+    for( i = 0; i < n; i++ ) sym->lrow[sym->ilev[level[i]]++] = i;
+    for( l = sym->nlev; l > 0; l-- ) sym->ilev[l] = sym->ilev[l-1];
+    sym->ilev[0] = 0;
+    free( iw );
+    return 0;
+}
 
-        /* setup array jw[], and initial i-th row */
-        for( j = 0; j < L->nzcount[i]; j++ ) {  /* initialize L part   */
-            col = L->ja[i][j];
-            jw[col] = j;
-            L->ma[i][j] = 0;
-        }
-        jw[i] = i;
-        D[i] = 0; /* initialize diagonal */
-        for( j = 0; j < U->nzcount[i]; j++ ) {  /* initialize U part   */
-            col = U->ja[i][j];
-            jw[col] = j;
-            U->ma[i][j] = 0;
+int ilukNumeric( csptr csmat, iluksptr sym, iluptr lu, int nthreads,
+		 FILE *fp )
+{
+/*----------------------------------------------------------------------------
+ * numeric phase of ILUK: computes the values of the factors in the
+ * pattern of a previous ilukSymbolic
+ *----------------------------------------------------------------------------
+ * on entry:
+ * =========
+ * csmat    = matrix stored in SpaFmt format, with the pattern given to
+ *            ilukSymbolic (or a subset of it)
+ * sym      = result of ilukSymbolic
+ * lu       = pointer to a ILUSpar struct set up by setupILUK( lu, sym ),
+ *            possibly holding the factors of an earlier call
+ * nthreads = number of threads; the rows of each level of sym are
+ *            factored concurrently. The result does not depend on
+ *            nthreads.
+ * fp       = file pointer for error log ( might be stderr )
+ *
+ * on return:
+ * ==========
+ * ierr     = return value.
+ *            ierr  = 0   --> successful return.
+ *            ierr  = -2  --> zero diagonal found
+ * lu->L, lu->D, lu->U = factors, as computed by ilukC
+ *--------------------------------------------------------------------------*/
+    int n = sym->n;
+    int *jw = lu->work, i, j, zero = 0;
+
+#ifdef _OPENMP
+    if( nthreads > 1 && sym->nlev < n ) {
+#pragma omp parallel num_threads(nthreads) private(i, j)
+      {
+        int l, k, *tw;
+        tw = (int *)Malloc( n*sizeof(int), "ilukNumeric" );
+        for( j = 0; j < n; j++ ) tw[j] = -1;
+        for( l = 0; l < sym->nlev; l++ ) {
+#pragma omp for schedule(dynamic, 16)
+          for( k = sym->ilev[l]; k < sym->ilev[l+1]; k++ ) {
+            i = sym->lrow[k];
+            if( iluk_row( i, csmat, lu->L, lu->U, lu->D, tw ) != 0 ) {
+#pragma omp atomic write
+              zero = 1;
+            }
+          }
         }
+        free( tw );
+      }
+    }
+    else
+#endif
+    {
+      /* set indicator array jw to -1 */
+      for( j = 0; j < n; j++ ) jw[j] = -1;
+      for( i = 0; i < n && zero == 0; i++ )
+        zero = iluk_row( i, csmat, lu->L, lu->U, lu->D, jw );
+    }
+    if( zero ) {
+      fprintf( fp, "fatal error: Zero diagonal found...\n" );
+      return -2;
+    }
+    return 0;
+}
 
-        /* copy row from csmat into lu */
-        for( j = 0; j < csmat->nzcount[i]; j++ ) {
-            col = csmat->ja[i][j];
+static int iluk_row( int i, csptr csmat, csptr L, csptr U, double *D,
+		     int *jw )
+{
+/*--------------------------------------------------------------------
+ * factor row i of ILUK in the pattern of L and U, once the rows it
+ * depends on are done. jw is -1 on entry and on return. Returns 0, or
+ * -2 for a zero pivot.
+ *------------------------------------------------------------------*/
+    int j, k, col, jpos, jrow;
+
+    /* setup array jw[], and initial i-th row */
+    for( j = 0; j < L->nzcount[i]; j++ ) {  /* initialize L part   */
+        col = L->ja[i][j];
+        jw[col] = j;
+        L->ma[i][j] = 0;
+    }
+    jw[i] = i;
+    D[i] = 0; /* initialize diagonal */
+    for( j = 0; j < U->nzcount[i]; j++ ) {  /* initialize U part   */
+        col = U->ja[i][j];
+        jw[col] = j;
+        U->ma[i][j] = 0;
+    }
+
+    /* copy row from csmat into lu */
+    for( j = 0; j < csmat->nzcount[i]; j++ ) {
+        col = csmat->ja[i][j];
+        jpos = jw[col];
+        if( col < i )
+            L->ma[i][jpos] = csmat->ma[i][j];
+        else if( col == i )
+            D[i] = csmat->ma[i][j];
+        else
+            U->ma[i][jpos] = csmat->ma[i][j];
+    }
+
+    /* eliminate previous rows */
+    for( j = 0; j < L->nzcount[i]; j++ ) {
+        jrow = L->ja[i][j];
+        /* get the multiplier for row to be eliminated (jrow) */
+        L->ma[i][j] *= D[jrow];
+
+        /* combine current row and row jrow */
+        for( k = 0; k < U->nzcount[jrow]; k++ ) {
+            col = U->ja[jrow][k];
             jpos = jw[col];
+            if( jpos == -1 ) continue;
             if( col < i )
-                L->ma[i][jpos] = csmat->ma[i][j];
+                L->ma[i][jpos] -= L->ma[i][j] * U->ma[jrow][k];
             else if( col == i )
-                D[i] = csmat->ma[i][j];
+                D[i] -= L->ma[i][j] * U->ma[jrow][k];
             else
-                U->ma[i][jpos] = csmat->ma[i][j];
-        }
-
-        /* eliminate previous rows */
-        for( j = 0; j < L->nzcount[i]; j++ ) {
-            jrow = L->ja[i][j];
-            /* get the multiplier for row to be eliminated (jrow) */
-            L->ma[i][j] *= D[jrow];
-
-            /* combine current row and row jrow */
-            for( k = 0; k < U->nzcount[jrow]; k++ ) {
-                col = U->ja[jrow][k];
-                jpos = jw[col];
-                if( jpos == -1 ) continue;
-                if( col < i )
-                    L->ma[i][jpos] -= L->ma[i][j] * U->ma[jrow][k];
-                else if( col == i )
-                    D[i] -= L->ma[i][j] * U->ma[jrow][k];
-                else
-                    U->ma[i][jpos] -= L->ma[i][j] * U->ma[jrow][k];
-            }
-        }
-
-        /* reset double-pointer to -1 ( U-part) */
-        for( j = 0; j < L->nzcount[i]; j++ )
-        {
-            col = L->ja[i][j];
-            jw[col] = -1;
-        }
-        jw[i] = -1;
-        for( j = 0; j < U->nzcount[i]; j++ )
-        {
-            col = U->ja[i][j];
-            jw[col] = -1;
+                U->ma[i][jpos] -= L->ma[i][j] * U->ma[jrow][k];
         }
+    }
 
-        if( D[i] == 0 ) {
-            for( j = i+1; j < n; j++ ) {
-                L->ma[j] = NULL;
-                U->ma[j] = NULL;
-            }
-            fprintf( fp, "fatal error: Zero diagonal found...\n" );
-            return -2;
-        }
-        D[i] = 1.0 / D[i];
+    /* reset double-pointer to -1 ( U-part) */
+    for( j = 0; j < L->nzcount[i]; j++ )
+    {
+        col = L->ja[i][j];
+        jw[col] = -1;
+    }
+    jw[i] = -1;
+    for( j = 0; j < U->nzcount[i]; j++ )
+    {
+        col = U->ja[i][j];
+        jw[col] = -1;
     }
 
+    if( D[i] == 0 ) return -2;
+    D[i] = 1.0 / D[i];
     return 0;
 }
 
-int lofC( int lofM, csptr csmat, iluptr lu, FILE *fp )
+static int lofC( int lofM, csptr csmat, csptr L, csptr U, int *iw )
 {
 /*--------------------------------------------------------------------
  * symbolic ilu factorization to calculate structure of ilu matrix
@@ -160,23 +282,21 @@ int lofC( int lofM, csptr csmat, iluptr lu, FILE *fp )
  * lofM     = level of fill, lofM >= 0
  * csmat    = matrix stored in SpaFmt format -- see heads.h for details
  *            on format
- * lu       = pointer to a ILUSpar struct -- see heads.h for details
- *            on format
- * fp       = file pointer for error log ( might be stderr )
+ * L, U     = SpaFmt structs set up by setupCS, with or without values
+ * iw       = work array of length n
  *--------------------------------------------------------------------
  * on return:
  * ==========
  * ierr     = return value.
  *            ierr  = 0   --> successful return.
  *            ierr != 0   --> error
- * lu->n    = dimension of the block matrix
- *   ->L    = L part -- stored in SpaFmt format, patterns only in lofC
- *   ->U    = U part -- stored in SpaFmt format, patterns only in lofC
+ * L        = L part -- patterns only in lofC
+ * U        = U part -- patterns only in lofC
  *------------------------------------------------------------------*/
     int n = csmat->n;
-    int *levls = NULL, *jbuf = NULL, *iw = lu->work;
-    int **ulvl;  /*  stores lev-fils for U part of ILU factorization*/
-    csptr L = lu->L, U = lu->U;
+    int *levls = NULL, *jbuf = NULL;
+    int *ulvl;   /* levels of fill of the U part, stored like U->jall */
+    nnzint nlvl; /* length of ulvl                                     */
 /*--------------------------------------------------------------------
  * n        = number of rows or columns in matrix
  * inc      = integer, count of nonzero(fillin) element of each row
@@ -188,10 +308,12 @@ int lofC( int lofM, csptr csmat, iluptr lu, FILE *fp )
  *------------------------------------------------------------------*/
     int i, j, k, col, ip, it, jpiv; 
     int incl, incu, jmin, kmin; 
+    int *lk;
   
     levls  = (int *)Malloc( n*sizeof(int), "lofC" );
     jbuf = (int *)Malloc( n*sizeof(int), "lofC" ); 
-    ulvl = (int **)Malloc( n*sizeof(int *), "lofC" );
+    nlvl = n;
+    ulvl = (int *)Malloc( nlvl*sizeof(int), "lofC" );
 
     /* initilize iw */
     for( j = 0; j < n; j++ ) iw[j] = -1;
@@ -239,9 +361,10 @@ int lofC( int lofM, csptr csmat, iluptr lu, FILE *fp )
 	        k = kmin; 
             }
 /*-------------------- symbolic linear combinaiton of rows  */
+            lk = ulvl + U->ia[k];
             for( j = 0; j < U->nzcount[k]; j++ ) {
 	        col = U->ja[k][j];
-	        it = ulvl[k][j]+levls[jpiv]+1 ; 
+	        it = lk[j]+levls[jpiv]+1 ; 
 	        if( it > lofM ) continue; 
 	        ip = iw[col];
 	        if( ip == -1 ) {
@@ -266,29 +389,31 @@ int lofC( int lofM, csptr csmat, iluptr lu, FILE *fp )
 /*-------------------- copy L-part */ 
         L->nzcount[i] = incl;
         if(incl > 0 ) {
-            L->ja[i] = (int *)Malloc( incl*sizeof(int), "lofC" );
+            csAllocRow( L, i, incl );
             memcpy( L->ja[i], jbuf, sizeof(int)*incl);
         }
 /*-------------------- copy U - part        */ 
         k = incu-i; 
         U->nzcount[i] = k; 
         if( k > 0 ) {
-            U->ja[i] = (int *)Malloc( sizeof(int)*k, "lofC" );
+            csAllocRow( U, i, k );
             memcpy(U->ja[i], jbuf+i, sizeof(int)*k );
-/*-------------------- update matrix of levels */
-            ulvl[i] = (int *)Malloc( k*sizeof(int), "lofC" ); 
-            memcpy( ulvl[i], levls+i, k*sizeof(int) );
+/*-------------------- update matrix of levels, grown with U */
+            if( U->nnzmax > nlvl ) {
+                nlvl = U->nnzmax;
+                ulvl = (int *)Realloc( ulvl, (size_t)nlvl*sizeof(int),
+				       "lofC" );
+            }
+            memcpy( ulvl+U->ia[i], levls+i, k*sizeof(int) );
         }
     }
   
 /*-------------------- free temp space and leave --*/
+    csTrim( L );
+    csTrim( U );
     free(levls);
     free(jbuf);
-    for(i = 0; i < n-1; i++ ) {
-        if (U->nzcount[i]) free(ulvl[i]) ; 
-    }
     free(ulvl); 
 
     return 0;
 }        
-
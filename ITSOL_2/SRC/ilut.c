@@ -227,8 +227,9 @@ int ilut( csptr csmat, iluptr lu, int lfil, double tol, FILE *fp )
     qsplit( wn, iw, &lenl, &len );
     L->nzcount[i] = len;
     if( len > 0 ) {
-      ja = L->ja[i] = (int *)Malloc( len*sizeof(int), "ilut" );
-      ma = L->ma[i] = (double *)Malloc( len*sizeof(double), "ilut" );
+      csAllocRow( L, i, len );
+      ja = L->ja[i];
+      ma = L->ma[i];
     }
     for( j = 0; j < len; j++ ) {
       jpos = iw[j];
@@ -247,8 +248,9 @@ int ilut( csptr csmat, iluptr lu, int lfil, double tol, FILE *fp )
     qsplit( wn, iw, &lenu, &len );
     U->nzcount[i] = len;
     if( len > 0 ) {
-      ja = U->ja[i] = (int *)Malloc( len*sizeof(int), "ilut" );
-      ma = U->ma[i] = (double *)Malloc( len*sizeof(double), "ilut" );
+      csAllocRow( U, i, len );
+      ja = U->ja[i];
+      ma = U->ma[i];
     }
     for( j = 0; j < len; j++ ) {
       jpos = iw[j];
@@ -260,6 +262,8 @@ int ilut( csptr csmat, iluptr lu, int lfil, double tol, FILE *fp )
     }
   }
 
+  csTrim( L );
+  csTrim( U );
   free( iw );
   free( jbuf );
   free( wn );
@@ -277,8 +281,9 @@ int lutsolC( double *y, double *x, iluptr lu )
  *    x  = solution on return
  *    lu = LU matrix as produced by ilut.
  *--------------------------------------------------------------------*/
-    int n = lu->n, i, j, nzcount, *ja;
-    double *D, *ma;
+    int n = lu->n, i, *ja;
+    nnzint j, j1, *ia;
+    double *D, *ma, t;
     csptr L, U;
 
     L = lu->L;
@@ -286,24 +291,28 @@ int lutsolC( double *y, double *x, iluptr lu )
     D = lu->D;
 
     /* Block L solve */
+    ia = L->ia;
+    ja = L->jall;
+    ma = L->mall;
     for( i = 0; i < n; i++ ) {
-        x[i] = y[i];
-        nzcount = L->nzcount[i];
-        ja = L->ja[i];
-        ma = L->ma[i];
-        for( j = 0; j < nzcount; j++ ) {
-            x[i] -= x[ja[j]] * ma[j];
+        t = y[i];
+        j1 = ia[i] + L->nzcount[i];
+        for( j = ia[i]; j < j1; j++ ) {
+            t -= x[ja[j]] * ma[j];
         }
+        x[i] = t;
     }
     /* Block -- U solve */
+    ia = U->ia;
+    ja = U->jall;
+    ma = U->mall;
     for( i = n-1; i >= 0; i-- ) {
-        nzcount = U->nzcount[i];
-        ja = U->ja[i];
-        ma = U->ma[i];
-        for( j = 0; j < nzcount; j++ ) {
-            x[i] -= x[ja[j]] * ma[j];
+        t = x[i];
+        j1 = ia[i] + U->nzcount[i];
+        for( j = ia[i]; j < j1; j++ ) {
+            t -= x[ja[j]] * ma[j];
         }
-        x[i] *= D[i];
+        x[i] = t * D[i];
     }
 
     return 0;
@@ -10,6 +10,9 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifndef MAXFLOAT
 #define MAXFLOAT (1e30)
@@ -20,15 +23,21 @@
 #define BLEND 0.1        /* defines how to blend dropping by diagonal  */
 /* and other strategies. Element is always dropped when */
 /* (for Lij) : Lij < B*tol*D[i]+(1-B)*Norm (inv(L)*e_k) */
-static int Lnnz, *Lfirst, *Llist, *Lid, Unnz, *Ufirst, *Ulist, *Uid;
-static double Mnorm, *wL, *wU, *w, *D;
-static csptr L;
-static csptr U;
+
+typedef struct ILUCwk {
+  /*-------------------- state of one ilutc call -- see Workspace below.
+   * Kept per call so that several factorizations can run at once.   */
+  int Lnnz, *Lfirst, *Llist, *Lid, Unnz, *Ufirst, *Ulist, *Uid;
+  double *wL, *wU, *w, *D;
+  csptr L;
+  csptr U;
+} ILUCwk;
 
 /*-------------------- protos */
-int update_diagonals(iluptr lu, int i);
+static int update_diagonals(ILUCwk *c, iluptr lu, int i);
 int comp(const void *fst, const void *snd);
-int std_drop(int lfil, int i, double tolL, double tolU, double toldiag);
+static int std_drop(ILUCwk *c, int lfil, int i, double tolL, double tolU,
+                    double toldiag);
 int lumsolC(double *y, double *x, iluptr lu);
 /*-------------------- end protos */
 
@@ -134,6 +143,10 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
    *            j-th column in L part
    *----------------------------------------------------------------------*/
   int n = mt->n, i, j, k;
+  int *Lfirst, *Llist, *Lid, *Ufirst, *Ulist, *Uid;
+  double Mnorm, *wL, *wU, *w, *D;
+  csptr L, U;
+  ILUCwk c;
   int lfst, ufst, row, col, newrow, newcol, iptr;
   int nzcount, nnzL;
   double lval, uval, t, Lnorm, Unorm, tLnorm, tUnorm, diag, toldiag;
@@ -165,6 +178,18 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
     eL = (double *)Malloc(n * sizeof(double), "ilutc 11");
     eU = (double *)Malloc(n * sizeof(double), "ilutc 12");
   }
+  c.Lfirst = Lfirst;
+  c.Llist = Llist;
+  c.Lid = Lid;
+  c.wL = wL;
+  c.Ufirst = Ufirst;
+  c.Ulist = Ulist;
+  c.Uid = Uid;
+  c.wU = wU;
+  c.w = w;
+  c.D = D;
+  c.L = L;
+  c.U = U;
 
   /*-------------------- initialize a few things */
   for (i = 0; i < n; i++) {
@@ -186,7 +211,7 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
   for (i = 0; i < n; i++) {
     tLnorm = tUnorm = 0.0;
     /*-------------------- load column i into wL */
-    Lnnz = 0;
+    c.Lnnz = 0;
     nnzL = mt->L->nzcount[i];
     ia = mt->L->ja[i];
     ma = mt->L->ma[i];
@@ -196,10 +221,10 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
       t = ma[j];
       tLnorm += fabs(t);
       wL[row] = t;
-      Lid[Lnnz++] = row;
+      Lid[c.Lnnz++] = row;
     }
     /*-------------------- load row i into wU */
-    Unnz = 0;
+    c.Unnz = 0;
     nzcount = mt->U->nzcount[i];
     ja = mt->U->ja[i];
     ma = mt->U->ma[i];
@@ -210,7 +235,7 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
         t = ma[j];
         wU[col] = t;
         tUnorm += fabs(t);
-        Uid[Unnz++] = col;
+        Uid[c.Unnz++] = col;
       }
     }
     /*-------------------- update U(i) using Llist */
@@ -233,7 +258,7 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
         else {
           /*-------------------- fill-in */
           Ufirst[col] = 1;
-          Uid[Unnz++] = col;
+          Uid[c.Unnz++] = col;
           wU[col] = -lval * uval;
         }
       }
@@ -266,7 +291,7 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
         } else {
           /*-------------------- fill-in */
           Lfirst[row] = 1;
-          Lid[Lnnz++] = row;
+          Lid[c.Lnnz++] = row;
           wL[row] = -lval * uval;
         }
       }
@@ -282,7 +307,7 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
       }
     }
     /*-------------------- take care of special case when D[i] == 0 ---------*/
-    Mnorm = (tLnorm + tUnorm) / (Lnnz + Unnz);
+    Mnorm = (tLnorm + tUnorm) / (c.Lnnz + c.Unnz);
     if (D[i] == 0) {
       if (!NZ_DIAG) {
         fprintf(fp, "zero diagonal encountered.\n");
@@ -306,40 +331,40 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
     D[i] = 1.0 / D[i];
     /* DIAG-UPDATE-OPTION: COMMENT THE NEXT LINE */
     if (!DELAY_DIAG_UPD)
-      update_diagonals(lu, i);
+      update_diagonals(&c, lu, i);
     /*-------------------- call different dropping funcs according to 'drop' */
     /*-------------------- drop = 0                                          */
     if (drop == 0) {
-      std_drop(lfil, i, toldiag, toldiag, 0.0);
+      std_drop(&c, lfil, i, toldiag, toldiag, 0.0);
       /*-------------------- drop = 1 */
     } else if (drop == 1) {
       /*--------------------calculate one norms */
       Lnorm = diag;
-      for (j = 0; j < Lnnz; j++)
+      for (j = 0; j < c.Lnnz; j++)
         Lnorm += fabs(wL[Lid[j]]);
       /* compute Unorm now */
       Unorm = diag;
-      for (j = 0; j < Unnz; j++)
+      for (j = 0; j < c.Unnz; j++)
         Unorm += fabs(wU[Uid[j]]);
-      Lnorm /= (1.0 + Lnnz);
+      Lnorm /= (1.0 + c.Lnnz);
       Lnorm *= tol;
-      Unorm /= (1.0 + Unnz);
+      Unorm /= (1.0 + c.Unnz);
       Unorm *= tol;
-      std_drop(lfil, i, Lnorm, Unorm, 0.0);
+      std_drop(&c, lfil, i, Lnorm, Unorm, 0.0);
       /*-------------------- drop = 2 */
     } else if (drop == 2) {
       Lnorm = tol * diag / max(1, fabs(eL[i]));
       eU[i] *= D[i];
       Unorm = tol / max(1, fabs(eU[i]));
-      std_drop(lfil, i, Lnorm, Unorm, toldiag);
+      std_drop(&c, lfil, i, Lnorm, Unorm, toldiag);
       /*-------------------- update eL[i+1,...,n] and eU[i+1,...,n] */
       t = eL[i] * D[i];
-      for (j = 0; j < Lnnz; j++) {
+      for (j = 0; j < c.Lnnz; j++) {
         row = Lid[j];
         eL[row] -= wL[row] * t;
       }
       t = eU[i];
-      for (j = 0; j < Unnz; j++) {
+      for (j = 0; j < c.Unnz; j++) {
         col = Uid[j];
         eU[col] -= wU[col] * t;
       }
@@ -358,15 +383,15 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
       eU[i] *= D[i];
       Lnorm = tol * diag / max(1, fabs(eL[i]));
       Unorm = tol / max(1, fabs(eU[i]));
-      std_drop(lfil, i, Lnorm, Unorm, toldiag);
+      std_drop(&c, lfil, i, Lnorm, Unorm, toldiag);
       /*-------------------- update eL[i+1,...,n] and eU[i+1,...,n] */
       t = eL[i] * D[i];
-      for (j = 0; j < Lnnz; j++) {
+      for (j = 0; j < c.Lnnz; j++) {
         row = Lid[j];
         eL[row] += wL[row] * t;
       }
       t = eU[i];
-      for (j = 0; j < Unnz; j++) {
+      for (j = 0; j < c.Unnz; j++) {
         col = Uid[j];
         eU[col] += wU[col] * t;
       }
@@ -376,12 +401,12 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
       x1 = 1 - eL[i];
       x2 = -1 - eL[i];
       t = x1 * D[i];
-      for (j = 0; j < Lnnz; j++) {
+      for (j = 0; j < c.Lnnz; j++) {
         row = Lid[j];
         s1 += fabs(eL[row] + wL[row] * t);
       }
       t = x2 * D[i];
-      for (j = 0; j < Lnnz; j++) {
+      for (j = 0; j < c.Lnnz; j++) {
         row = Lid[j];
         s2 += fabs(eL[row] + wL[row] * t);
       }
@@ -395,12 +420,12 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
       x2 = (-1 - eU[i]) * D[i];
       s1 = s2 = 0.0;
       t = x1;
-      for (j = 0; j < Unnz; j++) {
+      for (j = 0; j < c.Unnz; j++) {
         col = Uid[j];
         s1 += fabs(eU[col] + wU[col] * t);
       }
       t = x2;
-      for (j = 0; j < Unnz; j++) {
+      for (j = 0; j < c.Unnz; j++) {
         col = Uid[j];
         s2 += fabs(eU[col] + wU[col] * t);
       }
@@ -410,15 +435,15 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
         eU[i] = x2;
       }
       Unorm = tol / max(1, fabs(eU[i]));
-      std_drop(lfil, i, Lnorm, Unorm, toldiag);
+      std_drop(&c, lfil, i, Lnorm, Unorm, toldiag);
       /*-------------------- update eL[i+1,...,n] and eU[i+1,...,n] */
       t = eL[i] * D[i];
-      for (j = 0; j < Lnnz; j++) {
+      for (j = 0; j < c.Lnnz; j++) {
         row = Lid[j];
         eL[row] += wL[row] * t;
       }
       t = eU[i];
-      for (j = 0; j < Unnz; j++) {
+      for (j = 0; j < c.Unnz; j++) {
         col = Uid[j];
         eU[col] += wU[col] * t;
       }
@@ -429,11 +454,11 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
     /*-------------------- update diagonals [after dropping option]        */
     /* DIAG-UPDATE-OPTION: COMMENT THE NEXT  LINE */
     if (DELAY_DIAG_UPD)
-      update_diagonals(lu, i);
+      update_diagonals(&c, lu, i);
     /*-------------------- reset nonzero indicators [partly reset already] */
-    for (j = 0; j < Lnnz; j++)
+    for (j = 0; j < c.Lnnz; j++)
       Lfirst[Lid[j]] = 0;
-    for (j = 0; j < Unnz; j++)
+    for (j = 0; j < c.Unnz; j++)
       Ufirst[Uid[j]] = 0;
     /*-------------------- initialize linked list for next row of U */
     if (U->nzcount[i] > 0) {
@@ -450,6 +475,8 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
       Llist[row] = i;
     }
   }
+  csTrim(L);
+  csTrim(U);
   free(Lfirst);
   free(Llist);
   free(Lid);
@@ -467,23 +494,59 @@ int ilutc(iluptr mt, iluptr lu, int lfil, double tol, int drop, FILE *fp) {
   return 0;
 }
 
-int update_diagonals(iluptr lu, int i) {
+int ilutc_batch(int nmat, iluptr *mt, iluptr *lu, int lfil, double tol,
+                int drop, int *ierr, int nthreads, FILE *fp) {
+  /*---------------------------------------------------------------------
+   * ILUTC factorizations of several independent matrices, e.g. one per
+   * subdomain or per system of a batch, computed concurrently with
+   * OpenMP. Each matrix is factored by one thread with ilutc.
+   *---------------------------------------------------------------------
+   * on entry:
+   * =========
+   * nmat     = number of matrices
+   * mt       = the nmat matrices, see ilutc
+   * lu       = nmat ILUSpar structs for the factors, see ilutc
+   * lfil, tol, drop, fp = parameters passed to ilutc for every matrix
+   * nthreads = number of threads. The factorizations are done one
+   *            after the other if nthreads <= 1 or without OpenMP.
+   *
+   * on return:
+   * ==========
+   * ierr     = the nmat values returned by ilutc
+   * return value = number of failed factorizations
+   *---------------------------------------------------------------------*/
+  int k, nfail = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+ : nfail) \
+  num_threads(nthreads > 1 ? nthreads : 1)
+#endif
+  for (k = 0; k < nmat; k++) {
+    ierr[k] = ilutc(mt[k], lu[k], lfil, tol, drop, fp);
+    if (ierr[k] != 0)
+      nfail++;
+  }
+  return nfail;
+}
+
+static int update_diagonals(ILUCwk *c, iluptr lu, int i) {
   /*---------------------------------------------------------------------
    * update diagonals D_{i+1,...,n}
    *---------------------------------------------------------------------*/
   double *diag = lu->D, scale = diag[i];
   /* By using the expansion arrays, only the shorter one of L(k) and U(k)
    * need to be scaned, so the time complexity = O(min(Lnnz,Unnz)) */
-  int j, id;
+  int j, id, *Lid = c->Lid, *Uid = c->Uid;
+  int *Lfirst = c->Lfirst, *Ufirst = c->Ufirst;
+  double *wL = c->wL, *wU = c->wU;
 
-  if (Lnnz < Unnz) {
-    for (j = 0; j < Lnnz; j++) {
+  if (c->Lnnz < c->Unnz) {
+    for (j = 0; j < c->Lnnz; j++) {
       id = Lid[j];
       if (Ufirst[id] != 0)
         diag[id] -= wL[id] * wU[id] * scale;
     }
   } else {
-    for (j = 0; j < Unnz; j++) {
+    for (j = 0; j < c->Unnz; j++) {
       id = Uid[j];
       if (Lfirst[id] != 0)
         diag[id] -= wL[id] * wU[id] * scale;
@@ -528,7 +591,8 @@ int comp(const void *fst, const void *snd) {
   return 0;
 }
 
-int std_drop(int lfil, int i, double tolL, double tolU, double toldiag) {
+static int std_drop(ILUCwk *c, int lfil, int i, double tolL, double tolU,
+                    double toldiag) {
   /*---------------------------------------------------------------------
    * Standard Dual drop-off strategy
    * ===============================
@@ -548,14 +612,16 @@ int std_drop(int lfil, int i, double tolL, double tolU, double toldiag) {
    *---------------------------------------------------------------------*/
   int j, len, col, row, ipos;
   int *ia, *ja;
-  double *ma, t;
-  t = D[i];
+  int *Lid = c->Lid, *Uid = c->Uid, *Lfirst = c->Lfirst, *Ufirst = c->Ufirst;
+  double *ma, t, *wL = c->wL, *wU = c->wU, *w = c->w;
+  csptr L = c->L, U = c->U;
+  t = c->D[i];
   /*-------------------- drop U elements                                 */
   len = 0;
   tolU = BLEND * toldiag + (1.0 - BLEND) * tolU;
   tolL = BLEND * toldiag + (1.0 - BLEND) * tolL;
   /*---------------------------------------------------------------------*/
-  for (j = 0; j < Unnz; j++) {
+  for (j = 0; j < c->Unnz; j++) {
     col = Uid[j];
     if (fabs(wU[col]) > tolU)
       Uid[len++] = col;
@@ -563,31 +629,32 @@ int std_drop(int lfil, int i, double tolL, double tolU, double toldiag) {
       Ufirst[col] = 0;
   }
   /*-------------------- find the largest lfil elements in row k */
-  Unnz = len;
-  len = min(Unnz, lfil);
-  for (j = 0; j < Unnz; j++)
+  c->Unnz = len;
+  len = min(c->Unnz, lfil);
+  for (j = 0; j < c->Unnz; j++)
     w[j] = fabs(wU[Uid[j]]);
-  qsplit(w, Uid, &Unnz, &len);
+  qsplit(w, Uid, &c->Unnz, &len);
   qsort(Uid, len, sizeof(int), comp);
   /*-------------------- update U */
   U->nzcount[i] = len;
   if (len > 0) {
-    ja = U->ja[i] = (int *)Malloc(len * sizeof(int), "std_drop 1");
-    ma = U->ma[i] = (double *)Malloc(len * sizeof(double), "std_drop 2");
+    csAllocRow(U, i, len);
+    ja = U->ja[i];
+    ma = U->ma[i];
   }
   for (j = 0; j < len; j++) {
     ipos = Uid[j];
     ja[j] = ipos;
     ma[j] = wU[ipos];
   }
-  for (j = len; j < Unnz; j++) {
+  for (j = len; j < c->Unnz; j++) {
     Ufirst[Uid[j]] = 0; /* important: otherwise, delay_update_diagonals may
                          * not work correctly in case U->nzcount[i] < Unnz */
   }
-  Unnz = len;
+  c->Unnz = len;
   /*-------------------- drop L elements                                    */
   len = 0;
-  for (j = 0; j < Lnnz; j++) {
+  for (j = 0; j < c->Lnnz; j++) {
     row = Lid[j];
     if (fabs(wL[row]) > tolL)
       Lid[len++] = row;
@@ -595,27 +662,28 @@ int std_drop(int lfil, int i, double tolL, double tolU, double toldiag) {
       Lfirst[row] = 0;
   }
   /*-------------------- find the largest lfil elements in column k         */
-  Lnnz = len;
-  len = min(Lnnz, lfil);
-  for (j = 0; j < Lnnz; j++)
+  c->Lnnz = len;
+  len = min(c->Lnnz, lfil);
+  for (j = 0; j < c->Lnnz; j++)
     w[j] = fabs(wL[Lid[j]]);
-  qsplit(w, Lid, &Lnnz, &len);
+  qsplit(w, Lid, &c->Lnnz, &len);
   qsort(Lid, len, sizeof(int), comp);
   /*-------------------- update L                                           */
   L->nzcount[i] = len;
   if (len > 0) {
-    ia = L->ja[i] = (int *)Malloc(len * sizeof(int), "std_drop 3");
-    ma = L->ma[i] = (double *)Malloc(len * sizeof(double), "std_drop 4");
+    csAllocRow(L, i, len);
+    ia = L->ja[i];
+    ma = L->ma[i];
   }
   for (j = 0; j < len; j++) {
     ipos = Lid[j];
     ia[j] = ipos;
     ma[j] = wL[ipos] * t;
   }
-  for (j = len; j < Lnnz; j++) {
+  for (j = len; j < c->Lnnz; j++) {
     Lfirst[Lid[j]] = 0; /* important: otherwise, delay_update_diagonals may
                          * not work correctly in case L->nzcount[i] < Lnnz */
   }
-  Lnnz = len;
+  c->Lnnz = len;
   return 0;
 }
@@ -291,8 +291,7 @@ msg_timer_start(&t27);
   printf("  row %d   length of L = %d",ii,len);
 */
       if (len > 0) {
-	 ilusch->L->ja[ii] = (int *) Malloc(len*sizeof(int), "ilutpC:5" ); 
-	 ilusch->L->ma[ii] = (double *) Malloc(len*sizeof(double), "ilutpC:6"); 
+	 csAllocRow(ilusch->L, ii, len);
 	 memcpy(ilusch->L->ma[ii], w, len*sizeof(double));
 	 for (j=0; j<len; j++)
 	    ilusch->L->ja[ii][j] = iperm[jw[j]];
@@ -317,8 +316,7 @@ msg_timer_start(&t28);
       ilusch->U->nzcount[ii] = len;
       if (lenu > len+1)
          qsplitC(&w[ii+1], &jw[ii+1], lenu-1, len);
-      ilusch->U->ma[ii] = (double *) Malloc(len*sizeof(double), "ilutpC:7" ); 
-      ilusch->U->ja[ii] = (int *) Malloc(len*sizeof(int), "ilutpC:8" ); 
+      csAllocRow(ilusch->U, ii, len);
 /*---------------------------------------------------------------------
 |     determine next pivot
 |--------------------------------------------------------------------*/
@@ -386,6 +384,8 @@ msg_timer_stop(&t28);
 /*---------------------------------------------------------------------
 |     end main loop - now do clean up
 |--------------------------------------------------------------------*/
+   csTrim(ilusch->L);
+   csTrim(ilusch->U);
    if (rmax > 0) {
       free(jw);
       free(w);
@@ -634,8 +634,7 @@ label40:
       if (len > lenl)
          qsplitC(w, jw, len, lenl);
       if (len > 0) {
-	 ilusch->L->ja[ii] = (int *) Malloc(lenl*sizeof(int), "ilutD:4" ); 
-	 ilusch->L->ma[ii] = (double *) Malloc(lenl*sizeof(double), "ilutD:5"); 
+	 csAllocRow(ilusch->L, ii, lenl);
 	 memcpy(ilusch->L->ja[ii], jw, lenl*sizeof(int));
 	 memcpy(ilusch->L->ma[ii], w, lenl*sizeof(double));
       }
@@ -659,8 +658,7 @@ label40:
       jpos = lenu-1;
       if (len > jpos)
          qsplitC(w, jw, len, jpos);
-      ilusch->U->ma[ii] = (double *) Malloc(lenu*sizeof(double), "ilutD:6" ); 
-      ilusch->U->ja[ii] = (int *) Malloc(lenu*sizeof(int), "ilutD:7" ); 
+      csAllocRow(ilusch->U, ii, lenu);
       if (t == 0.0) t=(0.0001+drop6)*tnorm;
       ilusch->U->ma[ii][0] = 1.0 / t;
       ilusch->U->ja[ii][0] = ii;
@@ -673,6 +671,8 @@ label40:
 /*---------------------------------------------------------------------
 |     end main loop - now do clean up
 |--------------------------------------------------------------------*/
+   csTrim(ilusch->L);
+   csTrim(ilusch->U);
    if (rmax > 0) {
       free(jw);
       free(w);
@@ -98,12 +98,10 @@ int SparTran(csptr amat, csptr bmat, int job, int flag)
 	    ind[aja[j]]++;
     }
 /*--------------------  allocate space  */
+    csReserve(bmat, nnz_cs(amat));
     for (i=0; i<size; i++) {
-      bmat->ja[i] = (int *) Malloc(ind[i]*sizeof(int), "SparTran:2" );
+      csAllocRow(bmat, i, ind[i]);
       bmat->nzcount[i] = ind[i];
-      if (job == 1) {
-	    bmat->ma[i] = (double *) Malloc(ind[i]*sizeof(double), "SparTran:3" );
-      }
       ind[i] = 0;
     }
   }
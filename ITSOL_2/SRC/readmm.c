@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "globheads.h"
+#include "protos.h"
+
+#define MM_CHUNK  65536   /* minimum number of bytes per chunk       */
+
+/*---------------------------------------------------------------------
+| Memory-mapped Matrix Market reader. The file is mapped read-only and
+| the data section is cut into chunks at line boundaries. Each chunk is
+| parsed independently, first to count its entries and then to convert
+| them in place at the offset given by a prefix sum of the counts, so
+| the output is in file order whatever the number of threads.
+|--------------------------------------------------------------------*/
+
+static const double mm_p10[23] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static int mm_blank(char c)
+{
+  return (c == ' ' || c == '\t' || c == '\r');
+}
+
+static const char *mm_nextline(const char *p, const char *end)
+{
+/*-------------------- start of the line after the one containing p */
+  const char *q = memchr(p, '\n', end-p);
+  return (q ? q+1 : end);
+}
+
+static int mm_isentry(const char *p, const char *end)
+{
+/*-------------------- line starting at p holds data (not blank or %) */
+  while (p < end && mm_blank(*p)) p++;
+  return (p < end && *p != '\n' && *p != '%');
+}
+
+static int mm_int(const char **pp, const char *end, int *v)
+{
+/*-------------------- parse a decimal integer, 0 on success */
+  const char *p = *pp;
+  long t = 0;
+  int neg = 0;
+  while (p < end && mm_blank(*p)) p++;
+  if (p < end && (*p == '+' || *p == '-')) neg = (*p++ == '-');
+  if (p == end || !isdigit((unsigned char)*p)) return 1;
+  for (; p < end && isdigit((unsigned char)*p); p++) {
+    t = 10*t + (*p - '0');
+    if (t > INT_MAX) return 1;
+  }
+  *v = (int)(neg ? -t : t);
+  *pp = p;
+  return 0;
+}
+
+static int mm_real(const char **pp, const char *end, double *v)
+{
+/*----------------------------------------------------------------------
+| Parse a floating-point number, 0 on success. A mantissa of at most 19
+| significant digits that is exactly representable (<= 2^53) scaled by
+| an exact power of ten (|e| <= 22) is converted with one correctly
+| rounded multiplication or division. Anything else is handed to
+| strtod, so the result is always the one atof would give.
+|--------------------------------------------------------------------*/
+  const char *p = *pp, *s, *q;
+  unsigned long long m = 0;
+  int neg = 0, nd = 0, e = 0, ex = 0, eneg = 0, any = 0, slow = 0, d;
+  char buf[64];
+  size_t len;
+
+  while (p < end && mm_blank(*p)) p++;
+  s = p;
+  if (p < end && (*p == '+' || *p == '-')) neg = (*p++ == '-');
+  for (; p < end && isdigit((unsigned char)*p); p++) {
+    any = 1;
+    d = *p - '0';
+    if (nd < 19) {
+      m = 10*m + d;
+      if (m) nd++;
+    } else {
+      e++;
+      slow = 1;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && isdigit((unsigned char)*p); p++) {
+      any = 1;
+      d = *p - '0';
+      if (nd < 19) {
+	m = 10*m + d;
+	if (m) nd++;
+	e--;
+      } else
+	slow = 1;
+    }
+  }
+  if (any && p < end && (*p == 'e' || *p == 'E')) {
+    q = p+1;
+    if (q < end && (*q == '+' || *q == '-')) eneg = (*q++ == '-');
+    if (q < end && isdigit((unsigned char)*q)) {
+      for (; q < end && isdigit((unsigned char)*q); q++)
+	if (ex < 10000) ex = 10*ex + (*q - '0');
+      p = q;
+      e += eneg ? -ex : ex;
+    }
+  }
+  if (p < end && !mm_blank(*p) && *p != '\n') slow = 1;
+/*-------------------- fast path */
+  if (any && !slow) {
+    if (m == 0) {
+      *v = neg ? -0.0 : 0.0;
+      *pp = p;
+      return 0;
+    }
+    if (m <= (1ULL << 53) && e >= -22 && e <= 22) {
+      *v = e < 0 ? (double)m / mm_p10[-e] : (double)m * mm_p10[e];
+      if (neg) *v = -*v;
+      *pp = p;
+      return 0;
+    }
+  }
+/*-------------------- slow path on a copy of the token */
+  for (p = s; p < end && !mm_blank(*p) && *p != '\n'; p++);
+  len = p - s;
+  if (len == 0) return 1;
+  if (len >= sizeof(buf)) len = sizeof(buf)-1;
+  memcpy(buf, s, len);
+  buf[len] = '\0';
+  *v = strtod(buf, NULL);
+  *pp = p;
+  return 0;
+}
+
+static int mm_banner(const char *p, const char *end, int *pattern,
+		     int *symm)
+{
+/*----------------------------------------------------------------------
+| Decode the %%MatrixMarket banner line. Only real, integer and pattern
+| coordinate matrices are accepted; symm is set to 0 (general), 1
+| (symmetric) or -1 (skew-symmetric). Returns 0 on success.
+|--------------------------------------------------------------------*/
+  char tok[5][32];
+  const char *q;
+  int k;
+  size_t len;
+
+  for (k=0; k<5; k++) {
+    while (p < end && mm_blank(*p)) p++;
+    for (q = p; q < end && !mm_blank(*q) && *q != '\n'; q++);
+    len = q - p;
+    if (len == 0 || len >= sizeof(tok[k])) return 1;
+    memcpy(tok[k], p, len);
+    tok[k][len] = '\0';
+    p = q;
+  }
+  if (strcasecmp(tok[1], "matrix") || strcasecmp(tok[2], "coordinate"))
+    return 1;
+  if (!strcasecmp(tok[3], "pattern"))
+    *pattern = 1;
+  else if (!strcasecmp(tok[3], "real") || !strcasecmp(tok[3], "double")
+	   || !strcasecmp(tok[3], "integer"))
+    *pattern = 0;
+  else
+    return 1;
+  if (!strcasecmp(tok[4], "general"))
+    *symm = 0;
+  else if (!strcasecmp(tok[4], "symmetric"))
+    *symm = 1;
+  else if (!strcasecmp(tok[4], "skew-symmetric"))
+    *symm = -1;
+  else
+    return 1;
+  return 0;
+}
+
+static int mm_parse(const char *p, const char *p1, const char *end,
+		    int base, int job, int nrow, int ncol, int pattern,
+		    double *val, int *row, int *col, int *noff)
+{
+/*----------------------------------------------------------------------
+| Convert the entries of the lines starting in [p, p1) and store them
+| contiguously in val, row, col. noff receives the number of entries
+| off the diagonal. Returns 0 on success, 4 on a malformed line.
+|--------------------------------------------------------------------*/
+  const char *q;
+  int i, j, k = 0;
+  double a;
+
+  *noff = 0;
+  for (; p < p1; p = mm_nextline(p, end)) {
+    if (!mm_isentry(p, end)) continue;
+    q = p;
+    if (mm_int(&q, end, &i) || mm_int(&q, end, &j)) return 4;
+    if (pattern)
+      a = 1.0;
+    else if (mm_real(&q, end, &a))
+      return 4;
+    i -= base;
+    j -= base;
+    if (i < 0 || i >= nrow || j < 0 || j >= ncol) return 4;
+    if (i != j) (*noff)++;
+    val[k] = a;
+    row[k] = i + job;
+    col[k] = j + job;
+    k++;
+  }
+  return 0;
+}
+
+int readmm(char *fname, int base, int job, int nthreads, int *nrow,
+	   int *ncol, int *nnz, double **val, int **row, int **col)
+{
+/*----------------------------------------------------------------------
+| Read a sparse matrix in Matrix Market coordinate format
+|----------------------------------------------------------------------
+| on entry:
+|==========
+| fname    = name of the file.
+| base     = index base of the entries in the file: 1 for Matrix
+|            Market files, 0 for the legacy 0-based .COO files. The
+|            %%MatrixMarket banner line is optional; without it the
+|            file is read as real general.
+| job      = 0 for C indexing of the output, 1 for FORTRAN indexing.
+| nthreads = number of threads used to parse the file.
+|
+| On return:
+|===========
+| nrow, ncol  = dimensions of the matrix.
+| nnz         = number of entries returned. For symmetric and skew-
+|               symmetric files the strict triangle is mirrored (with
+|               opposite sign when skew), so nnz counts both halves.
+| val,row,col = the matrix in COO format, entries in file order
+|               followed by the mirrored entries. Pattern files get
+|               the value 1.0. Duplicates are kept as they are.
+|
+|       integer value returned:
+|             0   --> successful return.
+|             1   --> cannot open or map the file.
+|             2   --> unsupported banner (array, complex, hermitian).
+|             3   --> bad size line.
+|             4   --> malformed entry or index out of range.
+|             5   --> number of entries differs from the size line.
+|--------------------------------------------------------------------*/
+  int fd, pattern = 0, symm = 0, m, n, nz, nc, c, ierr = 0;
+  int *cnt, *off, *moff, *cerr;
+  const char *map, *end, *p, **bnd;
+  size_t len;
+  long total, noff;
+  struct stat st;
+  double *aa;
+  int *ii, *jj;
+
+  *val = NULL;
+  *row = *col = NULL;
+/*-------------------- map the file */
+  if ((fd = open(fname, O_RDONLY)) < 0) return 1;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return 1;
+  }
+  len = (size_t)st.st_size;
+  map = (const char *)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return 1;
+#ifdef MADV_SEQUENTIAL
+  madvise((void *)map, len, MADV_SEQUENTIAL);
+#endif
+  end = map + len;
+/*-------------------- banner, comments and size line */
+  p = map;
+  if (len >= 14 && !strncasecmp(p, "%%MatrixMarket", 14)) {
+    if (mm_banner(p, mm_nextline(p, end), &pattern, &symm)) {
+      munmap((void *)map, len);
+      return 2;
+    }
+  }
+  while (p < end && !mm_isentry(p, end)) p = mm_nextline(p, end);
+  if (mm_int(&p, end, &m) || mm_int(&p, end, &n) || mm_int(&p, end, &nz)
+      || m < 0 || n < 0 || nz < 0 || (symm && m != n)) {
+    munmap((void *)map, len);
+    return 3;
+  }
+  p = mm_nextline(p, end);
+/*-------------------- cut the data into chunks at line boundaries */
+  if (nthreads < 1) nthreads = 1;
+  nc = nthreads > 1 ? 4*nthreads : 1;
+  if ((size_t)nc > (size_t)(end-p)/MM_CHUNK + 1)
+    nc = (int)((size_t)(end-p)/MM_CHUNK + 1);
+  bnd  = (const char **)Malloc((nc+1)*sizeof(char *), "readmm:1");
+  cnt  = (int *)Malloc(nc*sizeof(int), "readmm:2");
+  off  = (int *)Malloc((nc+1)*sizeof(int), "readmm:3");
+  moff = (int *)Malloc((nc+1)*sizeof(int), "readmm:4");
+  cerr = (int *)Malloc(nc*sizeof(int), "readmm:5");
+  bnd[0] = p;
+  bnd[nc] = end;
+  for (c=1; c<nc; c++) {
+    const char *q = p + (size_t)(end-p)*c/nc;
+    if (q < bnd[c-1]) q = bnd[c-1];
+    if (q > p && q[-1] != '\n') q = mm_nextline(q, end);
+    bnd[c] = q;
+  }
+/*-------------------- pass 1: count the entries of each chunk */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+  for (c=0; c<nc; c++) {
+    const char *q;
+    int k = 0;
+    for (q = bnd[c]; q < bnd[c+1]; q = mm_nextline(q, end))
+      if (mm_isentry(q, end)) k++;
+    cnt[c] = k;
+  }
+  total = 0;
+  for (c=0; c<nc; c++) {
+    off[c] = (int)total;
+    total += cnt[c];
+    if (total > INT_MAX) ierr = 5;
+  }
+  if (ierr == 0 && total != nz) ierr = 5;
+  if (ierr) goto done;
+  off[nc] = nz;
+  aa = (double *)Malloc((size_t)nz*sizeof(double), "readmm:6");
+  ii = (int *)Malloc((size_t)nz*sizeof(int), "readmm:7");
+  jj = (int *)Malloc((size_t)nz*sizeof(int), "readmm:8");
+/*-------------------- pass 2: convert the entries in place */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+  for (c=0; c<nc; c++)
+    cerr[c] = mm_parse(bnd[c], bnd[c+1], end, base, job, m, n, pattern,
+		       aa+off[c], ii+off[c], jj+off[c], &cnt[c]);
+  for (c=0; c<nc; c++)
+    if (cerr[c]) ierr = cerr[c];
+/*-------------------- pass 3: mirror the strict triangle */
+  if (ierr == 0 && symm) {
+    noff = 0;
+    for (c=0; c<nc; c++) {
+      moff[c] = (int)(nz + noff);
+      noff += cnt[c];
+    }
+    if (nz + noff > INT_MAX)
+      ierr = 5;
+    else {
+      total = nz + noff;
+      aa = (double *)Realloc(aa, (size_t)total*sizeof(double), "readmm:9");
+      ii = (int *)Realloc(ii, (size_t)total*sizeof(int), "readmm:10");
+      jj = (int *)Realloc(jj, (size_t)total*sizeof(int), "readmm:11");
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+      for (c=0; c<nc; c++) {
+	int k, l = moff[c];
+	for (k=off[c]; k<off[c+1]; k++) {
+	  if (ii[k] == jj[k]) continue;
+	  aa[l] = symm > 0 ? aa[k] : -aa[k];
+	  ii[l] = jj[k];
+	  jj[l] = ii[k];
+	  l++;
+	}
+      }
+      nz = (int)total;
+    }
+  }
+  if (ierr) {
+    free(aa);
+    free(ii);
+    free(jj);
+    goto done;
+  }
+  *nrow = m;
+  *ncol = n;
+  *nnz  = nz;
+  *val  = aa;
+  *row  = ii;
+  *col  = jj;
+done:
+  free(bnd);
+  free(cnt);
+  free(off);
+  free(moff);
+  free(cerr);
+  munmap((void *)map, len);
+  return ierr;
+}
+/*---------------------------------------------------------------------
+|     end of readmm
+|--------------------------------------------------------------------*/
+
+int readmm_csr(char *fname, int base, int job, int nthreads, int *nrow,
+	       int *ncol, double **a, int **ja, int **ia)
+{
+/*----------------------------------------------------------------------
+| Read a sparse matrix in Matrix Market coordinate format into CSR
+|----------------------------------------------------------------------
+| on entry:
+|==========
+| fname, base, job, nthreads = as in readmm.
+|
+| On return:
+|===========
+| nrow, ncol  = dimensions of the matrix.
+| a, ja, ia   = the matrix in CSR format (ia has nrow+1 entries) with
+|               the indexing selected by job, so that job = 1 can be
+|               passed to CSRcs directly. Within a row the entries are
+|               in the order returned by readmm.
+|
+|       integer value returned: as in readmm.
+|--------------------------------------------------------------------*/
+  int i, k, nnz, ierr, *ptr;
+  int *ii, *jj;
+  double *aa;
+
+  *a = NULL;
+  *ja = *ia = NULL;
+  ierr = readmm(fname, base, 0, nthreads, nrow, ncol, &nnz, &aa, &ii,
+		&jj);
+  if (ierr) return ierr;
+/*-------------------- counting sort by rows */
+  ptr = (int *)Malloc((*nrow+1)*sizeof(int), "readmm_csr:1");
+  for (i=0; i<=*nrow; i++) ptr[i] = 0;
+  for (k=0; k<nnz; k++) ptr[ii[k]+1]++;
+  for (i=0; i<*nrow; i++) ptr[i+1] += ptr[i];
+  *a  = (double *)Malloc((size_t)nnz*sizeof(double), "readmm_csr:2");
+  *ja = (int *)Malloc((size_t)nnz*sizeof(int), "readmm_csr:3");
+  for (k=0; k<nnz; k++) {
+    i = ptr[ii[k]]++;
+    (*a)[i]  = aa[k];
+    (*ja)[i] = jj[k] + job;
+  }
+  for (i=*nrow; i>0; i--) ptr[i] = ptr[i-1] + job;
+  ptr[0] = job;
+  *ia = ptr;
+  free(aa);
+  free(ii);
+  free(jj);
+  return 0;
+}
+/*---------------------------------------------------------------------
+|     end of readmm_csr
+|--------------------------------------------------------------------*/
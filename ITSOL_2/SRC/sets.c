@@ -22,7 +22,7 @@ void errexit( char *f_str, ... ){
   exit( -1 );
 }
 
-void *Malloc( int nbytes, char *msg )
+void *Malloc( size_t nbytes, char *msg )
 {
   void *ptr;
 
@@ -31,7 +31,23 @@ void *Malloc( int nbytes, char *msg )
 
   ptr = (void *)malloc(nbytes);
   if (ptr == NULL)
-    errexit( "Not enough mem for %s. Requested size: %d bytes", msg, nbytes );
+    errexit( "Not enough mem for %s. Requested size: %lu bytes", msg,
+	     (unsigned long) nbytes );
+
+  return ptr;
+}
+
+void *Realloc( void *ptr, size_t nbytes, char *msg )
+{
+  if (nbytes == 0) {
+    free(ptr);
+    return NULL;
+  }
+
+  ptr = (void *)realloc(ptr, nbytes);
+  if (ptr == NULL)
+    errexit( "Not enough mem for %s. Requested size: %lu bytes", msg,
+	     (unsigned long) nbytes );
 
   return ptr;
 }
@@ -55,11 +71,13 @@ int setupCS(csptr amat, int len, int job)
 |      ->*nzcount
 |      ->**ja
 |      ->**ma
+|      ->*ia       all -1, the arenas are empty
 |
 | integer value returned:
 |             0   --> successful return.
 |             1   --> memory allocation error.
 |--------------------------------------------------------------------*/
+   int i;
    amat->n = len;
    amat->nzcount = (int *)Malloc( len*sizeof(int), "setupCS" );
    amat->ja = (int **) Malloc( len*sizeof(int *), "setupCS" );
@@ -67,6 +85,13 @@ int setupCS(csptr amat, int len, int job)
        amat->ma = (double **) Malloc( len*sizeof(double *), "setupCS" );
    else
        amat->ma = NULL;
+   amat->ia = (nnzint *)Malloc( len*sizeof(nnzint), "setupCS" );
+   for (i=0; i<len; i++)
+     amat->ia[i] = -1;
+   amat->jall = NULL;
+   amat->mall = NULL;
+   amat->nnzall = 0;
+   amat->nnzmax = 0;
    return 0;
 }
 /*---------------------------------------------------------------------
@@ -83,18 +108,14 @@ int cleanCS(csptr amat)
 | ( amat )  =  Pointer to a SpaFmt struct.
 |--------------------------------------------------------------------*/
    /*   */
-  int i;
   if (amat == NULL) return 0;
   if (amat->n < 1) return 0;
-  for (i=0; i<amat->n; i++) {
-    if (amat->nzcount[i] > 0) {
-      if( amat->ma ) free(amat->ma[i]);
-      free(amat->ja[i]);
-    }
-  }    
   if (amat->ma) free(amat->ma);
   free(amat->ja);
   free(amat->nzcount);
+  free(amat->ia);
+  free(amat->jall);
+  free(amat->mall);
   free(amat);
   return 0;
 }
@@ -102,6 +123,170 @@ int cleanCS(csptr amat)
 |     end of cleanCS
 |--------------------------------------------------------------------*/
 
+int csReserve(csptr amat, nnzint nnz)
+{
+/*----------------------------------------------------------------------
+| Grow the arenas of a SpaFmt struct.
+|----------------------------------------------------------------------
+| on entry:
+|==========
+| ( amat )  =  Pointer to a SpaFmt struct set up by setupCS.
+|     nnz   =  number of entries the arenas must be able to hold
+|
+| On return:
+|===========
+|
+|  amat->nnzmax >= nnz. The rows already allocated keep their contents
+|  but may move, so the pointers ja[i] and ma[i] are reset and any
+|  pointer into a row obtained before the call is invalid.
+|
+| integer value returned:
+|             0   --> successful return.
+|--------------------------------------------------------------------*/
+  int i;
+  if (nnz <= amat->nnzmax) return 0;
+  amat->jall = (int *)Realloc( amat->jall, (size_t)nnz*sizeof(int),
+			       "csReserve" );
+  if (amat->ma)
+    amat->mall = (double *)Realloc( amat->mall, (size_t)nnz*sizeof(double),
+				    "csReserve" );
+  amat->nnzmax = nnz;
+  for (i=0; i<amat->n; i++) {
+    if (amat->ia[i] < 0) continue;
+    amat->ja[i] = amat->jall + amat->ia[i];
+    if (amat->ma) amat->ma[i] = amat->mall + amat->ia[i];
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------
+|     end of csReserve
+|--------------------------------------------------------------------*/
+
+int csAllocRow(csptr amat, int row, int len)
+{
+/*----------------------------------------------------------------------
+| Allocate a row of a SpaFmt struct at the end of its arenas.
+|----------------------------------------------------------------------
+| on entry:
+|==========
+| ( amat )  =  Pointer to a SpaFmt struct set up by setupCS.
+|     row   =  the row to allocate
+|     len   =  number of entries of the row
+|
+| On return:
+|===========
+|
+|  amat->ja[row] and amat->ma[row] point to len uninitialized entries,
+|  or are NULL if len is 0.
+|  The arenas are doubled when full, see csReserve. Rows should be
+|  allocated in increasing order, so that they are contiguous in
+|  memory and the arenas can be traversed sequentially.
+|
+| integer value returned:
+|             0   --> successful return.
+|--------------------------------------------------------------------*/
+  nnzint grow;
+  if (len <= 0) {
+    amat->ia[row] = -1;
+    amat->ja[row] = NULL;
+    if (amat->ma) amat->ma[row] = NULL;
+    return 0;
+  }
+  if (len > NNZINT_MAX - amat->nnzall)
+    errexit( "csAllocRow: more than %ld nonzeros, build with "
+	     "-DITS_LONG_INDEX", (long) NNZINT_MAX );
+  if (amat->nnzall + len > amat->nnzmax) {
+/*-------------------- double the arenas, up to NNZINT_MAX entries */
+    grow = amat->nnzmax > NNZINT_MAX/2 ? NNZINT_MAX : 2*amat->nnzmax;
+    csReserve(amat, max(max(grow, amat->nnzall+len), (nnzint)amat->n));
+  }
+  amat->ia[row] = amat->nnzall;
+  amat->ja[row] = amat->jall + amat->nnzall;
+  if (amat->ma) amat->ma[row] = amat->mall + amat->nnzall;
+  amat->nnzall += len;
+  return 0;
+}
+/*---------------------------------------------------------------------
+|     end of csAllocRow
+|--------------------------------------------------------------------*/
+
+int csTrim(csptr amat)
+{
+/*----------------------------------------------------------------------
+| Release the unused capacity of the arenas of a SpaFmt struct once all
+| its rows are allocated. Pointers into the rows are reset as in
+| csReserve.
+|--------------------------------------------------------------------*/
+  int i;
+  if (amat->nnzall == amat->nnzmax) return 0;
+  amat->jall = (int *)Realloc( amat->jall, (size_t)amat->nnzall*sizeof(int),
+			       "csTrim" );
+  if (amat->ma)
+    amat->mall = (double *)Realloc( amat->mall,
+				    (size_t)amat->nnzall*sizeof(double),
+				    "csTrim" );
+  amat->nnzmax = amat->nnzall;
+  for (i=0; i<amat->n; i++) {
+    if (amat->ia[i] < 0) continue;
+    amat->ja[i] = amat->jall + amat->ia[i];
+    if (amat->ma) amat->ma[i] = amat->mall + amat->ia[i];
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------
+|     end of csTrim
+|--------------------------------------------------------------------*/
+
+int csMerge(csptr amat, csptr *parts, int nparts)
+{
+/*----------------------------------------------------------------------
+| Copy the rows of several SpaFmt structs into one, e.g. the rows
+| computed by different threads.
+|----------------------------------------------------------------------
+| on entry:
+|==========
+| ( amat )  =  Pointer to a SpaFmt struct set up by setupCS, with no 
+|              rows allocated.
+|   parts   =  nparts SpaFmt structs of the same size. Each row must be
+|              allocated (with csAllocRow) in at most one of them. The
+|              rows allocated in none of them are empty.
+|
+| On return:
+|===========
+|
+|  amat->nzcount, ja, ma contain the rows of parts, stored contiguously
+|  in increasing order.
+|
+| integer value returned:
+|             0   --> successful return.
+|--------------------------------------------------------------------*/
+  int i, t, len;
+  nnzint nnz = 0;
+  csptr p;
+  for (t=0; t<nparts; t++)
+    nnz += parts[t]->nnzall;
+  if (nnz > NNZINT_MAX - amat->nnzall)
+    errexit( "csMerge: more than %ld nonzeros, build with "
+	     "-DITS_LONG_INDEX", (long) NNZINT_MAX );
+  csReserve(amat, amat->nnzall + nnz);
+  for (i=0; i<amat->n; i++) {
+    amat->nzcount[i] = 0;
+    for (t=0; t<nparts; t++) {
+      p = parts[t];
+      if (p->ia[i] < 0) continue;
+      len = amat->nzcount[i] = p->nzcount[i];
+      csAllocRow(amat, i, len);
+      memcpy(amat->ja[i], p->ja[i], len*sizeof(int));
+      if (amat->ma) memcpy(amat->ma[i], p->ma[i], len*sizeof(double));
+      break;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------
+|     end of csMerge
+|--------------------------------------------------------------------*/
+
 int cscpy(csptr amat, csptr bmat){
 /*----------------------------------------------------------------------
 | Convert CSR matrix to SpaFmt struct
@@ -122,18 +307,14 @@ int cscpy(csptr amat, csptr bmat){
 |             1   --> memory allocation error.
 |--------------------------------------------------------------------*/
   int j, len, size=amat->n;
-  double *bma;
-  int *bja;
 /*------------------------------------------------------------*/
+  csReserve(bmat, nnz_cs(amat));
   for (j=0; j<size; j++) {
     len = bmat->nzcount[j] = amat->nzcount[j];
     if (len > 0) {
-      bja = (int *) Malloc(len*sizeof(int), "cscpy:1" );
-      bma = (double *) Malloc(len*sizeof(double), "cscpy:2" );
-      memcpy(bja,amat->ja[j],len*sizeof(int));
-      memcpy(bma,amat->ma[j],len*sizeof(double));
-      bmat->ja[j] = bja;
-      bmat->ma[j] = bma;
+      csAllocRow(bmat, j, len);
+      memcpy(bmat->ja[j],amat->ja[j],len*sizeof(int));
+      memcpy(bmat->ma[j],amat->ma[j],len*sizeof(double));
     }	
   }
   return 0;
@@ -177,6 +358,64 @@ int setupILU( iluptr lu, int n )
 |     end of setupILU
 |--------------------------------------------------------------------*/
 
+int setupILUK( iluptr lu, iluksptr sym )
+{
+/*----------------------------------------------------------------------
+| Initialize an ILUSpar struct for the patterns of a symbolic ILUK
+| factorization.
+|----------------------------------------------------------------------
+| on entry:
+|==========
+|   ( lu )  =  Pointer to a ILUSpar struct.
+|   ( sym ) =  Pointer to a ILUKSym struct, see ilukSymbolic.
+|
+| On return:
+|===========
+|
+|    lu is set up as by setupILU, with the rows of L and U allocated
+|    in the patterns of sym. Their values are left for ilukNumeric,
+|    which can be called on lu any number of times.
+|
+| integer value returned:
+|             0   --> successful return.
+|--------------------------------------------------------------------*/
+  csptr src[2], dst[2];
+  int i, k, len;
+  setupILU( lu, sym->n );
+  src[0] = sym->L; dst[0] = lu->L;
+  src[1] = sym->U; dst[1] = lu->U;
+  for (k=0; k<2; k++) {
+    csReserve(dst[k], nnz_cs(src[k]));
+    for (i=0; i<sym->n; i++) {
+      len = dst[k]->nzcount[i] = src[k]->nzcount[i];
+      csAllocRow(dst[k], i, len);
+      if (len > 0)
+	memcpy(dst[k]->ja[i], src[k]->ja[i], len*sizeof(int));
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------
+|     end of setupILUK
+|--------------------------------------------------------------------*/
+
+int cleanILUKSym( iluksptr sym )
+{
+/*----------------------------------------------------------------------
+| Free up memory allocated for ILUKSym structs.
+|--------------------------------------------------------------------*/
+  if( NULL == sym ) return 0;
+  cleanCS( sym->L );
+  cleanCS( sym->U );
+  if( sym->ilev ) free( sym->ilev );
+  if( sym->lrow ) free( sym->lrow );
+  free( sym );
+  return 0;
+}
+/*---------------------------------------------------------------------
+|     end of cleanILUKSym
+|--------------------------------------------------------------------*/
+
 
 int cleanILU( iluptr lu )
 {
@@ -401,10 +640,8 @@ int mallocRow( iluptr lu, int nrow )
 |             0   --> successful return.
 |            -1   --> memory allocation error.
 |--------------------------------------------------------------------*/
-    int nzcount = lu->L->nzcount[nrow];
-    lu->L->ma[nrow] = (double *)Malloc( sizeof(double)*nzcount, "mallocRow" );
-    nzcount = lu->U->nzcount[nrow];
-    lu->U->ma[nrow] = (double *)Malloc( sizeof(double)*nzcount, "mallocRow" );
+    /* the entries are allocated in the arenas together with the
+       pattern by lofC, see csAllocRow */
     return 0;
 }
 /*---------------------------------------------------------------------
@@ -523,6 +760,9 @@ int setupP4 (p4ptr amat, int Bn, int Cn,  csptr F,  csptr E)
 
    amat->F = F; 
    amat->E = E; 
+   amat->nbnd = 0;
+   amat->bnd = NULL;
+   amat->nthreads = 1;
    return 0;
 }
 /*---------------------------------------------------------------------
@@ -576,6 +816,7 @@ int cleanP4(p4ptr amat)
   
   if (amat->D1) free(amat->D1);
   if (amat->D2) free(amat->D2);
+  if (amat->bnd) free(amat->bnd);
   return 0;
 }
 /*---------------------------------------------------------------------
@@ -669,6 +910,7 @@ int cleanILUT(ilutptr amat, int indic)
 void setup_arms (arms Levmat) {
   Levmat->ilus = (ilutptr) Malloc(sizeof(IluSpar), "setup_arms:ilus" );
   Levmat->levmat = (p4ptr) Malloc(sizeof(Per4Mat), "setup_arms:levmat" );
+  Levmat->nthreads = 1;
 }
 
 int cleanARMS(arms ArmsPre)
@@ -774,10 +1016,8 @@ int csSplit4(csptr amat, int bsize, int csize, csptr B, csptr F,
       }
       B->nzcount[j] = numl;
       F->nzcount[j] = numr;
-	  B->ja[j] = (int *) Malloc(numl*sizeof(int), "csSplit4:5" );
-	  B->ma[j] = (double *) Malloc(numl*sizeof(double), "csSplit4:6" );
-	  F->ja[j] = (int *) Malloc(numr*sizeof(int), "csSplit4:7" );
-	  F->ma[j] = (double *) Malloc(numr*sizeof(double), "csSplit4:8" );
+      csAllocRow(B, j, numl);
+      csAllocRow(F, j, numr);
       numl = numr = 0;
       for (j1=0; j1<rowz; j1++) {
           newj = rowj[j1];
@@ -815,10 +1055,8 @@ int csSplit4(csptr amat, int bsize, int csize, csptr B, csptr F,
       }
       E->nzcount[j] = numl;
       C->nzcount[j] = numr;
-	  E->ja[j] = (int *) Malloc(numl*sizeof(int), "csSplit4:9");
-	  E->ma[j] = (double *) Malloc(numl*sizeof(double), "csSplit4:10");
-	  C->ja[j] = (int *) Malloc(numr*sizeof(int), "csSplit4:11" );
-      C->ma[j] = (double *) Malloc(numr*sizeof(double), "csSplit4:12" );
+      csAllocRow(E, j, numl);
+      csAllocRow(C, j, numr);
       numl = numr = 0;
       for (j1=0; j1<rowz; j1++) {
 	      newj = rowj[j1];
@@ -842,6 +1080,10 @@ int csSplit4(csptr amat, int bsize, int csize, csptr B, csptr F,
       } 
    }
 
+   csTrim(B);
+   csTrim(F);
+   csTrim(E);
+   csTrim(C);
    if (new1j) free(new1j);
    if (new2j) free(new2j);
    if (new1m) free(new1m);
@@ -891,10 +1133,10 @@ int CSRcs( int n, double *a, int *ja, int *ia, csptr mat, int rsa )
         if( col != j ) mat->nzcount[col]++;
       }
     }
+    csReserve( mat, nnz_cs(mat) );
     for( j = 0; j < n; j++ ) {
       nnz = mat->nzcount[j];
-      mat->ja[j] = (int *)Malloc( nnz * sizeof(int), "CSRcs" );
-      mat->ma[j] = (double *)Malloc( nnz * sizeof(double), "CSRcs" );
+      csAllocRow( mat, j, nnz );
       mat->nzcount[j] = 0;
     }
     for( j = 0; j < n; j++ ) {
@@ -913,20 +1155,20 @@ int CSRcs( int n, double *a, int *ja, int *ia, csptr mat, int rsa )
     return 0;
   }
 
+  csReserve( mat, ia[n] - ia[0] );
   for (j=0; j<n; j++) {
     len = ia[j+1] - ia[j];
     mat->nzcount[j] = len;
     if (len > 0) {
-      bja = (int *) Malloc( len*sizeof(int), "CSRcs" );
-      bra = (double *) Malloc( len*sizeof(double), "CSRcs" );
+      csAllocRow( mat, j, len );
+      bja = mat->ja[j];
+      bra = mat->ma[j];
       i = 0;
       for (j1=ia[j]-1; j1<ia[j+1]-1; j1++) {
         bja[i] = ja[j1] - 1;
         bra[i] = a[j1] ;
         i++;
       }
-      mat->ja[j] = bja;
-      mat->ma[j] = bra;
     }
   }    
   return 0;
@@ -970,13 +1212,11 @@ int COOcs(int n, int nnz,  double *a, int *ja, int *ia, csptr bmat)
    for (k=0; k<nnz; k++) 
      ++len[ia[k]]; 
 /*-------------------- allocate          */
+   csReserve(bmat, nnz);
    for (k=0; k<n; k++) {
      l = len[k];
      bmat->nzcount[k] = l;
-     if (l > 0) {
-       bmat->ja[k] = (int *) Malloc(l*sizeof(int), "COOcs:1" );
-       bmat->ma[k] = ( double *) Malloc(l*sizeof( double),"COOcs:2" );
-     }
+     csAllocRow(bmat, k, l);
      len[k] = 0;
    }
 /*-------------------- Fill actual entries */
@@ -1212,9 +1452,10 @@ int nnz_lev4(p4ptr levmat, int *lev, FILE *ft)
    return (nnzT+nnzDown); 
 }
   
-int nnz_cs (csptr A) {
+nnzint nnz_cs (csptr A) {
 /*-------------------- counts number of nonzeros in CSR matrix A */
-  int i, n=A->n, nnz=0; 
+  int i, n=A->n;
+  nnzint nnz=0; 
   for (i=0; i<n; i++) 
     nnz +=A->nzcount[i];
   return nnz;
@@ -1298,20 +1539,16 @@ int CSClum( int n, double *a, int *ja, int *ia, iluptr mat, int rsa )
         if( rsa == 2 ) {
             /* nzcount(A + A^T) <= nzcount(A) + nnzcol(A^T) */
             nnz = L->nzcount[i] + U->nzcount[i];
-            L->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum1" );
-            L->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum2" );
+            csAllocRow( L, i, nnz );
             L->nzcount[i] = 0;
-            U->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum3" );
-            U->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum4" );
+            csAllocRow( U, i, nnz );
             U->nzcount[i] = 0;
         } else {
             nnz = L->nzcount[i];
-            L->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum4" );
-            L->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum5" );
+            csAllocRow( L, i, nnz );
             L->nzcount[i] = 0;
             nnz = U->nzcount[i];
-            U->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum6" );
-            U->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum7" );
+            csAllocRow( U, i, nnz );
             U->nzcount[i] = 0;
         }
     }
@@ -1458,20 +1695,16 @@ int CSClumC(csptr amat, iluptr mat, int rsa )
         if( rsa == 2 ) {
             /* nzcount(A + A^T) <= nzcount(A) + nnzcol(A^T) */
             nnz = L->nzcount[i] + U->nzcount[i];
-            L->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum1" );
-            L->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum2" );
+            csAllocRow( L, i, nnz );
             L->nzcount[i] = 0;
-            U->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum3" );
-            U->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum4" );
+            csAllocRow( U, i, nnz );
             U->nzcount[i] = 0;
         } else {
 	  nnz = L->nzcount[i];
-	  L->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum4" );
-	  L->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum5" );
+	  csAllocRow( L, i, nnz );
 	  L->nzcount[i] = 0;
 	  nnz = U->nzcount[i];
-	  U->ja[i] = (int *)Malloc( nnz*sizeof(int), "CSClum6" );
-	  U->ma[i] = (double *)Malloc( nnz*sizeof(double), "CSClum7" );
+	  csAllocRow( U, i, nnz );
 	  U->nzcount[i] = 0;
         }
     }
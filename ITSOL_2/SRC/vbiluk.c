@@ -12,15 +12,14 @@
 #define max(a,b) (((a)>(b))?(a):(b))
 #endif
 #define SVD 1
-#define dgemm dgemm_
 
 /*-------------------- protos */
-void *Malloc(int nbytes, char *msg); 
+void *Malloc(size_t nbytes, char *msg); 
 int vblusolC(double *y, double *x, vbiluptr lu); 
 int invGauss(int nn, double *A); 
 int invSVD(int nn, double *A) ;
-void dgemm(char*, char*, int*, int*, int*, double*, double*, int*, 
-	   double*, int*, double*, double*, int*) ; 
+void bgemm(int m, int n, int k, double alpha, BData a, BData b,
+	   double beta, BData c);
 int setupVBMat(vbsptr vbmat, int n, int *nB);
 int mallocVBRow(vbiluptr lu, int nrow); 
 void zrmC(int m, int n, BData data); 
@@ -131,8 +130,8 @@ int vbilukC( int lofM, vbsptr vbmat, vbiluptr lu, FILE *fp )
             mm = dim;              /* number of rows of current block */
             nn = B_DIM(bsz,jrow);  /* number of cols of current block */
             /* get the multiplier for row to be eliminated (jrow) */
-            dgemm( "n", "n", &mm, &nn, &nn, &alpha1, L->ba[i][j], &mm,
-                    lu->D[jrow], &nn, &beta1, lu->bf, &mm );
+            bgemm( mm, nn, nn, alpha1, L->ba[i][j], lu->D[jrow], beta1,
+                   lu->bf );
             copyBData( mm, nn, L->ba[i][j], lu->bf, 0 );
 
             /* combine current row and row jrow */
@@ -142,18 +141,15 @@ int vbilukC( int lofM, vbsptr vbmat, vbiluptr lu, FILE *fp )
                 if( jpos == -1 ) continue;
                 if( col < i ) {
                     kk = B_DIM(bsz,col);
-                    dgemm( "n", "n", &mm, &kk, &nn, &alpha2, L->ba[i][j],
-                           &mm, U->ba[jrow][k], &nn, &beta2,
-                           L->ba[i][jpos], &mm );
+                    bgemm( mm, kk, nn, alpha2, L->ba[i][j],
+                           U->ba[jrow][k], beta2, L->ba[i][jpos] );
                 } else if( col == i ) {
-                    dgemm( "n", "n", &mm, &mm, &nn, &alpha2, L->ba[i][j],
-                           &mm, U->ba[jrow][k], &nn, &beta2,
-                           lu->D[i], &mm );
+                    bgemm( mm, mm, nn, alpha2, L->ba[i][j],
+                           U->ba[jrow][k], beta2, lu->D[i] );
                 } else {
                     kk = B_DIM(bsz,col);
-                    dgemm( "n", "n", &mm, &kk, &nn, &alpha2, L->ba[i][j],
-                           &mm, U->ba[jrow][k], &nn, &beta2,
-                           U->ba[i][jpos], &mm );
+                    bgemm( mm, kk, nn, alpha2, L->ba[i][j],
+                           U->ba[jrow][k], beta2, U->ba[i][jpos] );
                 }
             }
         }
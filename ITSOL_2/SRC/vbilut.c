@@ -14,13 +14,12 @@
 #define qsplit qsplit_ 
 #define gauss gauss_
 #define bxinv bxinv_
-#define dgemm dgemm_
 /*-------------------- protos */
-void *Malloc(int nbytes, char *msg); 
+void *Malloc(size_t nbytes, char *msg); 
 void zrmC(int m, int n, BData data); 
 void copyBData(int m, int n, BData dst, BData src, int isig);
-void dgemm(char*, char*, int*, int*, int*, double*, double*, int*, 
-	   double*, int*, double*, double*, int*) ; 
+void bgemm(int m, int n, int k, double alpha, BData a, BData b,
+	   double beta, BData c);
 int vblusolC(double *y, double *x, vbiluptr lu); 
 void gauss (int *, double*, int*); 
 void bxinv (int*, int*, double*,double*,double*);
@@ -205,8 +204,7 @@ int vbilutC( vbsptr vbmat, vbiluptr lu, int lfil, double tol,
       for( k = 0; k < nzcount; k++ ) {
         col = ja[k];
         sz = B_DIM(bsz,col);
-	dgemm ("n","n",&dim, &sz, &szjrow, &one, buf_fact, &dim,
-	       ba[k], &szjrow, &zero, buf_ns, &dim ); 
+	bgemm( dim, sz, szjrow, one, buf_fact, ba[k], zero, buf_ns );
         jpos = iw[col];
 
         /* if fill-in element is small then disregard: */
@@ -13,6 +13,9 @@
 #include "globheads.h"
 #include "defs.h" 
 #include "protos.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "ios.h"  
 #include <time.h>
 #include <assert.h> 
@@ -27,10 +30,8 @@ void set_arms_pars(io_t* io,  int Dscale, int *ipar,
 		   double *tolcoef, int *lfil);
 int read_inputs(char *in_file, io_t *pio);
 int get_matrix_info(FILE *fmat, io_t *pio);
-int read_coo(double **AA, int **JA, int **IA, io_t *pio,
-	     double **hs, double **ol, int job); 
-int readhb_c(int *NN, double **AA, int **JA, int **IA, io_t *pio, 
-	      double **rhs, double **guess, int *rsa);
+int read_matrix(io_t *pio, csptr mat, double **rhs, double **sol,
+		int *rsa, int job);
 void randvec (double *v, int n);
 int dumpArmsMat(arms PreSt, FILE *ft);
 /*-------------------- end protos */
@@ -56,9 +57,7 @@ int main () {
   int lfil_arr[7]; 
   double droptol[7], dropcoef[7];
   int ipar[18];
-/*-------------------- harwell boeing temporary arrays */
-  double *AA;
-  int *IA, *JA;
+/*-------------------- matrix size, rsa = 1 for a symmetric HB matrix */
   int rsa; 
   int n; 
 /*-------------------- IO-related           */  
@@ -68,9 +67,15 @@ int main () {
                             functions + a few other things */
   double tm1, tm2;
   int mat, numat, iparam, i;
+  int nthreads = 1;    /* number of threads for matvecs and arms */
   double terr;
   char line[MAX_LINE];
   MAT = (SMatptr)Malloc(sizeof(SMat), "main:MAT");
+  MAT->nthreads = 1;
+  MAT->part = NULL;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
   PRE = (SPreptr)Malloc(sizeof(SPre), "main:PRE");
 /*------------------ read and set parameters and other inputs */
   memset(&io, 0, sizeof(io));
@@ -109,42 +114,14 @@ int main () {
       exit(5);
     }
     fprintf(flog, "MATRIX: %s...\n", io.MatNam);
-/*-------------------- Read matrix - case: COO formats */
+/*-------------------- Read matrix */
     csmat = (csptr)Malloc( sizeof(SparMat), "main:csmat" );
-    if (io.Fmt > HB){
-      ierr = read_coo(&AA,&JA, &IA, &io, &rhs, &sol,0);
-      if (ierr == 0) 
-        fprintf(flog,"matrix read successfully\n");
-      else {
-	fprintf(flog, "read_coo error = %d\n", ierr);
-	exit(6);
-      }
-      n = io.ndim;
-      nnz = io.nnz;
-/*-------------------- conversion from COO to CSR format */
-      if((ierr = COOcs(n, nnz, AA, JA, IA, csmat)) != 0) {
-	fprintf(stderr, "mainARMS: COOcs error\n");
-	return ierr;
-      }
-    }
-/*-------------------- Read matrix - case: HB formats */
-    if (io.Fmt == HB) {
-      /* NOTE: (AA,JA,IA) is in CSR format */
-      ierr = readhb_c(&n, &AA, &JA, &IA, &io, &rhs, &sol, &rsa);
-      if(ierr != 0) {
-	fprintf(flog, "readhb_c error = %d\n", ierr);
-	exit(7);
-      }
-      nnz = io.nnz;
-      if((ierr = CSRcs(n, AA, JA, IA, csmat, rsa)) != 0) {
-	fprintf(flog, "readhb_c: CSRcs error\n");
-	return ierr;
-      }
+    ierr = read_matrix(&io, csmat, &rhs, &sol, &rsa, 0);
+    if (ierr != 0) {
+      fprintf(flog, "read_matrix error = %d\n", ierr);
+      exit(6);
     }
-/*---------------- COO / HB arrays no longer needed -- free */    
-    free(IA); IA = NULL;
-    free(AA); AA = NULL;
-    free(JA); JA = NULL;
+    nnz = io.nnz;
 /*----------------------------------------------------------*/
     n = csmat->n;
     x = (double *)Malloc(n* sizeof(double), "main:x");
@@ -162,6 +139,7 @@ int main () {
 
       ArmsSt = (arms) Malloc(sizeof(armsMat),"main:ArmsSt");
       setup_arms(ArmsSt);
+      ArmsSt->nthreads = nthreads;
       fprintf(flog, "begin arms\n");
       tm1 = sys_timer();
 /*-------------------- call ARMS preconditioner set-up  */
@@ -209,6 +187,7 @@ int main () {
       MAT->n = n;
       MAT->CS = csmat;
       MAT->matvec = matvecCSR; 
+      setupSMat(MAT, nthreads);
       PRE->ARMS = ArmsSt;
       PRE->precon = preconARMS;
 /*-------------------- call fgmr */
@@ -253,6 +232,7 @@ NEXT_PARA:
   fclose(io.fout);   
   if(flog != stdout) fclose (flog);
   fclose(fmat);
+  free(MAT->part);
   free(MAT);
   free(PRE);
   return 0;
@@ -11,16 +11,17 @@
 #include <math.h>
 #include "globheads.h"
 #include "protos.h"  
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "ios.h" 
 #include <time.h>
 
 /*-------------------- protos */
 void output_header(io_t *pio );
 void output_result( int lfil, io_t *pio, int iparam );
-int read_coo(double **AA, int **JA, int **IA, io_t *pio,
-	     double **hs, double **ol, int job); 
-int readhb_2(int*, double**, int**, int**, 
-             io_t*, double**, double**, int*, int);
+int read_matrix(io_t *pio, csptr mat, double **rhs, double **sol,
+		int *rsa, int job);
 int read_inputs( char *in_file, io_t *pio );
 int get_matrix_info( FILE *fmat, io_t *pio );
 void randvec (double *v, int n);
@@ -29,15 +30,18 @@ void matvecLDU(SMatptr mat, double *x, double *y);
 void matvecCSC(SMatptr mat, double *x, double *y); 
 int preconLDU(double *x, double *y, SPreptr mat);
 void coocsc(int,int,double*,int*,int*,double**,int**,int**,int);
+static int check_batch( iluptr lumat, int lfil, double tol, int drop,
+			int nthreads, FILE *flog );
 /*-------------------- end protos */
 
 #define DRP_MTH 0          /* drop method see ilutc code */
+#define NBATCH  4          /* number of matrices for check_batch */
 int main() { 
   int ierr = 0;
 /*-------------------------------------------------------------------
  * options
  *-----------------------------------------------------------------*/
-  int dropmthd = DRP_MTH, plotting = 0, nnz, output_lu = 0; 
+  int dropmthd = DRP_MTH, plotting = 0, output_lu = 0; 
   int pattern_symm = 0;
   char pltfile[256];
   FILE *fits = NULL;
@@ -51,9 +55,7 @@ int main() {
 /*-------------------- method for incrementing lfil is set here */
   int lfil; 
   double tol;
-/*-------------------- harwell boeing temp. arrays */
-  double *AA;
-  int *IA, *JA;
+/*-------------------- rsa = 1 for a symmetric HB matrix */
   int rsa=0; 
   int n; 
 /*-------------------- IO-related */  
@@ -61,9 +63,15 @@ int main() {
   io_t io;
   double tm1, tm2;
   int mat, numat, iparam, i;
+  int nthreads = 1;    /* number of threads for the matvecs */
   double terr;
   char line[MAX_LINE];
   MAT = (SMatptr)Malloc( sizeof(SMat), "main:MAT" );
+  MAT->nthreads = 1;
+  MAT->part = NULL;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
   PRE = (SPreptr)Malloc( sizeof(SPre), "main:PRE" );
 /*------------------ read and set parameters and other inputs  */
   memset( &io, 0, sizeof(io) );
@@ -98,41 +106,15 @@ int main() {
       exit(5); 
     }
     fprintf( flog, "MATRIX: %s...\n", io.MatNam);
-/*-------------------- Read  matrix */
+/*-------------------- Read  matrix, csmat in column format */
     lumat = (iluptr)Malloc(sizeof(LDUmat),"main:lumat");
     csmat = (csptr)Malloc( sizeof(SparMat), "main:csmat");    
-/*-------------------- case: COO formats (0-indexing) */
-    if (io.Fmt > HB) {      
-      ierr = read_coo(&AA, &JA, &IA, &io, &rhs, &sol,0);
-      if (ierr == 0) 
-        fprintf(flog,"matrix read successfully\n");
-      else {
-	fprintf(flog, "read_coo error = %d\n", ierr);
-	exit(6);
-      }
-      n = io.ndim;
-      nnz = io.nnz;
-/*-------------------- conversion from COO to CS format *
-                       NOTE: csmat is in colum format   */
-      if((ierr = COOcs(n, nnz, AA, IA, JA, csmat)) != 0) {
-	fprintf(stderr, "mainILUC: COOcs error\n");
-	return ierr;
-      }
-    }
-    else if (io.Fmt == HB) {
-/*-------------------- NOTE : (AA,JA,IA) is in CSC format */
-      ierr = readhb_2(&n, &AA, &JA, &IA, &io, &rhs, &sol, &rsa, 0);
-      if(ierr != 0) {
-	fprintf(flog, "readhb_c error = %d\n", ierr);
-	exit(7);
-      }
-      nnz = io.nnz;
-/*-------------------- convert matrix to cs format for matvecs */
-      if((ierr = CSRcs(n, AA, JA, IA, csmat, rsa)) != 0) {
-	fprintf(flog, "CSRcs error\n");
-	return (ierr);
-      }
+    ierr = read_matrix(&io, csmat, &rhs, &sol, &rsa, 1);
+    if (ierr != 0) {
+      fprintf(flog, "read_matrix error = %d\n", ierr);
+      exit(6);
     }
+    n = io.ndim;
 /*-------------------- convert to lum format for iluc + symmetrize */
     if( rsa == 0 && pattern_symm)
       rsa = 2;  
@@ -140,10 +122,6 @@ int main() {
      fprintf( stderr, " error: CSClum error\n" );
      return (ierr);
     }
-/*-------------------- free CSR/CSC arrays no longer needed  */
-    free(AA); AA = NULL;
-    free(IA); IA = NULL;
-    free(JA); JA = NULL;
 /*-------- ##FIXME: diag scaling removed - see old version */
 /*---------------------------------------------------------*/
     x = (double *)Malloc( io.ndim * sizeof(double), "main" );
@@ -167,6 +145,10 @@ int main() {
 	io.rnorm = -1;
 	goto NEXT_PARA;
       }
+      if( check_batch( lumat, lfil, tol, dropmthd, nthreads, flog ) != 0 ) {
+	fprintf( flog, "*** ilutc error, batch factors differ ***\n" );
+	exit(-1);
+      }
       if( output_lu ){
 	char matdata[MAX_LINE];
 	sprintf( matdata, "OUT/%s.dat",io.MatNam );
@@ -205,6 +187,7 @@ int main() {
       MAT->n = n;
       MAT->CS = csmat; /* in column format */
       MAT->matvec = matvecCSC; /* column matvec */
+      setupSMat(MAT, nthreads);
       PRE->ILU = lu;
       PRE->precon = preconLDU;
 /*-------------------- call fgmr */
@@ -249,7 +232,76 @@ NEXT_PARA:
   fclose( io.fout );
   if( flog != stdout ) fclose ( flog );
   fclose( fmat );
+  free(MAT->part);
   free(MAT) ; 
   free (PRE); 
   return 0;
 }
+
+static int check_batch( iluptr lumat, int lfil, double tol, int drop,
+			int nthreads, FILE *flog )
+{
+/*-------------------------------------------------------------------
+ * Factor NBATCH scaled copies of lumat concurrently with ilutc_batch
+ * and compare each factor with a serial ilutc of the same copy.
+ * Returns the number of entries that differ, or -1 if a
+ * factorization fails.
+ *-----------------------------------------------------------------*/
+  iluptr mt[NBATCH], lu[NBATCH], ref;
+  int ierr[NBATCH], n = lumat->n, i, j, k, ndiff = 0;
+  double s;
+
+  for( k = 0; k < NBATCH; k++ ) {
+/*-------------------- copy k is lumat scaled by 1 + k/3 */
+    s = 1.0 + k / 3.0;
+    mt[k] = (iluptr)Malloc( sizeof(LDUmat), "check_batch" );
+    setupILU( mt[k], n );
+    cscpy( lumat->L, mt[k]->L );
+    cscpy( lumat->U, mt[k]->U );
+    for( i = 0; i < n; i++ ) {
+      mt[k]->D[i] = s * lumat->D[i];
+      for( j = 0; j < mt[k]->L->nzcount[i]; j++ )
+	mt[k]->L->ma[i][j] *= s;
+      for( j = 0; j < mt[k]->U->nzcount[i]; j++ )
+	mt[k]->U->ma[i][j] *= s;
+    }
+    lu[k] = (iluptr)Malloc( sizeof(ILUSpar), "check_batch" );
+  }
+  if( ilutc_batch( NBATCH, mt, lu, lfil, tol, drop, ierr, nthreads,
+		   flog ) != 0 )
+    ndiff = -1;
+
+  for( k = 0; k < NBATCH; k++ ) {
+    ref = NULL;
+    if( ndiff >= 0 ) {
+      ref = (iluptr)Malloc( sizeof(ILUSpar), "check_batch" );
+      if( ilutc( mt[k], ref, lfil, tol, drop, flog ) != 0 ) ndiff = -1;
+    }
+    for( i = 0; ndiff >= 0 && i < n; i++ ) {
+      if( lu[k]->D[i] != ref->D[i] ) ndiff++;
+      if( lu[k]->L->nzcount[i] != ref->L->nzcount[i] ||
+	  lu[k]->U->nzcount[i] != ref->U->nzcount[i] ) {
+	ndiff++;
+	continue;
+      }
+      for( j = 0; j < lu[k]->L->nzcount[i]; j++ )
+	if( lu[k]->L->ja[i][j] != ref->L->ja[i][j] ||
+	    lu[k]->L->ma[i][j] != ref->L->ma[i][j] ) ndiff++;
+      for( j = 0; j < lu[k]->U->nzcount[i]; j++ )
+	if( lu[k]->U->ja[i][j] != ref->U->ja[i][j] ||
+	    lu[k]->U->ma[i][j] != ref->U->ma[i][j] ) ndiff++;
+    }
+/*-------------------- ilutc sets up the factors unless lfil < 0 */
+    if( lfil < 0 ) {
+      free( lu[k] );
+      free( ref );
+    } else {
+      cleanILU( lu[k] );
+      cleanILU( ref );
+    }
+    cleanILU( mt[k] );
+  }
+  fprintf( flog, "ilutc_batch of %d matrices: %d entries differ\n",
+	   NBATCH, ndiff );
+  return ndiff;
+}
@@ -12,19 +12,22 @@
 #include "globheads.h"
 #include "defs.h" 
 #include "protos.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "ios.h"  
 #include <sys/time.h>
 
 /*-------------------- protos */
 void output_header( io_t *pio );
 void output_result(int lfil, io_t *pio, int iparam );
-int read_coo(double **AA, int **JA, int **IA, io_t *pio,
-             double **hs, double **ol, int job);
-int readhb_c(int *NN, double **AA, int **JA, int **IA, io_t *pio, 
-             double **rhs, double **guess, int *rsa);
+int read_matrix(io_t *pio, csptr mat, double **rhs, double **sol,
+		int *rsa, int job);
 int read_inputs( char *in_file, io_t *pio );
 int get_matrix_info( FILE *fmat, io_t *pio );
 void randvec (double *v, int n);
+static int check_refactor( int lfil, csptr csmat, iluksptr sym, iluptr lu,
+			   int nthreads, FILE *flog );
 /*-------------------- end protos */
 
 /*------------------------------------------------------------*/
@@ -39,19 +42,24 @@ int main(){
   SMatptr MAT;         /* Matrix structure for matvecs    */
   SPreptr PRE;         /* general precond structure       */
   iluptr lu = NULL;    /* ilu preconditioner structure    */
+  iluksptr sym = NULL; /* symbolic ILUK factorization      */
   double *sol = NULL, *x = NULL, *rhs = NULL;
-/*-------------------- temp Harwell Boeing arrays */
-  double *AA;
-  int *JA, *IA;
-  int n, nnz, lfil, rsa;
+/*-------------------- matrix size, rsa = 1 for a symmetric HB matrix */
+  int n, lfil, rsa;
 /*-------------------- IO */
   FILE *flog = stdout, *fmat = NULL;
   io_t io;
   double tm1, tm2;
   int mat, numat, iparam, i;
+  int nthreads = 1;    /* number of threads for the matvecs */
   double terr;
   char line[MAX_LINE];
   MAT = (SMatptr)Malloc( sizeof(SMat), "main:MAT" );
+  MAT->nthreads = 1;
+  MAT->part = NULL;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
   PRE = (SPreptr)Malloc( sizeof(SPre), "main:PRE" );
 /*------------------ read and set parameters and other inputs  */
   memset( &io, 0, sizeof(io) );
@@ -88,40 +96,12 @@ int main(){
     fprintf( flog, "MATRIX: %s...\n", io.MatNam );
 /*------------------------- Read matrix */
     csmat = (csptr)Malloc( sizeof(SparMat), "main" );
-/*-------------------- case: COO formats */
-    if (io.Fmt > HB) {      
-      ierr = read_coo(&AA,&JA, &IA, &io, &rhs, &sol,0);
-      if (ierr == 0) 
-        fprintf(flog,"matrix read successfully\n");
-      else {
-	fprintf(flog, "read_coo error = %d\n", ierr);
-	exit(6);
-      }
-      n = io.ndim;
-      nnz = io.nnz;
-/*-------------------- conversion from COO to CSR format */
-      if((ierr = COOcs(n, nnz, AA, JA, IA, csmat)) != 0) {
-	fprintf(stderr, "mainARMS: COOcs error\n");
-	return ierr;
-      }
-    }
-    else if (io.Fmt == HB) {
-/*-------------------- NOTE: (AA,JA,IA) is in CSR format */
-      ierr = readhb_c(&n, &AA, &JA, &IA, &io, &rhs, &sol, &rsa);
-      if(ierr != 0) {
-	fprintf(flog, "readhb_c error = %d\n", ierr);
-	exit(7);
-      }
-      nnz = io.nnz;
-      if((ierr = CSRcs(n, AA, JA, IA, csmat, rsa)) != 0) {
-	fprintf(flog, "readhb_c: CSRcs error\n");
-	return ierr;
-      }
+    ierr = read_matrix(&io, csmat, &rhs, &sol, &rsa, 0);
+    if (ierr != 0) {
+      fprintf(flog, "read_matrix error = %d\n", ierr);
+      exit(6);
     }
-/*-------------------- free COO/HB arrays  */
-    free( AA);    AA = NULL;
-    free( JA );   JA = NULL;
-    free( IA );   IA = NULL; 
+    n = io.ndim;
 /*---------------------------------------------------------*/
     x = (double *)Malloc( io.ndim * sizeof(double), "main" );
     output_header( &io );
@@ -134,18 +114,31 @@ int main(){
       lu = (iluptr)Malloc( sizeof(ILUSpar), "main" );
       fprintf( flog, "begin iluk(%d)\n",lfil );
       tm1 = sys_timer();
-/*-------------------- call ILUK preconditioner set-up  */
-      ierr = ilukC(lfil, csmat, lu, flog );
+/*-------------------- call ILUK preconditioner set-up: symbolic
+                       phase, then numeric phase on nthreads  */
+      sym = (iluksptr)Malloc( sizeof(ILUKSym), "main" );
+      ierr = ilukSymbolic(lfil, csmat, sym, flog );
+      if( ierr == 0 ) {
+	setupILUK( lu, sym );
+	ierr = ilukNumeric(csmat, sym, lu, nthreads, flog );
+      }
 /*----------------------------------------------------- */
       tm2 = sys_timer();
       if( ierr == -2 ) {
 	fprintf( io.fout, "zero diagonal element found...\n" );
+	cleanILUKSym( sym );
 	cleanILU( lu );
 	goto NEXT_MAT;
       } else if( ierr != 0 ) {
 	fprintf( flog, "*** iluk error, ierr != 0 ***\n" );
 	exit(-1);
       }
+/*-------------------- refactor with the same symbolic phase */
+      if( check_refactor( lfil, csmat, sym, lu, nthreads, flog ) != 0 ) {
+	fprintf( flog, "*** iluk error, refactorization differs ***\n" );
+	exit(-1);
+      }
+      cleanILUKSym( sym );
       io.tm_p = tm2 - tm1;
       io.fillfact = (double)nnz_ilu( lu )/(double)(io.nnz + 1);
       fprintf( flog, "iluk ends, fill factor (mem used) = %f\n",\
@@ -184,6 +177,7 @@ int main(){
       MAT->n = n;
       MAT->CS = csmat;
       MAT->matvec = matvecCSR; 
+      setupSMat(MAT, nthreads);
       PRE->ILU = lu;
       PRE->precon = preconILU;
 /*-------------------- call fgmr */
@@ -227,8 +221,60 @@ NEXT_MAT:
   fclose( io.fout );  
   if( flog != stdout ) fclose ( flog );
   fclose( fmat );
+  free(MAT->part);
   free(MAT) ; 
   free (PRE); 
   return 0;
 }
 
+static int check_refactor( int lfil, csptr csmat, iluksptr sym, iluptr lu,
+			   int nthreads, FILE *flog )
+{
+/*-------------------------------------------------------------------
+ * Refactor lu in the pattern of sym, first for 2*csmat and then for
+ * csmat again, and compare the result with a fresh ilukC( csmat ).
+ * Returns the number of entries that differ, or -1 if a
+ * factorization fails. lu holds the factors of csmat on return.
+ *-----------------------------------------------------------------*/
+  csptr B;
+  iluptr fresh = NULL;
+  int i, j, ierr = 0, ndiff = 0;
+
+  B = (csptr)Malloc( sizeof(SparMat), "check_refactor" );
+  setupCS( B, csmat->n, 1 );
+  cscpy( csmat, B );
+  for( i = 0; i < B->n; i++ )
+    for( j = 0; j < B->nzcount[i]; j++ )
+      B->ma[i][j] *= 2.0;
+  if( ilukNumeric( B, sym, lu, nthreads, flog ) != 0 ||
+      ilukNumeric( csmat, sym, lu, nthreads, flog ) != 0 )
+    ndiff = -1;
+  cleanCS( B );
+
+  if( ndiff == 0 ) {
+    fresh = (iluptr)Malloc( sizeof(ILUSpar), "check_refactor" );
+    if( ( ierr = ilukC( lfil, csmat, fresh, flog ) ) != 0 ) ndiff = -1;
+  }
+  for( i = 0; ndiff >= 0 && i < lu->n; i++ ) {
+    if( lu->D[i] != fresh->D[i] ) ndiff++;
+    if( lu->L->nzcount[i] != fresh->L->nzcount[i] ||
+	lu->U->nzcount[i] != fresh->U->nzcount[i] ) {
+      ndiff++;
+      continue;
+    }
+    for( j = 0; j < lu->L->nzcount[i]; j++ )
+      if( lu->L->ja[i][j] != fresh->L->ja[i][j] ||
+	  lu->L->ma[i][j] != fresh->L->ma[i][j] ) ndiff++;
+    for( j = 0; j < lu->U->nzcount[i]; j++ )
+      if( lu->U->ja[i][j] != fresh->U->ja[i][j] ||
+	  lu->U->ma[i][j] != fresh->U->ma[i][j] ) ndiff++;
+  }
+  if( fresh ) {
+/*-------------------- ilukC sets up fresh unless lofC fails */
+    if( ierr == -1 ) free( fresh );
+    else cleanILU( fresh );
+  }
+  fprintf( flog, "refactorization with the same pattern: %d entries "
+	   "differ\n", ndiff );
+  return ndiff;
+}
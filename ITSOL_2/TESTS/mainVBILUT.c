@@ -12,16 +12,17 @@
 #include "globheads.h"
 #include "defs.h" 
 #include "protos.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "ios.h"  
 #include <sys/time.h>
 
 /*-------------------- protos */
 void output_header_vb( io_t *pio );
 void output_result( int lfil, io_t *pio, int iparam );
-int read_coo(double **AA, int **JA, int **IA, io_t *pio,
-             double **hs, double **ol, int job);
-int readhb_c(int *NN, double **AA, int **JA, int **IA, io_t *pio, 
-             double **rhs, double **guess, int *rsa);
+int read_matrix(io_t *pio, csptr mat, double **rhs, double **sol,
+		int *rsa, int job);
 int read_inputs( char *in_file, io_t *pio );
 int get_matrix_info( FILE *fmat, io_t *pio );
 void randvec (double *v, int n);
@@ -44,11 +45,9 @@ int main() {
   SMatptr MAT;         /* Matrix structure for matvecs    */
   SPreptr PRE;         /* general precond structure       */
   double *sol = NULL, *x = NULL, *prhs = NULL, *rhs = NULL;
-/*-------------------- temp COO/HB arrays - fortran style */
-  int *IA, *JA; 
-  double *AA;
+/*-------------------- matrix size, rsa = 1 for a symmetric HB matrix */
 /*---------------------------------------------------------*/
-  int n, nnz, rsa; 
+  int n, rsa; 
   BData *w = NULL;
   int lfil, max_blk_sz = MAX_BLOCK_SIZE*MAX_BLOCK_SIZE*sizeof(double);
   int nBlock, *nB = NULL, *perm = NULL;
@@ -59,9 +58,15 @@ int main() {
 /*---------------------------------------------------------*/
   double tm1, tm2;
   int mat, numat, iparam, i;
+  int nthreads = 1;    /* number of threads for the matvecs */
   double terr;
   char line[MAX_LINE];
   MAT = (SMatptr)Malloc( sizeof(SMat), "main:MAT" );
+  MAT->nthreads = 1;
+  MAT->part = NULL;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
   PRE = (SPreptr)Malloc( sizeof(SPre), "main:PRE" );
 /*------------------ read and set parameters and other inputs  */
   memset( &io, 0, sizeof(io) );
@@ -102,40 +107,12 @@ int main() {
     fprintf( flog, "MATRIX: %s...\n", io.MatNam );
 /* ------------------- Read in matrix and allocate memory--------*/
     csmat = (csptr)Malloc( sizeof(SparMat), "main" );
-/*-------------------- case: COO formats */
-    if (io.Fmt > HB) {      
-      ierr = read_coo(&AA,&JA, &IA, &io, &rhs, &sol,0);
-      if (ierr == 0) 
-        fprintf(flog,"matrix read successfully\n");
-      else {
-	fprintf(flog, "read_coo error = %d\n", ierr);
-	exit(6);
-      }
-      n = io.ndim;
-      nnz = io.nnz;
-/*-------------------- conversion from COO to CSR format */
-      if((ierr = COOcs(n, nnz, AA, JA, IA, csmat)) != 0) {
-	fprintf(stderr, "mainARMS: COOcs error\n");
-	return ierr;
-      }
-    }
-    else if (io.Fmt == HB) {
-/*-------------------- NOTE: (AA,JA,IA) is in CSR format */
-      ierr = readhb_c(&n, &AA, &JA, &IA, &io, &rhs, &sol, &rsa);
-      if(ierr != 0) {
-	fprintf(flog, "readhb_c error = %d\n", ierr);
-	exit(7);
-      }
-      nnz = io.nnz;
-      if((ierr = CSRcs(n, AA, JA, IA, csmat, rsa)) != 0) {
-	fprintf(flog, "readhb_c: CSRcs error\n");
-	return ierr;
-      }
+    ierr = read_matrix(&io, csmat, &rhs, &sol, &rsa, 0);
+    if (ierr != 0) {
+      fprintf(flog, "read_matrix error = %d\n", ierr);
+      exit(6);
     }
-/*----------------------- Free Memory */
-    free( AA);    AA = NULL;
-    free( JA );   JA = NULL;
-    free( IA );   IA = NULL;
+    n = io.ndim;
 /*----------------------- Daigonal Scaling */    
     if (diagscal ==1) {  
       int nrm=1;
@@ -261,6 +238,7 @@ int main() {
       MAT->n = n;
       MAT->CS = csmat;
       MAT->matvec = matvecCSR; 
+      setupSMat(MAT, nthreads);
       PRE->VBILU = lu; 
       PRE->precon = preconVBR;
 /*-------------------- call fgmr */
@@ -317,6 +295,7 @@ NEXT_MAT:
   if( flog != stdout ) fclose ( flog );
   fclose( fmat );
   
+  free(MAT->part);
   free(MAT);
   free(PRE);
   return 0;
@@ -8,6 +8,15 @@ function [x, flag, iter, resids, times] = bicgstabMILU(varargin)
 %    x = bicgstabMILU(rowptr, colind, vals, b) takes a matrix in the CRS
 %    format instead of MATLAB's built-in sparse format.
 %
+%    x = bicgstabMILU(Afunc, b, ..., 'precmat', P) solves the system with
+%    a matrix-free A given by the function handle Afunc, which returns
+%    A*x, and builds the preconditioner from the assembled approximation P
+%    of A. It uses the kernel bicgstabMILU_MF, and 'fused' and 'sell' are
+%    ignored. The compiled kernel takes a C callback, into which MILUafunc
+%    wraps Afunc. Afunc can also be such a callback object, created by
+%    MILUafunc or by C code (see milu_afunc.h), in which case the compiled
+%    kernel is required.
+%
 %    x = bicgstabMILU(A, b, rtol)
 %    x = bicgstabMILU(rowptr, colind, vals, b, rtol)
 %    specifies the relative tolerance and the maximum number of iterations.
@@ -63,6 +72,26 @@ function [x, flag, iter, resids, times] = bicgstabMILU(varargin)
 %
 %   'nthreads' [1]: Maximal number of threads to use
 %
+%   'fused' [nthreads>1]: Whether to use the kernel that runs the whole
+%    iteration in a single parallel region and fuses the inner products
+%    into the SpMVs and vector updates. See bicgstabMILU_fused.
+%
+%   'ell' [1]: Degree of the minimal residual polynomial. If greater than
+%    one (typically 2 or 4), BiCGSTAB(ell) is used, which converges on
+%    many problems with complex spectra on which BiCGSTAB stagnates, with
+%    2*(ell+1) vectors of memory in addition to those of BiCGSTAB. Each
+%    iteration still performs two SpMVs and two solves with the
+%    preconditioner. 'fused' is ignored. See bicgstablMILU_kernel.
+%
+%   'sell' [0]: Number of rows per slice (at most 16) of the SELL-C-sigma
+%    format. If positive, A is converted once and the kernel multiplies by
+%    A in that format with a vectorized loop, unless the padding exceeds
+%    20% of the nonzeros, in which case the CRS format is used.
+%
+%   'precmat' [none]: Assembled approximation of A in MATLAB's built-in
+%    sparse format or in CRS format, from which the preconditioner is
+%    built when A is matrix-free.
+%
 %    [x, flag] = bicgstabMILU(...) returns a convergence flag.
 %    flag  0 - solution found to tolerance
 %          1 - no convergence given max_it
@@ -85,7 +114,11 @@ if nargin == 0
     return;
 end
 
-if issparse(varargin{1})
+if isa(varargin{1}, 'function_handle') || isstruct(varargin{1}) && ...
+        isfield(varargin{1}, 'nitems')
+    A = varargin{1};
+    next_index = 2;
+elseif issparse(varargin{1})
     A = crs_matrix(varargin{1});
     next_index = 2;
 elseif isstruct(varargin{1})
@@ -108,6 +141,10 @@ rtol = 1.e-6;
 maxit = int32(500);
 x0 = cast([], class(b));
 nthreads = int32(1);
+fused = [];
+sell = int32(0);
+ell = int32(1);
+precmat = [];
 
 params_start = nargin;
 for i = next_index+1:nargin
@@ -144,6 +181,14 @@ for i = params_start:2:length(varargin)-1
             verbose = int32(varargin{i+1});
         case 'nthreads'
             nthreads = int32(varargin{i+1});
+        case 'fused'
+            fused = logical(varargin{i+1});
+        case 'ell'
+            ell = int32(varargin{i+1});
+        case 'sell'
+            sell = int32(varargin{i+1});
+        case 'precmat'
+            precmat = varargin{i+1};
         case 'ordering'
             options.ordering = varargin{i+1};
         case 'droptol'
@@ -164,7 +209,33 @@ if ~isfield(options, 'droptolS')
     options.droptolS = options.droptol * 0.1;
 end
 
-compiled = exist(['bicgstabMILU_kernel.' mexext], 'file');
+if isempty(fused)
+    fused = nthreads > 1;
+end
+
+matfree = ~isfield(A, 'row_ptr');
+if matfree && isempty(precmat)
+    error('A matrix-free A requires an approximation of A in ''precmat''.');
+end
+
+if matfree
+    kernel = 'bicgstabMILU_MF';
+elseif ell > 1
+    kernel = 'bicgstablMILU_kernel';
+elseif fused
+    kernel = 'bicgstabMILU_fused';
+else
+    kernel = 'bicgstabMILU_kernel';
+end
+kernel_func = eval(['@' kernel]);
+
+% A function handle is passed to the compiled kernel as a callback
+% object created by MILUafunc
+compiled = exist([kernel '.' mexext], 'file') && ...
+    (~isa(A, 'function_handle') || exist(['MILUafunc.' mexext], 'file'));
+if matfree && ~compiled && ~isa(A, 'function_handle')
+    error('A MILU_Afunc object requires the compiled kernel bicgstabMILU_MF.');
+end
 
 if verbose
     fprintf(1, 'Performing ILU facotirzation...\n');
@@ -173,10 +244,24 @@ end
 % Perform ILU factorization
 times = zeros(2, 1);
 tic;
+if matfree
+    factor_args = {precmat};
+else
+    factor_args = varargin(1:next_index-1);
+end
 if compiled
-    [M, newoptions] = MILUfactor(varargin{1:next_index-1}, options);
+    [M, newoptions] = MILUfactor(factor_args{:}, options);
 else
-    [~, newoptions, M] = MILUfactor(varargin{1:next_index-1}, options);
+    [~, newoptions, M] = MILUfactor(factor_args{:}, options);
+end
+
+% Partition the rows among the threads by their numbers of nonzeros, and
+% convert A into the SELL-C-sigma format if requested and if it pays off
+if ~matfree
+    op = MILUoperator(A, nthreads, sell);
+    if verbose && sell > 0 && op.sell.nrows == 0
+        fprintf(1, 'Row lengths are too irregular for SELL-C-sigma. Using CRS.\n');
+    end
 end
 times(1) = toc;
 
@@ -196,8 +281,20 @@ if verbose
 end
 
 tic;
-[x, flag, iter, resids] = bicgstabMILU_kernel(A, b, M, ...
-    rtol, maxit, x0, verbose, nthreads);
+if matfree
+    if compiled && isa(A, 'function_handle')
+        A = MILUafunc(A);
+        cleanup = onCleanup(@() MILUafunc(A)); %#ok<NASGU>
+    end
+    [x, flag, iter, resids] = kernel_func(A, b, M, ...
+        rtol, maxit, x0, verbose);
+elseif ell > 1
+    [x, flag, iter, resids] = kernel_func(A, b, M, ell, ...
+        rtol, maxit, x0, verbose, nthreads, op);
+else
+    [x, flag, iter, resids] = kernel_func(A, b, M, ...
+        rtol, maxit, x0, verbose, nthreads, op);
+end
 
 times(2) = toc;
 
@@ -234,5 +331,40 @@ function test %#ok<DEFNU>
 %! [x, flag, iter, resids] = bicgstabMILU(A, b, 'rtol', rtol, ...
 %!         'maxit', 100);
 %! assert(norm(b - A*x) <= rtol * norm(b))
+%!
+%!test
+%! [x, flag, iter, resids] = bicgstabMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'fused', true);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%!
+%!test
+%! [x, flag, iter, resids] = bicgstabMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'fused', false, 'sell', 8);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%!
+%!test
+%! [x, flag, iter, resids] = bicgstabMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'ell', 2);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%!
+%!test
+%! [x, flag, iter, resids] = bicgstabMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'ell', 4, 'nthreads', 2, 'sell', 8);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%!
+%!test
+%! [x, flag, iter, resids] = bicgstabMILU(@(x) A*x, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'precmat', A);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%!
+%!test
+%! if exist(['MILUafunc.' mexext], 'file') && ...
+%!         exist(['bicgstabMILU_MF.' mexext], 'file')
+%!     Afunc = MILUafunc(A);
+%!     [x, flag, iter, resids] = bicgstabMILU(Afunc, b, 'rtol', rtol, ...
+%!             'maxit', 100, 'precmat', A);
+%!     MILUafunc(Afunc);
+%!     assert(norm(b - A*x) <= rtol * norm(b))
+%! end
 
 end
@@ -1,4 +1,4 @@
-function [x, flag, iter, resids, times] = gmresMILU(varargin)
+function [x, flag, iter, resids, times, recycle, ws] = gmresMILU(varargin)
 % gmresMILU GMRES with MILU as right preconditioner
 %
 %    x = gmresMILU(A, b) solves a sparse linear system using ILUPACK's
@@ -8,6 +8,23 @@ function [x, flag, iter, resids, times] = gmresMILU(varargin)
 %    x = gmresMILU(rowptr, colind, vals, b) takes a matrix in the CRS
 %    format instead of MATLAB's built-in sparse format.
 %
+%    x = gmresMILU(Afunc, b, ..., 'precmat', P) solves the system with a
+%    matrix-free A given by the function handle Afunc, which returns A*x,
+%    and builds the preconditioner from the assembled approximation P of
+%    A. It uses modified Gram-Schmidt, and 'orth' and 'sell' are ignored.
+%    The compiled kernel gmresMILU_MF takes a C callback, into which
+%    MILUafunc wraps Afunc. Afunc can also be such a callback object,
+%    created by MILUafunc or by C code (see milu_afunc.h), in which case
+%    the compiled kernel is required.
+%
+%    X = gmresMILU(A, B) solves for all columns of an n-by-k matrix B at
+%    once using block GMRES. The columns share one block Krylov subspace,
+%    so that each iteration performs one pass over A and the factors of
+%    the preconditioner for the whole block. Converged columns are
+%    deflated at restarts. In this case, restart refers to the number of
+%    block iterations, the orthogonalization is always 'MGS', and resids
+%    is a matrix with one column per right-hand side.
+%
 %    x = gmresMILU(A, b, restart)
 %    x = gmresMILU(rowptr, colind, vals, b, restart)
 %    specifies the number of iterations before GMRES restarts. If restart
@@ -39,6 +56,18 @@ function [x, flag, iter, resids, times] = gmresMILU(varargin)
 %
 %   'restart' [30]:   Number of iterations before restart
 %
+%   'adaptive' [false]: Whether to vary the restart length between cycles.
+%    It starts with restart and, based on the residual reduction of each
+%    cycle, grows the subspace to the maximum allowed by 'maxmem' when
+%    GMRES is close to stagnation and shrinks it by 3 when it converges
+%    well, trading orthogonalization cost against convergence (see Baker,
+%    Jessup, and Kolev, J. Comput. Appl. Math., 2009). It does not apply
+%    to block GMRES, GCRO-DR, mixed precision, or a matrix-free A.
+%
+%   'maxmem' [none]: Memory cap in megabytes for the Krylov subspace and
+%    the preconditioned subspace in adaptive mode. By default, the
+%    maximum restart length is max(restart, 100).
+%
 %   'rtol' [1.e-6]:   Relative tolerance for converegnce
 %
 %   'maxiter' [500]:  Maximum number of iterations
@@ -76,6 +105,49 @@ function [x, flag, iter, resids, times] = gmresMILU(varargin)
 %
 %   'nthreads' [1]: Maximal number of threads to use
 %
+%   'nrecycle' [0]: Dimension of the recycled Krylov subspace. If positive,
+%    GCRO-DR is used, which deflates the harmonic Ritz vectors of smallest
+%    magnitude at each restart and returns them for use in the next solve.
+%    It does not apply to multiple right-hand sides.
+%
+%   'recycle' [none]: Recycled subspace returned by a previous call to
+%    gmresMILU for a related system (with slowly changing A or b). It
+%    implies GCRO-DR with 'nrecycle' defaulting to the size of the space,
+%    so it cannot be combined with multiple right-hand sides either.
+%
+%   'workspace' [none]: Workspace returned by a previous call to gmresMILU
+%    with the same 'orth' for a system of the same size. Its buffers are
+%    reused without reallocation or clearing, which avoids the cost of
+%    allocating the Krylov subspaces in repeated solves.
+%
+%   'poly' [0]: Degree plus one of a GMRES polynomial preconditioner p
+%    stacked on MILU, so that GMRES is applied to A*M\p(A/M). The roots
+%    of p are the harmonic Ritz values from an initial Arnoldi run of
+%    that length. Each iteration then performs poly products with A and
+%    poly+1 solves with M but no additional reductions, which reduces the
+%    number of iterations and thus the global reductions on many cores.
+%    Values of 4 to 10 are typical. It applies to the single-RHS
+%    kernels with 'orth' 'HO', 'MGS' or 'CGS'. See MILUpoly.
+%
+%   'precision' ['double']: Precision of the Krylov solver.
+%          'double' - compute everything in double precision
+%          'mixed'  - use iterative refinement, in which the residuals and
+%                     the solution are computed in double precision, and
+%                     each correction by one cycle of GMRES with the Krylov
+%                     bases and the products with A in single precision.
+%                     This halves the memory of the bases. It does not
+%                     apply to block GMRES, GCRO-DR, or a matrix-free A.
+%
+%   'precmat' [none]: Assembled approximation of A in MATLAB's built-in
+%    sparse format or in CRS format, from which the preconditioner is
+%    built when A is matrix-free.
+%
+%   'sell' [0]: Number of rows per slice (at most 16) of the SELL-C-sigma
+%    format. If positive, A is converted once and the kernel multiplies by
+%    A in that format with a vectorized loop, unless the padding exceeds
+%    20% of the nonzeros, in which case the CRS format is used. It
+%    does not apply to block GMRES or mixed precision.
+%
 %    [x, flag] = gmresMILU(...) returns a convergence flag.
 %    flag: 0 - converged to the desired tolerance TOL within MAXIT iterations.
 %          1 - iterated maxit times but did not converge.
@@ -89,6 +161,14 @@ function [x, flag, iter, resids, times] = gmresMILU(varargin)
 %    [x, flag, iter, resids, times] = gmresMILU(...) returns the setup
 %    time (times(1)) and solve time (times(2)) in seconds.
 %
+%    [x, flag, iter, resids, times, recycle] = gmresMILU(...) returns the
+%    recycled subspace, a struct with fields U and C with C = A*M\U and
+%    orthonormal C, which can be passed to the next solve via 'recycle'.
+%
+%    [x, flag, iter, resids, times, recycle, ws] = gmresMILU(...) returns
+%    the workspace of the solver, which can be passed to the next solve
+%    via 'workspace'. See gmresMILU_workspace.
+%
 %  See also bicgstabMILU
 
 if nargin == 0
@@ -96,7 +176,12 @@ if nargin == 0
     return;
 end
 
-if issparse(varargin{1})
+if isa(varargin{1}, 'function_handle') || isstruct(varargin{1}) && ...
+        isfield(varargin{1}, 'nitems')
+    % A function handle or a MILU_Afunc object
+    A = varargin{1};
+    next_index = 2;
+elseif issparse(varargin{1})
     A = crs_matrix(varargin{1});
     next_index = 2;
 elseif isstruct(varargin{1})
@@ -121,6 +206,15 @@ restart = int32(30);
 x0 = cast([], class(b));
 nthreads = int32(1);
 orth = 'MGS';
+nrecycle = int32(-1);
+recycle = struct('U', zeros(size(b, 1), 0), 'C', zeros(size(b, 1), 0));
+ws = [];
+sell = int32(0);
+precmat = [];
+precision = 'double';
+adaptive = false;
+maxmem = [];
+poly = int32(0);
 
 params_start = nargin;
 for i = next_index+1:nargin
@@ -169,6 +263,24 @@ for i = params_start:2:length(varargin)-1
             orth = varargin{i+1};
         case 'nthreads'
             nthreads = int32(varargin{i+1});
+        case 'nrecycle'
+            nrecycle = int32(varargin{i+1});
+        case 'recycle'
+            recycle = varargin{i+1};
+        case 'workspace'
+            ws = varargin{i+1};
+        case 'sell'
+            sell = int32(varargin{i+1});
+        case 'precmat'
+            precmat = varargin{i+1};
+        case 'precision'
+            precision = lower(varargin{i+1});
+        case 'poly'
+            poly = int32(varargin{i+1});
+        case 'adaptive'
+            adaptive = logical(varargin{i+1});
+        case 'maxmem'
+            maxmem = double(varargin{i+1});
         case 'ordering'
             options.ordering = varargin{i+1};
         case 'droptol'
@@ -189,10 +301,68 @@ if ~isfield(options, 'droptolS')
     options.droptolS = options.droptol * 0.1;
 end
 
-kernel = ['gmresMILU_', orth];
+if nrecycle < 0
+    nrecycle = int32(size(recycle.U, 2));
+end
+
+if size(b, 2) > 1 && nrecycle > 0
+    error('Multiple RHS do not support recycling.');
+end
+
+matfree = ~isfield(A, 'row_ptr');
+if matfree && isempty(precmat)
+    error('A matrix-free A requires an approximation of A in ''precmat''.');
+elseif matfree && (size(b, 2) > 1 || nrecycle > 0)
+    error('A matrix-free A supports neither multiple RHS nor recycling.');
+end
+
+mixed = strcmp(precision, 'mixed');
+if mixed && (matfree || size(b, 2) > 1 || nrecycle > 0)
+    error('Mixed precision supports neither a matrix-free A, multiple RHS, nor recycling.');
+elseif ~mixed && ~strcmp(precision, 'double')
+    error('Unknown precision "%s"', precision);
+end
+
+if adaptive && (matfree || mixed || size(b, 2) > 1 || nrecycle > 0)
+    error('Adaptive restart supports neither a matrix-free A, mixed precision, multiple RHS, nor recycling.');
+end
+
+% Maximum restart length for the adaptive mode. V and Z take 16 bytes
+% per row and column.
+max_restart = restart;
+if adaptive
+    n = size(b, 1);
+    if isempty(maxmem)
+        max_restart = int32(min(n, max(double(restart), 100)));
+    else
+        max_restart = int32(min(n, floor(maxmem * 2^20 / (16 * n))));
+        if max_restart < 1
+            error('The memory cap ''maxmem'' is too small for a single Krylov vector.');
+        end
+    end
+    restart = min(restart, max_restart);
+end
+
+if matfree
+    kernel = 'gmresMILU_MF';
+elseif mixed
+    kernel = 'gmresMILU_IR';
+elseif size(b, 2) > 1
+    kernel = 'gmresMILU_block';
+elseif nrecycle > 0
+    kernel = 'gmresMILU_DR';
+else
+    kernel = ['gmresMILU_', orth];
+end
 kernel_func = eval(['@' kernel]);
 
-compiled = exist([kernel '.' mexext], 'file');
+% A function handle is passed to the compiled kernel as a callback
+% object created by MILUafunc
+compiled = exist([kernel '.' mexext], 'file') && ...
+    (~isa(A, 'function_handle') || exist(['MILUafunc.' mexext], 'file'));
+if matfree && ~compiled && ~isa(A, 'function_handle')
+    error('A MILU_Afunc object requires the compiled kernel gmresMILU_MF.');
+end
 
 if verbose
     fprintf(1, 'Performing ILU facotirzation...\n');
@@ -201,10 +371,32 @@ end
 % Perform ILU factorization
 times = zeros(2, 1);
 tic;
+if matfree
+    factor_args = {precmat};
+else
+    factor_args = varargin(1:next_index-1);
+end
 if compiled
-    [M, newoptions] = MILUfactor(varargin{1:next_index-1}, options);
+    [M, newoptions] = MILUfactor(factor_args{:}, options);
 else
-    [~, newoptions, M] = MILUfactor(varargin{1:next_index-1}, options);
+    [~, newoptions, M] = MILUfactor(factor_args{:}, options);
+end
+
+% Partition the rows among the threads by their numbers of nonzeros, and
+% convert A into the SELL-C-sigma format if requested and if it pays off
+if ~matfree
+    if size(b, 2) > 1 || mixed
+        sell = int32(0);
+    end
+    op = MILUoperator(A, nthreads, sell);
+    if verbose && sell > 0 && op.sell.nrows == 0
+        fprintf(1, 'Row lengths are too irregular for SELL-C-sigma. Using CRS.\n');
+    end
+
+    % Add the polynomial preconditioner
+    if poly > 1 && size(b, 2) == 1 && nrecycle == 0 && ~mixed
+        op.poly = MILUpoly(A, M, poly, b);
+    end
 end
 times(1) = toc;
 
@@ -224,8 +416,35 @@ if verbose
 end
 
 tic;
-[x, flag, iter, resids] = kernel_func(A, b, M, ...
-    restart, rtol, maxit, x0, verbose, nthreads);
+if matfree
+    if isempty(ws)
+        ws = gmresMILU_workspace(int32(size(b, 1)), restart, maxit, M);
+    end
+    if compiled && isa(A, 'function_handle')
+        A = MILUafunc(A);
+        cleanup = onCleanup(@() MILUafunc(A)); %#ok<NASGU>
+    end
+    [x, flag, iter, resids, ws] = kernel_func(A, b, M, ...
+        restart, rtol, maxit, x0, verbose, nthreads, ws);
+elseif mixed
+    [x, flag, iter, resids] = kernel_func(A, b, M, ...
+        restart, rtol, maxit, x0, verbose, nthreads, op);
+elseif nrecycle > 0
+    [x, flag, iter, resids, recycle.U, recycle.C] = kernel_func(A, b, M, ...
+        restart, rtol, maxit, x0, verbose, nthreads, nrecycle, recycle.U, op);
+elseif adaptive
+    [x, flag, iter, resids, ws] = gmres_adaptive(kernel_func, A, b, M, ...
+        restart, max_restart, rtol, maxit, x0, verbose, nthreads, ws, op);
+elseif size(b, 2) == 1
+    if isempty(ws)
+        ws = gmresMILU_workspace(int32(size(b, 1)), restart, maxit, M);
+    end
+    [x, flag, iter, resids, ws] = kernel_func(A, b, M, ...
+        restart, rtol, maxit, x0, verbose, nthreads, ws, op);
+else
+    [x, flag, iter, resids] = kernel_func(A, b, M, ...
+        restart, rtol, maxit, x0, verbose, nthreads, op);
+end
 times(2) = toc;
 
 if verbose
@@ -244,6 +463,74 @@ end
 
 end
 
+function [x, flag, iter, resids, ws] = gmres_adaptive(kernel_func, A, b, M, ...
+    restart, max_restart, rtol, maxit, x0, verbose, nthreads, ws, op)
+% Run one GMRES cycle per call of the kernel and choose the restart length
+% of the next cycle from the ratio cr of the residual norms at the ends of
+% the last two cycles, following Baker, Jessup, and Kolev: if cr is above
+% cos(8 degrees), use the maximum length; if cr is below cos(80 degrees),
+% keep the length; otherwise, decrease it by 3, or jump to the maximum if
+% it would drop below the minimum. The workspace is allocated once for
+% the maximum length and reused in all cycles.
+
+max_cr = cos(8 * pi / 180);
+min_cr = cos(80 * pi / 180);
+d = int32(3);
+min_restart = min(int32(3), max_restart);
+
+n = int32(size(b, 1));
+if isempty(ws)
+    ws = gmresMILU_workspace(n, max_restart, maxit, M);
+else
+    ws = gmresMILU_workspace(n, max_restart, maxit, M, ws);
+end
+
+x = x0;
+m = restart;
+flag = int32(1);
+iter = int32(0);
+resids = zeros(0, 1);
+resid_prev = [];
+while iter < maxit
+    [x, flag, its, res, ws] = kernel_func(A, b, M, m, rtol, ...
+        min(m, maxit - iter), x, int32(0), nthreads, ws, op);
+    if its == 0
+        break
+    end
+    iter = iter + its;
+    resids = [resids; res(:)]; %#ok<AGROW>
+    resid = res(end);
+
+    if verbose
+        fprintf(1, 'At iteration %d, relative residual is %g with restart %d.\n', ...
+            iter, resid, m);
+    end
+
+    if resid <= rtol * (1 + 1.e-8)
+        flag = int32(0);
+        break
+    elseif flag == 3
+        break
+    end
+    flag = int32(1);
+
+    if ~isempty(resid_prev)
+        cr = resid / resid_prev;
+        if cr > max_cr
+            m = max_restart;
+        elseif cr >= min_cr
+            if m - d >= min_restart
+                m = m - d;
+            else
+                m = max_restart;
+            end
+        end
+    end
+    resid_prev = resid;
+end
+
+end
+
 function test %#ok<DEFNU>
 %!test
 %!shared A, b, rtol
@@ -272,4 +559,69 @@ function test %#ok<DEFNU>
 %!         'maxit', 100, 'orth', 'HO');
 %! assert(norm(b - A*x) <= rtol * norm(b))
 
+%!test
+%! [x, flag, iter, resids, ~, recycle] = gmresMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'nrecycle', 10);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%! b2 = b + 1.e-3 * ones(size(b));
+%! [x, flag, iter2] = gmresMILU(A, b2, 'rtol', rtol, ...
+%!         'maxit', 100, 'recycle', recycle);
+%! assert(norm(b2 - A*x) <= rtol * norm(b2))
+%! [~, ~, iter0] = gmresMILU(A, b2, 'rtol', rtol, 'maxit', 100);
+%! assert(iter2 <= iter0)
+
+%!test
+%! [x, flag, iter, resids, ~, ~, ws] = gmresMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'orth', 'MGS');
+%! [x, flag, iter2] = gmresMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'orth', 'MGS', 'workspace', ws);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%! assert(iter2 == iter)
+
+%!test
+%! [x, flag, iter, resids] = gmresMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'sell', 8);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+
+%!test
+%! [x, flag, iter, resids] = gmresMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'restart', 10, 'adaptive', true, 'maxmem', 16);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+
+%!test
+%! [x, flag, iter, resids] = gmresMILU(A, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'poly', 5);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+%! [~, ~, iter0] = gmresMILU(A, b, 'rtol', rtol, 'maxit', 100);
+%! assert(iter < iter0)
+
+%!test
+%! [x, flag, iter, resids] = gmresMILU(A, b, 'rtol', 1.e-12, ...
+%!         'maxit', 200, 'precision', 'mixed');
+%! assert(norm(b - A*x) <= 1.e-12 * norm(b))
+
+%!test
+%! [x, flag, iter, resids] = gmresMILU(@(x) A*x, b, 'rtol', rtol, ...
+%!         'maxit', 100, 'precmat', A);
+%! assert(norm(b - A*x) <= rtol * norm(b))
+
+%!test
+%! if exist(['MILUafunc.' mexext], 'file') && ...
+%!         exist(['gmresMILU_MF.' mexext], 'file')
+%!     % A C function pointer that multiplies by a copy of A
+%!     Afunc = MILUafunc(A);
+%!     assert(norm(MILUafunc(Afunc, b) - A*b) <= 1.e-12 * norm(A*b))
+%!     [x, flag, iter, resids] = gmresMILU(Afunc, b, 'rtol', rtol, ...
+%!             'maxit', 100, 'precmat', A);
+%!     MILUafunc(Afunc);
+%!     assert(norm(b - A*x) <= rtol * norm(b))
+%! end
+
+%!test
+%! B = [b, A*ones(size(b)), b];
+%! [X, flag, iter, resids] = gmresMILU(A, B, 'rtol', rtol, 'maxit', 100);
+%! for i = 1:size(B, 2)
+%!     assert(norm(B(:, i) - A*X(:, i)) <= rtol * norm(B(:, i)))
+%! end
+
 end
@@ -0,0 +1,174 @@
+function [X, flags, iters, times] = gmresMILUbatch(As, bs, varargin)
+% gmresMILUbatch Solve many independent systems with GMRES and MILU
+%
+%    X = gmresMILUbatch(As, bs) solves the linear systems As{k}*X{k} = bs{k}
+%    for all k, where As is a cell array of matrices in MATLAB's built-in
+%    sparse format or in CRS format created using crs_matrix, and bs is a
+%    cell array of right-hand sides. Every system has its own multilevel
+%    ILU preconditioner. The systems are solved concurrently, one system
+%    per thread, using GMRES with modified Gram-Schmidt. This is more
+%    efficient than calling gmresMILU in a loop when the systems are
+%    small, since the kernels do not scale well at small sizes.
+%
+%    X = gmresMILUbatch(As, bs, 'name', value, ...) specifies parameters in
+%    the form 'param1_name', param1_value, and so on. The parameter names
+%    are not case sensitive. Available parameters and their default
+%    values (enclosed by '[' and ']') are as follows:
+%
+%   'restart' [30]:   Number of iterations before restart
+%
+%   'rtol' [1.e-6]:   Relative tolerance for converegnce
+%
+%   'maxiter' [500]:  Maximum number of iterations of each system
+%
+%   'verb' [1]:  Verbosity level.
+%          0 - silent
+%          1 - summary of the setup and the solves
+%
+%   'nthreads' [1]: Maximal number of threads to use. Each thread solves
+%    whole systems, so it should not exceed the number of systems.
+%
+%   'ordering', 'condest', 'droptol', 'droptols': Parameters of the ILU
+%    factorization. See gmresMILU.
+%
+%    [X, flags] = gmresMILUbatch(...) returns the convergence flag of each
+%    system. See gmresMILU for their meanings.
+%
+%    [X, flags, iters] = gmresMILUbatch(...) returns the iteration count
+%    of each system.
+%
+%    [X, flags, iters, times] = gmresMILUbatch(...) returns the setup time
+%    (times(1)) and solve time (times(2)) in seconds.
+%
+%  Note: The factorizations are computed one after another, since ILUPACK
+%  is not reentrant.
+%
+%  See also gmresMILU
+
+if nargin == 0
+    help gmresMILUbatch
+    return;
+end
+
+if ~iscell(As) || ~iscell(bs) || numel(As) ~= numel(bs)
+    error('As and bs must be cell arrays of the same length.');
+end
+
+% Initialize default arguments
+verbose = int32(1);
+rtol = 1.e-6;
+maxit = int32(500);
+restart = int32(30);
+nthreads = int32(1);
+
+% Process argument-value pairs to update arguments
+options = struct('ordering', 'amd', 'droptol', 0.001, 'condest', 5);
+for i = 1:2:length(varargin)-1
+    switch lower(varargin{i})
+        case {'maxit', 'maxiter'}
+            maxit = int32(varargin{i+1});
+        case {'restart', 'nrestart'}
+            restart = int32(varargin{i+1});
+        case {'rtol', 'reltol'}
+            rtol = varargin{i+1};
+        case {'verb', 'verbose'}
+            verbose = int32(varargin{i+1});
+        case 'nthreads'
+            nthreads = int32(varargin{i+1});
+        case 'ordering'
+            options.ordering = varargin{i+1};
+        case 'droptol'
+            options.droptol = double(varargin{i+1});
+        case 'condest'
+            options.condest = double(varargin{i+1});
+        case 'droptols'
+            options.droptolS = double(varargin{i+1});
+        otherwise
+            error('Unknown tuning parameter "%s"', varargin{i});
+    end
+end
+
+if ~isfield(options, 'droptolS')
+    options.droptolS = options.droptol * 0.1;
+end
+
+kernel = 'gmresMILU_batch';
+compiled = exist([kernel '.' mexext], 'file');
+
+nsys = numel(As);
+if verbose
+    fprintf(1, 'Performing ILU factorization of %d systems...\n', nsys);
+end
+
+% Concatenate the matrices, the right-hand sides and the levels of the
+% preconditioners, and compute the offsets of every system
+times = zeros(2, 1);
+tic;
+bptr = ones(nsys + 1, 1, 'int32');
+mptr = ones(nsys + 1, 1, 'int32');
+Ac = cell(nsys, 1);
+Mc = cell(nsys, 1);
+for k = 1:nsys
+    if issparse(As{k})
+        Ac{k} = crs_matrix(As{k});
+    else
+        Ac{k} = As{k};
+    end
+    if compiled
+        Mc{k} = MILUfactor(As{k}, options);
+    else
+        [~, ~, Mc{k}] = MILUfactor(As{k}, options);
+    end
+    bptr(k+1) = bptr(k) + int32(size(bs{k}, 1));
+    mptr(k+1) = mptr(k) + int32(numel(Mc{k}));
+end
+Aall = vertcat(Ac{:});
+Mall = vertcat(Mc{:});
+b = vertcat(bs{:});
+times(1) = toc;
+
+if verbose
+    fprintf(1, 'Finished ILU factorization in %.1f seconds \n', times(1));
+    fprintf(1, 'Starting Krylov solvers ...\n');
+end
+
+tic;
+[x, flags, iters] = gmresMILU_batch(Aall, b, bptr, Mall, mptr, ...
+    restart, rtol, maxit, nthreads);
+times(2) = toc;
+
+X = cell(size(bs));
+for k = 1:nsys
+    X{k} = x(bptr(k):bptr(k+1)-1);
+end
+
+if verbose
+    fprintf(1, 'Finished %d solves in %.1f seconds, of which %d converged.\n', ...
+        nsys, times(2), sum(flags == 0));
+end
+
+if ~compiled
+    for k = 1:nsys
+        Mc{k} = ILUdelete(Mc{k});
+    end
+end
+
+end
+
+function test %#ok<DEFNU>
+%!test
+%! rtol = 1.e-6;
+%! As = cell(8, 1);
+%! bs = cell(8, 1);
+%! for k = 1:numel(As)
+%!     n = 50 * k;
+%!     As{k} = gallery('tridiag', n, -1, 2 + 0.1 * k, -1);
+%!     bs{k} = As{k} * ones(n, 1);
+%! end
+%! [X, flags] = gmresMILUbatch(As, bs, 'rtol', rtol, 'nthreads', 4);
+%! assert(all(flags == 0))
+%! for k = 1:numel(As)
+%!     assert(norm(bs{k} - As{k}*X{k}) <= rtol * norm(bs{k}))
+%! end
+
+end
@@ -0,0 +1,27 @@
+#ifndef _MILU_AFUNC_H
+#define _MILU_AFUNC_H
+
+/*
+ * Matrix-free operator for the compiled Krylov kernels gmresMILU_MF and
+ * bicgstabMILU_MF. The function apply must compute y = A*x for vectors
+ * of length n. ctx is passed through unchanged, e.g. to the data of a
+ * Jacobian-vector product.
+ *
+ * The kernels call apply from the thread that called them, i.e. the
+ * master thread of their parallel region. apply may use OpenMP itself,
+ * but its threads are then nested in that region, so pass nthreads = 1
+ * to the kernels to leave all threads to apply. MILUafunc creates such
+ * operators in MATLAB from a function handle or a sparse matrix.
+ */
+typedef struct MILU_Afunc_t {
+    void (*apply)(void *ctx, const double *x, double *y, int n);
+    void *ctx;
+} MILU_Afunc_t;
+
+static inline void MILU_Afunc_apply(MILU_Afunc_t *A, const double *x,
+                                    double *y, int n)
+{
+    A->apply(A->ctx, x, y, n);
+}
+
+#endif
@@ -0,0 +1,17 @@
+function A = MILU_Afunc(varargin) %#codegen
+%MILU_Afunc Map an opaque object into a MILU_Afunc_t pointer
+%
+%  MILU_Afunc() simply returns a definition of the m2c_opaque_type,
+%  suitable in the argument specification for codegen.
+%
+%  MILU_Afunc(ptr) or MILU_Afunc(ptr, false) converts a given object to
+%  a pointer to MILU_Afunc_t, which holds a callback for y = A*x and its
+%  context, as defined in milu_afunc.h.
+%
+%  MILU_Afunc(ptr, true) wraps a pointer into an opaque object. This should
+%  be used if the opaque object needs to be returned to MATLAB.
+
+coder.inline('always');
+coder.cinclude('milu_afunc.h');
+
+A = m2c_opaque_obj('MILU_Afunc_t *', varargin{:});
@@ -0,0 +1,18 @@
+function y = MILU_Afunc_prodAx(Afunc, x, y)
+%MILU_Afunc_prodAx Compute y = A*x for a matrix-free operator
+%
+%   y = MILU_Afunc_prodAx(Afunc, x, y) evaluates the product by calling
+%   the function handle Afunc when uncompiled, or the callback in the
+%   MILU_Afunc object Afunc when compiled.
+%
+% See also: MILU_Afunc, gmresMILU_MF, bicgstabMILU_MF
+
+coder.inline('always');
+
+if isempty(coder.target)
+    y = Afunc(x);
+else
+    coder.cinclude('milu_afunc.h');
+    coder.ceval('MILU_Afunc_apply', MILU_Afunc(Afunc), coder.rref(x), ...
+        coder.wref(y), int32(numel(x)));
+end
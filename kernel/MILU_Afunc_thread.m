@@ -0,0 +1,22 @@
+function y = MILU_Afunc_thread(Afunc, x, y)
+%MILU_Afunc_thread Compute y = A*x for a matrix-free A in a parallel region
+%
+%   y = MILU_Afunc_thread(Afunc, x, y) must be called by all threads of a
+%   parallel region after all of x has been written, or outside of a
+%   parallel region. The master thread evaluates the product through
+%   MILU_Afunc_prodAx, since a MATLAB callback may only be invoked from
+%   the thread that entered the MEX function, and the barrier at the end
+%   makes all of y visible to the other threads.
+%
+%   This is the hook through which MILU_prodAx_thread, MILU_prodAxdot_thread
+%   and MILU_residual_thread support a matrix-free A, i.e., an A that is
+%   not a crs_matrix.
+%
+% See also: MILU_Afunc_prodAx, MILU_prodAx_thread
+
+coder.inline('always');
+
+OMP_begin_master;
+y = MILU_Afunc_prodAx(Afunc, x, y);
+OMP_end_master;
+OMP_barrier;
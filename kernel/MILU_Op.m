@@ -0,0 +1,8 @@
+function type = MILU_Op
+% Data type definition for the operator of the Krylov kernels
+
+type = coder.typeof(...
+    struct('part', m2c_intvec, ...
+    'spart', m2c_intvec, ...
+    'sell', sell_matrix, ...
+    'poly', m2c_mat));
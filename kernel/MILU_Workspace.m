@@ -0,0 +1,14 @@
+function type = MILU_Workspace
+% Data type definition for the workspace of the GMRES kernels
+
+type = coder.typeof(...
+    struct('V', m2c_mat, ...
+    'Z', m2c_mat, ...
+    'R', m2c_mat, ...
+    'J', m2c_mat, ...
+    'y', m2c_vec, ...
+    'w', m2c_vec, ...
+    'z', m2c_vec, ...
+    'P', m2c_mat, ...
+    'y2', m2c_vec, ...
+    'resids', m2c_vec));
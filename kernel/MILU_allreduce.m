@@ -0,0 +1,46 @@
+function [s, buf] = MILU_allreduce(s, buf, ibuf, m)
+%MILU_allreduce Sum the partial values of all threads of a parallel region
+%
+%   [s, buf] = MILU_allreduce(s, buf, ibuf) must be called by all threads
+%   of a parallel region. Each thread passes its partial sums in the
+%   vector s, and on return s contains the totals in every thread.
+%
+%   [s, buf] = MILU_allreduce(s, buf, ibuf, m) only sums s(1:m) and
+%   leaves the other entries of s unchanged.
+%
+%   buf is a shared buffer with at least m (or numel(s)) rows and
+%   2*nthreads columns, and ibuf (1 or 2) must alternate between
+%   consecutive calls. A thread can then only overwrite a half of buf
+%   after all threads have passed the barrier of the previous call using
+%   the same half, so one barrier per reduction suffices.
+%
+%   The partial values are added in the same order in every thread, so
+%   all threads obtain bitwise identical totals and take the same branches.
+%
+% See also: MILU_range
+
+coder.inline('always');
+
+nthr = int32(ompGetNumThreads);
+if nthr == 1
+    return;
+end
+
+if nargin < 4
+    m = int32(numel(s));
+end
+
+col = (ibuf - 1) * nthr + int32(ompGetThreadNum) + 1;
+for i = 1:m
+    buf(i, col) = s(i);
+end
+
+OMP_barrier;
+
+col = (ibuf - 1) * nthr;
+for i = 1:m
+    s(i) = buf(i, col + 1);
+    for t = 2:nthr
+        s(i) = s(i) + buf(i, col + t);
+    end
+end
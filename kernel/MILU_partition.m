@@ -0,0 +1,42 @@
+function part = MILU_partition(ptr, nparts)
+%MILU_partition Partition rows into contiguous ranges of balanced work
+%
+%   part = MILU_partition(ptr, nparts) splits the n rows of a matrix with
+%   the row pointers ptr (of length n+1) into nparts contiguous ranges,
+%   where part p consists of rows part(p):part(p+1)-1. Each row costs its
+%   number of nonzeros plus one for the vector operations on it, and the
+%   boundaries are chosen by bisection on the prefix sum of the costs,
+%   which is ptr(i) - ptr(1) + i - 1 before row i.
+%
+%   Compute the partition once per matrix and pass it to MILU_range.
+%
+% See also: MILU_range, MILUoperator
+
+%#codegen -args {m2c_intvec, int32(0)}
+
+n = int32(numel(ptr)) - 1;
+if nparts < 1
+    nparts = int32(1);
+end
+
+part = zeros(nparts + 1, 1, 'int32');
+part(1) = 1;
+part(nparts + 1) = n + 1;
+
+total = double(ptr(n + 1) - ptr(1) + n);
+for p = 1:nparts - 1
+    target = total * double(p) / double(nparts);
+
+    % Find the first row i with cost(i) >= target
+    lo = part(p);
+    hi = n + 1;
+    while lo < hi
+        mid = lo + idivide(hi - lo, int32(2));
+        if double(ptr(mid) - ptr(1) + mid - 1) < target
+            lo = mid + 1;
+        else
+            hi = mid;
+        end
+    end
+    part(p + 1) = lo;
+end
@@ -0,0 +1,107 @@
+function ws = MILU_polysolve_thread(A, M, op, ws)
+%MILU_polysolve_thread Apply the polynomial preconditioner M\p(A/M) to ws.z
+%
+%   ws = MILU_polysolve_thread(A, M, op, ws) must be called by all threads
+%   of a parallel region after all of ws.z has been written, or outside of
+%   a parallel region. It overwrites ws.z with M\(p(A/M)*z), where p is the
+%   polynomial of degree d-1 whose roots are given by the d harmonic Ritz
+%   values in op.poly created by MILUpoly, so that 1 - t*p(t) vanishes at
+%   the roots. Each call performs d-1 products with A, d solves with M,
+%   and no reductions. ws.P, ws.w and ws.y2 are used as buffers.
+%
+%   The products are formed in the Newton basis as in Loe and Morgan,
+%   Numer. Linear Algebra Appl., 2022, with the roots in modified Leja
+%   order and complex conjugate pairs handled in real arithmetic.
+%
+% See also: MILUpoly, gmresMILU_MGS
+
+coder.inline('always');
+
+[istart, iend] = MILU_range(int32(size(ws.z, 1)), op.part);
+d = int32(size(op.poly, 2));
+
+% prod = z is stored in P(:,1) and the result y in P(:,2)
+for i = istart:iend
+    ws.P(i, 1) = ws.z(i);
+    ws.P(i, 2) = 0;
+end
+
+k = int32(1);
+while k < d
+    a = op.poly(1, k);
+    b = op.poly(2, k);
+    if b == 0
+        % y = y + prod/a and prod = prod - (A/M)*prod/a
+        for i = istart:iend
+            ws.P(i, 2) = ws.P(i, 2) + ws.P(i, 1) / a;
+            ws.z(i) = ws.P(i, 1);
+        end
+        ws = poly_prodAMinv(A, M, op, ws);
+        for i = istart:iend
+            ws.P(i, 1) = ws.P(i, 1) - ws.w(i) / a;
+        end
+        k = k + 1;
+    else
+        % For the pair a +- bi, t = 2a*prod - (A/M)*prod, y = y + t/|a+bi|^2,
+        % and prod = prod - (A/M)*t/|a+bi|^2
+        m = a * a + b * b;
+        for i = istart:iend
+            ws.z(i) = ws.P(i, 1);
+        end
+        ws = poly_prodAMinv(A, M, op, ws);
+        for i = istart:iend
+            t = 2 * a * ws.P(i, 1) - ws.w(i);
+            ws.P(i, 2) = ws.P(i, 2) + t / m;
+            ws.z(i) = t;
+        end
+        if k < d - 1
+            ws = poly_prodAMinv(A, M, op, ws);
+            for i = istart:iend
+                ws.P(i, 1) = ws.P(i, 1) - ws.w(i) / m;
+            end
+        end
+        k = k + 2;
+    end
+end
+
+if d > 0 && op.poly(2, d) == 0
+    for i = istart:iend
+        ws.P(i, 2) = ws.P(i, 2) + ws.P(i, 1) / op.poly(1, d);
+    end
+end
+
+% z = M\y
+for i = istart:iend
+    ws.z(i) = ws.P(i, 2);
+end
+OMP_barrier;
+OMP_begin_single;
+if isempty(coder.target)
+    ws.z = ILUsol(M, ws.z);
+else
+    [ws.z, ws.w, ws.y2] = MILUsolve(M, ws.z, ws.w, ws.y2);
+end
+OMP_end_single;
+
+end
+
+function ws = poly_prodAMinv(A, M, op, ws)
+% Compute the owned rows of w = A*(M\z), where all threads have written
+% their rows of z. The barrier at the end ensures that all threads have
+% finished reading z before any thread overwrites it.
+
+coder.inline('always');
+
+OMP_barrier;
+OMP_begin_single;
+if isempty(coder.target)
+    ws.z = ILUsol(M, ws.z);
+else
+    [ws.z, ws.w, ws.y2] = MILUsolve(M, ws.z, ws.w, ws.y2);
+end
+OMP_end_single;
+
+ws.w = MILU_prodAx_thread(A, op, ws.z, ws.w);
+OMP_barrier;
+
+end
@@ -0,0 +1,33 @@
+function y = MILU_prodAx(A, op, x, y, nthreads)
+%MILU_prodAx Compute y = A*x using the operator data of A
+%
+%   y = MILU_prodAx(A, op, x, y, nthreads) computes the product of the
+%   crs_matrix A with x, where op is created by MILUoperator. It uses the
+%   SELL-C-sigma representation in op if present, and otherwise the CRS
+%   format with the nonzero-balanced partition of the rows in op.
+%
+% See also: MILUoperator, crs_prodAx, sell_prodAx
+
+%#codegen -args {crs_matrix, MILU_Op, m2c_vec, m2c_vec, int32(0)}
+
+coder.inline('always');
+
+if size(y, 1) < A.nrows
+    m2c_error('MILU_prodAx:BufferTooSmal', 'Buffer space for output y is too small.');
+end
+
+if isempty(coder.target) || nthreads <= 1
+    y = MILU_prodAx_kernel(A, op, x, y);
+else
+    %#omp parallel default(shared) num_threads(nthreads)
+    y = MILU_prodAx_kernel(A, op, x, y);
+end
+
+end
+
+function y = MILU_prodAx_kernel(A, op, x, y)
+coder.inline('never');
+
+y = MILU_prodAx_thread(A, op, x, y);
+
+end
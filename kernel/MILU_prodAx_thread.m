@@ -0,0 +1,34 @@
+function y = MILU_prodAx_thread(A, op, x, y)
+%MILU_prodAx_thread Compute the rows of y = A*x owned by the calling thread
+%
+%   y = MILU_prodAx_thread(A, op, x, y) must be called by all threads of a
+%   parallel region after all of x has been written, or outside of a
+%   parallel region to compute all of y.
+%
+%   In the CRS format, each thread computes the rows given by
+%   MILU_range(A.nrows, op.part), which it can then use without a barrier.
+%   In the SELL-C-sigma format, the rows of a slice are scattered, so the
+%   function ends with a barrier. If A is matrix-free, i.e., a function
+%   handle or a MILU_Afunc object instead of a crs_matrix, the product is
+%   computed by MILU_Afunc_thread, which also ends with a barrier.
+%
+% See also: MILU_prodAx, MILU_range, MILU_Afunc_thread
+
+coder.inline('always');
+
+if ~isfield(A, 'row_ptr')
+    y = MILU_Afunc_thread(A, x, y);
+elseif op.sell.nrows > 0
+    y = sell_prodAx_thread(op.sell, x, y, op.spart);
+    OMP_barrier;
+else
+    [istart, iend] = MILU_range(A.nrows, op.part);
+
+    for i = istart:iend
+        t = 0.0;
+        for j = A.row_ptr(i):A.row_ptr(i+1) - 1
+            t = t + A.val(j) * x(A.col_ind(j));
+        end
+        y(i) = t;
+    end
+end
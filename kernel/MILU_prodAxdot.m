@@ -0,0 +1,39 @@
+function [y, s] = MILU_prodAxdot(A, op, x, y, v, nthreads)
+%MILU_prodAxdot Compute y = A*x together with v'*y and y'*y
+%
+%   [y, s] = MILU_prodAxdot(A, op, x, y, v, nthreads) computes the product
+%   of the crs_matrix A with x as MILU_prodAx does, and returns the inner
+%   products s(1) = v'*y and s(2) = y'*y computed in the same pass over y.
+%
+% See also: MILU_prodAx, MILU_residual, MILU_prodAxdot_thread
+
+%#codegen -args {crs_matrix, MILU_Op, m2c_vec, m2c_vec, m2c_vec, int32(0)}
+
+coder.inline('always');
+
+if size(y, 1) < A.nrows
+    m2c_error('MILU_prodAxdot:BufferTooSmal', 'Buffer space for output y is too small.');
+end
+
+s = zeros(2, 1);
+if isempty(coder.target) || nthreads <= 1
+    [y, s] = MILU_prodAxdot_thread(A, op, x, y, v, int32(1));
+else
+    buf = zeros(2, 2 * nthreads);
+    %#omp parallel default(shared) num_threads(nthreads)
+    [y, s, buf] = MILU_prodAxdot_kernel(A, op, x, y, v, s, buf);
+end
+
+end
+
+function [y, s, buf] = MILU_prodAxdot_kernel(A, op, x, y, v, s, buf)
+coder.inline('never');
+
+[y, t] = MILU_prodAxdot_thread(A, op, x, y, v, int32(1));
+[t, buf] = MILU_allreduce(t, buf, int32(1));
+
+OMP_begin_master;
+s = t;
+OMP_end_master;
+
+end
@@ -0,0 +1,65 @@
+function [y, s] = MILU_prodAxdot_thread(A, op, x, y, V, k)
+%MILU_prodAxdot_thread Compute owned rows of y = A*x with V(:,k)'*y and y'*y
+%
+%   [y, s] = MILU_prodAxdot_thread(A, op, x, y, V, k) computes the rows of
+%   y = A*x written by the calling thread as MILU_prodAx_thread does, and
+%   in the same pass the partial sums s(1) = V(:,k)'*y and s(2) = y'*y
+%   over these rows, so that y does not have to be read again for the
+%   inner products. V is either a vector with k = 1 or the Krylov basis,
+%   which is indexed in place instead of copying the column.
+%
+%   Inside a parallel region, the partial sums must be added by
+%   MILU_allreduce. In the SELL-C-sigma format there is no barrier after
+%   the product, since the barrier in MILU_allreduce completes all of y.
+%   A matrix-free A is multiplied by MILU_Afunc_thread, and the partial
+%   sums are then computed over the rows owned by the calling thread.
+%
+% See also: MILU_prodAxdot, MILU_prodAx_thread, MILU_residual_thread
+
+coder.inline('always');
+
+s = zeros(2, 1);
+if ~isfield(A, 'row_ptr')
+    y = MILU_Afunc_thread(A, x, y);
+    [istart, iend] = MILU_range(int32(size(x, 1)), op.part);
+
+    for i = istart:iend
+        s(1) = s(1) + V(i, k) * y(i);
+        s(2) = s(2) + y(i) * y(i);
+    end
+elseif op.sell.nrows > 0
+    C = op.sell.C;
+    [sstart, send] = MILU_range(int32(numel(op.sell.slice_ptr)) - 1, op.spart);
+
+    t = zeros(16, 1);
+    for l = sstart:send
+        for r = 1:C
+            t(r) = 0;
+        end
+        for j = op.sell.slice_ptr(l):C:op.sell.slice_ptr(l+1) - 1
+            for r = 1:C
+                t(r) = t(r) + op.sell.val(j + r - 1) * x(op.sell.col_ind(j + r - 1));
+            end
+        end
+        for r = 1:C
+            row = op.sell.row_perm((l - 1) * C + r);
+            if row > 0
+                y(row) = t(r);
+                s(1) = s(1) + V(row, k) * t(r);
+                s(2) = s(2) + t(r) * t(r);
+            end
+        end
+    end
+else
+    [istart, iend] = MILU_range(A.nrows, op.part);
+
+    for i = istart:iend
+        yi = 0.0;
+        for j = A.row_ptr(i):A.row_ptr(i+1) - 1
+            yi = yi + A.val(j) * x(A.col_ind(j));
+        end
+        y(i) = yi;
+        s(1) = s(1) + V(i, k) * yi;
+        s(2) = s(2) + yi * yi;
+    end
+end
@@ -0,0 +1,32 @@
+function [istart, iend] = MILU_range(n, part)
+%MILU_range Range of rows owned by the calling thread
+%
+%   [istart, iend] = MILU_range(n) partitions 1:n evenly among the
+%   threads of the current parallel region and returns the rows owned by
+%   the calling thread. Outside of a parallel region, it returns 1:n.
+%
+%   [istart, iend] = MILU_range(n, part) uses the partition computed by
+%   MILU_partition instead, if it has one part per thread.
+%
+%   All threaded loops of a kernel must use the same partition, so that
+%   each thread reads back the entries it wrote itself without barriers.
+%
+% See also: MILU_allreduce, MILU_partition
+
+coder.inline('always');
+
+nthr = int32(ompGetNumThreads);
+if nthr == 1
+    istart = int32(1);
+    iend = n;
+elseif nargin > 1 && numel(part) == nthr + 1
+    tid = int32(ompGetThreadNum);
+    istart = part(tid + 1);
+    iend = part(tid + 2) - 1;
+else
+    tid = int32(ompGetThreadNum);
+    chunk = idivide(n, nthr);
+    remainder = n - nthr * chunk;
+    istart = tid * chunk + min(tid, remainder) + 1;
+    iend = istart + chunk - 1 + int32(tid < remainder);
+end
@@ -0,0 +1,39 @@
+function [r, s] = MILU_residual(A, op, x, b, r, nthreads)
+%MILU_residual Compute the residual r = b - A*x together with r'*r
+%
+%   [r, s] = MILU_residual(A, op, x, b, r, nthreads) computes the residual
+%   using the operator data of A created by MILUoperator, and returns its
+%   squared 2-norm s computed in the same pass over r.
+%
+% See also: MILU_prodAx, MILU_prodAxdot, MILU_residual_thread
+
+%#codegen -args {crs_matrix, MILU_Op, m2c_vec, m2c_vec, m2c_vec, int32(0)}
+
+coder.inline('always');
+
+if size(r, 1) < A.nrows
+    m2c_error('MILU_residual:BufferTooSmal', 'Buffer space for output r is too small.');
+end
+
+s = 0.0;
+if isempty(coder.target) || nthreads <= 1
+    [r, s] = MILU_residual_thread(A, op, x, b, r);
+else
+    buf = zeros(1, 2 * nthreads);
+    %#omp parallel default(shared) num_threads(nthreads)
+    [r, s, buf] = MILU_residual_kernel(A, op, x, b, r, s, buf);
+end
+
+end
+
+function [r, s, buf] = MILU_residual_kernel(A, op, x, b, r, s, buf)
+coder.inline('never');
+
+[r, t] = MILU_residual_thread(A, op, x, b, r);
+[t, buf] = MILU_allreduce(t, buf, int32(1));
+
+OMP_begin_master;
+s = t;
+OMP_end_master;
+
+end
@@ -0,0 +1,61 @@
+function [r, s] = MILU_residual_thread(A, op, x, b, r)
+%MILU_residual_thread Compute owned rows of r = b - A*x with r'*r
+%
+%   [r, s] = MILU_residual_thread(A, op, x, b, r) computes the rows of the
+%   residual r = b - A*x written by the calling thread, together with the
+%   partial sum s = r'*r over these rows, in a single pass.
+%
+%   Inside a parallel region, s must be added by MILU_allreduce, whose
+%   barrier also completes all of r in the SELL-C-sigma format. A
+%   matrix-free A is multiplied by MILU_Afunc_thread into r, which is then
+%   subtracted from b over the rows owned by the calling thread.
+%
+% See also: MILU_residual, MILU_prodAxdot_thread
+
+coder.inline('always');
+
+s = 0.0;
+if ~isfield(A, 'row_ptr')
+    r = MILU_Afunc_thread(A, x, r);
+    [istart, iend] = MILU_range(int32(size(x, 1)), op.part);
+
+    for i = istart:iend
+        ri = b(i) - r(i);
+        r(i) = ri;
+        s = s + ri * ri;
+    end
+elseif op.sell.nrows > 0
+    C = op.sell.C;
+    [sstart, send] = MILU_range(int32(numel(op.sell.slice_ptr)) - 1, op.spart);
+
+    t = zeros(16, 1);
+    for k = sstart:send
+        for i = 1:C
+            t(i) = 0;
+        end
+        for j = op.sell.slice_ptr(k):C:op.sell.slice_ptr(k+1) - 1
+            for i = 1:C
+                t(i) = t(i) + op.sell.val(j + i - 1) * x(op.sell.col_ind(j + i - 1));
+            end
+        end
+        for i = 1:C
+            row = op.sell.row_perm((k - 1) * C + i);
+            if row > 0
+                ri = b(row) - t(i);
+                r(row) = ri;
+                s = s + ri * ri;
+            end
+        end
+    end
+else
+    [istart, iend] = MILU_range(A.nrows, op.part);
+
+    for i = istart:iend
+        ri = b(i);
+        for j = A.row_ptr(i):A.row_ptr(i+1) - 1
+            ri = ri - A.val(j) * x(A.col_ind(j));
+        end
+        r(i) = ri;
+        s = s + ri * ri;
+    end
+end
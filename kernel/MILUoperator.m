@@ -0,0 +1,64 @@
+function op = MILUoperator(A, nthreads, C)
+%MILUoperator Precompute the data for multiplying by A in the kernels
+%
+%   op = MILUoperator(A, nthreads) computes the partition of the rows of
+%   the crs_matrix A into nthreads ranges with balanced numbers of
+%   nonzeros. All threaded loops over A and the vectors use it.
+%
+%   op = MILUoperator(A, nthreads, C) also converts A into the SELL-C-sigma
+%   format with C rows per slice if C is positive, unless the padding
+%   exceeds 20% of the nonzeros, in which case the CRS format is used.
+%
+%   The result is passed to the kernels along with A and is valid as long
+%   as the sparsity pattern of A and the number of threads do not change.
+%   Its field poly is empty. Set it to the roots computed by MILUpoly to
+%   add a polynomial preconditioner in the GMRES kernels.
+%
+%   If A is matrix-free (a function handle or a MILU_Afunc object), there
+%   are no nonzeros to balance, and the partition is empty, so that
+%   MILU_range splits the rows evenly.
+%
+% See also: MILU_prodAx, MILU_partition, sell_create, MILUpoly
+
+%#codegen -args {crs_matrix, int32(0), int32(0)}
+%#codegen MILUoperator_2args -args {crs_matrix, int32(0)}
+
+coder.varsize('sell.slice_ptr', 'sell.row_perm', 'sell.col_ind', ...
+    'sell.val', 'part', 'spart', 'poly');
+
+if ~isfield(A, 'row_ptr')
+    % A matrix-free A has neither a partition nor a SELL representation
+    part = zeros(0, 1, 'int32');
+    sell = empty_sell;
+elseif nargin > 2 && C > 0
+    part = MILU_partition(A.row_ptr, nthreads);
+    sell = sell_create(A, C);
+    if numel(sell.val) > 1.2 * double(A.row_ptr(A.nrows+1) - 1)
+        sell = empty_sell;
+    end
+else
+    part = MILU_partition(A.row_ptr, nthreads);
+    sell = empty_sell;
+end
+
+if sell.nrows > 0
+    spart = MILU_partition(sell.slice_ptr, nthreads);
+else
+    spart = zeros(0, 1, 'int32');
+end
+
+poly = zeros(2, 0);
+op = struct('part', part, 'spart', spart, 'sell', sell, 'poly', poly);
+
+end
+
+function sell = empty_sell
+% A sell_matrix with no rows, which indicates the CRS format
+
+sell = struct('slice_ptr', zeros(0, 1, 'int32'), ...
+    'row_perm', zeros(0, 1, 'int32'), ...
+    'col_ind', zeros(0, 1, 'int32'), ...
+    'val', zeros(0, 1), ...
+    'nrows', int32(0), 'ncols', int32(0), 'C', int32(0));
+
+end
@@ -0,0 +1,89 @@
+function poly = MILUpoly(A, M, d, b)
+%MILUpoly Compute the roots of a GMRES polynomial preconditioner for A/M
+%
+%   poly = MILUpoly(A, M, d, b) runs d steps of Arnoldi on A*inv(M)
+%   starting from b, where A is a crs_matrix and M is returned by
+%   MILUfactor (either output), and returns the harmonic Ritz values as a
+%   2-by-d matrix of real and imaginary parts. They are the roots of
+%   1 - t*p(t) for the GMRES polynomial p of degree d-1, in modified Leja
+%   order with each complex pair stored as a+bi followed by a-bi.
+%
+%   Assign poly to the field poly of the operator created by MILUoperator
+%   to precondition the GMRES kernels by M\p(A/M). A value d = 1 yields
+%   a scalar multiple of M\ and therefore has no effect.
+%
+% See also: MILU_polysolve_thread, MILUoperator, gmresMILU
+
+if nargin < 4 || isempty(b) || ~any(b)
+    b = ones(A.nrows, 1);
+end
+
+n = double(A.nrows);
+d = min(double(d), n);
+if d < 1
+    poly = zeros(2, 0);
+    return;
+end
+
+% Arnoldi with modified Gram-Schmidt
+V = zeros(n, d + 1);
+H = zeros(d + 1, d);
+V(:, 1) = b / norm(b);
+for j = 1:d
+    if isfield(M, 'negE')
+        z = MILUsolve(M, V(:, j));
+    else
+        z = ILUsol(M, V(:, j));
+    end
+    w = crs_prodAx(A, z);
+    for k = 1:j
+        H(k, j) = V(:, k)' * w;
+        w = w - H(k, j) * V(:, k);
+    end
+    H(j+1, j) = norm(w);
+    if H(j+1, j) == 0
+        % Invariant subspace. The Ritz values are exact.
+        d = j;
+        H = H(1:j+1, 1:j);
+        break
+    end
+    V(:, j+1) = w / H(j+1, j);
+end
+
+% Harmonic Ritz values are the eigenvalues of H + h^2 * (H'\e) * e'
+Hd = H(1:d, 1:d);
+e = zeros(d, 1);
+e(d) = 1;
+theta = eig(Hd + H(d+1, d)^2 * (Hd' \ e) * e');
+
+% Modified Leja ordering, keeping complex conjugates together
+poly = zeros(2, d);
+chosen = zeros(0, 1);
+k = 1;
+while k <= d
+    if isempty(chosen)
+        [~, i] = max(abs(theta));
+    else
+        score = zeros(numel(theta), 1);
+        for i = 1:numel(theta)
+            score(i) = sum(log(abs(theta(i) - chosen)));
+        end
+        [~, i] = max(score);
+    end
+    t = complex(real(theta(i)), abs(imag(theta(i))));
+    theta(i) = [];
+
+    poly(:, k) = [real(t); imag(t)];
+    chosen(end+1, 1) = t; %#ok<AGROW>
+    k = k + 1;
+    if imag(t) ~= 0 && k <= d
+        % Remove the conjugate and store it next
+        [~, i] = min(abs(theta - conj(t)));
+        theta(i) = [];
+        poly(:, k) = [real(t); -imag(t)];
+        chosen(end+1, 1) = conj(t); %#ok<AGROW>
+        k = k + 1;
+    end
+end
+
+end
@@ -0,0 +1,206 @@
+function [B, Y1, Y2] = MILUsolveBlock(M, B, Y1, Y2, ncols)
+%MILUsolveBlock computes M\B for a block of vectors B
+%   B = MILUsolveBlock(M, B)
+%   M is a structure containing the multilevel ILU factorization of A,
+%   and B is an n-by-k matrix.
+%
+%   [B, Y1, Y2] = MILUsolveBlock(M, B, Y1, Y2)
+%   where Y1 and Y2 are buffers with at least as many columns as B.
+%
+%   [B, Y1, Y2] = MILUsolveBlock(M, B, Y1, Y2, ncols)
+%   only solves for the first ncols columns of B.
+%
+%   This is the multi-RHS counterpart of MILUsolve. The factors of each
+%   level are traversed once for all columns, instead of once per column.
+%
+% See also: MILUsolve
+
+%#codegen -args {MILU_Prec, m2c_mat, m2c_mat, m2c_mat, int32(0)}
+
+zero = coder.ignoreConst(int32(0));
+one = coder.ignoreConst(int32(1));
+
+if nargin<5
+    ncols = int32(size(B, 2));
+end
+if nargin<3
+    Y1 = zeros(max(M(1).L.nrows, M(1).negE.nrows), ncols);
+end
+if nargin<4
+    Y2 = zeros(M(1).negE.nrows, ncols);
+end
+
+[B, Y1, Y2] = solve_milu_block(M, one, B, zero, Y1, Y2, ncols);
+
+end
+
+function [B, Y1, Y2] = solve_milu_block(M, lvl, B, offset, Y1, Y2, ncols)
+coder.inline('never');
+
+nB = M(lvl).L.nrows;
+n = nB + M(lvl).negE.nrows;
+
+% Rescale and permute both blocks of B
+for c = 1:ncols
+    for i = 1:nB
+        k = M(lvl).p(i);
+        Y1(i, c) = M(lvl).rowscal(k) .* B(k + offset, c);
+    end
+    for i = (nB + 1):n
+        k = M(lvl).p(i);
+        Y2(i-nB, c) = M(lvl).rowscal(k) .* B(k + offset, c);
+    end
+end
+
+if n > nB
+    for c = 1:ncols
+        for i = 1:nB
+            B(offset + i, c) = Y1(i, c);
+        end
+    end
+end
+
+if isempty(M(lvl).L.val) && numel(M(lvl).U.val) == n * n
+    % L is empty and U is a dense matrix storing result from dgetrf
+    Y1 = solve_getrs_block(M(lvl).U.val, Y1, nB, ncols);
+else
+    Y1 = solve_ldu_block(M(lvl), Y1, nB, ncols);
+end
+
+if n > nB
+    Y2 = crs_Axpy_block(M(lvl).negE, Y1, Y2, ncols);
+    for c = 1:ncols
+        for i = 1:n-nB
+            B(offset + nB + i, c) = Y2(i, c);
+        end
+    end
+
+    [B, Y1, Y2] = solve_milu_block(M, lvl+1, B, offset + nB, Y1, Y2, ncols);
+
+    for c = 1:ncols
+        for i = 1:nB
+            Y1(i, c) = B(offset + i, c);
+        end
+        for i = 1:n-nB
+            Y2(i, c) = B(offset + nB + i, c);
+        end
+    end
+
+    Y1 = crs_Axpy_block(M(lvl).negF, Y2, Y1, ncols);
+    Y1 = solve_ldu_block(M(lvl), Y1, nB, ncols);
+end
+
+% Rescale and permute solution vectors
+for c = 1:ncols
+    for i = 1:nB
+        k = M(lvl).q(i);
+        B(k + offset, c) = Y1(i, c) * M(lvl).colscal(k);
+    end
+    for i = (nB + 1):n
+        k = M(lvl).q(i);
+        B(k + offset, c) = Y2(i-nB, c) * M(lvl).colscal(k);
+    end
+end
+
+end
+
+function Y = solve_ldu_block(Mlvl, Y, nB, ncols)
+% Solve with the unit lower triangular L, the diagonal d, and the unit
+% upper triangular U, all stored in CCS format. Each entry of the factors
+% is loaded once and applied to all columns.
+
+coder.inline('always');
+
+for j = 1:int32(numel(Mlvl.L.col_ptr)) - 1
+    for k = Mlvl.L.col_ptr(j):Mlvl.L.col_ptr(j+1) - 1
+        row = Mlvl.L.row_ind(k);
+        v = Mlvl.L.val(k);
+        for c = 1:ncols
+            Y(row, c) = Y(row, c) - v * Y(j, c);
+        end
+    end
+end
+
+for c = 1:ncols
+    for i = 1:nB
+        Y(i, c) = Y(i, c) / Mlvl.d(i);
+    end
+end
+
+for j = int32(numel(Mlvl.U.col_ptr)) - 1:-1:1
+    for k = Mlvl.U.col_ptr(j):Mlvl.U.col_ptr(j+1) - 1
+        row = Mlvl.U.row_ind(k);
+        v = Mlvl.U.val(k);
+        for c = 1:ncols
+            Y(row, c) = Y(row, c) - v * Y(j, c);
+        end
+    end
+end
+
+end
+
+function Y = solve_getrs_block(LU, Y, n, ncols)
+% Solve with the dense LU factors from dgetrf, stored column-wise in LU.
+
+coder.inline('always');
+
+for c = 1:ncols
+    % Forward substitution with the unit lower triangular part
+    for j = 1:n-1
+        for i = j+1:n
+            Y(i, c) = Y(i, c) - LU((j-1)*n + i) * Y(j, c);
+        end
+    end
+    % Back substitution with the upper triangular part
+    for j = n:-1:1
+        Y(j, c) = Y(j, c) / LU((j-1)*n + j);
+        for i = 1:j-1
+            Y(i, c) = Y(i, c) - LU((j-1)*n + i) * Y(j, c);
+        end
+    end
+end
+
+end
+
+function Y = crs_Axpy_block(A, X, Y, ncols)
+% Compute Y = Y + A*X for a CRS matrix A, loading each row once.
+
+coder.inline('always');
+
+if size(Y, 1) < A.nrows
+    m2c_error('crs_Axpy:BufferTooSmal', 'Buffer space for output y is too small.');
+end
+
+for i = 1:A.nrows
+    for j = A.row_ptr(i):A.row_ptr(i+1) - 1
+        col = A.col_ind(j);
+        v = A.val(j);
+        for c = 1:ncols
+            Y(i, c) = Y(i, c) + v * X(col, c);
+        end
+    end
+end
+
+end
+
+function test %#ok<DEFNU>
+%!test
+%! n = 10;
+%! density = 0.4;
+%!
+%! for i=1:100
+%!     A = sprand(n, n, density) + speye(n);
+%!     if condest(A) < 1e4
+%!         break;
+%!     end
+%! end
+%! B = A * rand(n, 3);
+%!
+%! M = MILUfactor(A, struct('droptol', 0.001));
+%!
+%! X = MILUsolveBlock(M, B);
+%! for c = 1:3
+%!     assert(norm(X(:, c) - MILUsolve(M, B(:, c))) < 1.e-10);
+%! end
+
+end
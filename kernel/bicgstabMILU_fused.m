@@ -0,0 +1,255 @@
+function [x, flag, iter, resids] = bicgstabMILU_fused(A, b, ...
+    M, rtol, maxit, x0, verbose, nthreads, op)
+%bicgstabMILU_fused Kernel of bicgstabMILU with fused reductions
+%
+%   x = bicgstabMILU_fused(A, b, prec, rtol, maxit, x0, verbose, nthreads)
+%     when uncompiled, call this kernel function by passing the prec
+%     struct returned by MILUfactor
+%
+%   [x, flag, iter, resids] = bicgstabMILU_fused(...)
+%
+%   [x, flag, iter, resids] = bicgstabMILU_fused(..., op) multiplies by A
+%     using the partition and the optional SELL-C-sigma representation of
+%     A in op created by MILUoperator. Without op, the rows are still
+%     partitioned among the threads by their numbers of nonzeros.
+%
+% See also: bicgstabMILU, bicgstabMILU_kernel
+
+% Note: The whole iteration runs inside a single parallel region. Each
+% thread owns a contiguous range of rows for the SpMVs and all vector
+% updates, and the preconditioner is applied by one thread. The inner
+% products are fused into the sweeps that produce their operands, using
+% MILU_prodAxdot_thread for the SpMVs: (r_tld, v) into v = A*p_hat,
+% ||s|| into s = r - alpha*v, (t, s) and (t, t) into t = A*s_hat, and
+% ||r|| and the next (r_tld, r) into r = s - omega*t. Each iteration
+% thus needs four barriers for the reductions and two for the
+% preconditioner.
+
+%#codegen -args {crs_matrix, m2c_vec, MILU_Prec, 0., int32(0),
+%#codegen m2c_vec, int32(0), int32(0), MILU_Op}
+%#codegen bicgstabMILU_fused_8args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen 0., int32(0), m2c_vec, int32(0), int32(0)}
+
+n = int32(size(b, 1));
+
+% If RHS is zero, terminate
+bnrm2 = sqrt(vec_sqnorm2(b));
+if bnrm2 == 0
+    x = zeros(n, 1);
+    flag = int32(0);
+    iter = int32(0);
+    resids = 0;
+    return;
+end
+
+% Initialize x
+if isempty(x0)
+    x = zeros(n, 1);
+else
+    x = x0;
+end
+
+% Partition of the rows among the threads
+if nargin < 9
+    op = MILUoperator(A, nthreads);
+end
+
+% Compute the initial residual fused with its norm
+r = zeros(n, 1);
+if vec_sqnorm2(x) > 0
+    [r, rnrm2] = MILU_residual(A, op, x, b, r, nthreads);
+    resid = sqrt(rnrm2) / bnrm2;
+else
+    r = b;
+    resid = 1.0;
+end
+
+if resid < rtol
+    flag = int32(0);
+    iter = int32(0);
+    resids = 0;
+    return
+end
+
+% Buffer spaces
+r_tld = r;
+p = zeros(n, 1);
+v = zeros(n, 1);
+t = zeros(n, 1);
+p_hat = zeros(n, 1);
+if ~isempty(coder.target)
+    y2 = zeros(M(1).negE.nrows, 1);
+else
+    y2 = zeros(0, 1);
+end
+resids = zeros(maxit, 1);
+
+% Shared buffer for reductions and flag and iteration count
+buf = zeros(2, 2 * max(nthreads, int32(1)));
+info = zeros(2, 1, 'int32');
+
+if isempty(coder.target) || nthreads <= 1
+    [x, r, p, v, t, p_hat, y2, resids, buf, info] = bicgstab_fused_region(...
+        A, b, M, rtol, maxit, verbose, bnrm2, x, r, r_tld, p, v, t, ...
+        p_hat, y2, resids, buf, info, op);
+else
+    %#omp parallel default(shared) num_threads(nthreads)
+    [x, r, p, v, t, p_hat, y2, resids, buf, info] = bicgstab_fused_region(...
+        A, b, M, rtol, maxit, verbose, bnrm2, x, r, r_tld, p, v, t, ...
+        p_hat, y2, resids, buf, info, op);
+end
+
+flag = info(1);
+iter = info(2);
+if nargout > 3
+    resids = resids(1:iter);
+end
+
+end
+
+function [x, r, p, v, t, p_hat, y2, resids, buf, info] = bicgstab_fused_region(...
+    A, b, M, rtol, maxit, verbose, bnrm2, x, r, r_tld, p, v, t, ...
+    p_hat, y2, resids, buf, info, op) %#ok<INUSL>
+% Body of the parallel region, executed by every thread. All scalars are
+% thread-private but identical in all threads, since they are computed
+% from the outputs of MILU_allreduce.
+
+coder.inline('never');
+
+[istart, iend] = MILU_range(A.nrows, op.part);
+
+omega = 1.0;
+alpha = 0.0;
+rho_1 = 0.0;
+flag = int32(0);
+resid = 1.0;
+
+% rho = (r_tld, r)
+rho = 0.0;
+for i = istart:iend
+    rho = rho + r_tld(i) * r(i);
+end
+[rho, buf] = MILU_allreduce(rho, buf, int32(1));
+
+iter = int32(1);
+while true
+    if rho == 0.0
+        break
+    end
+
+    if iter > 1
+        beta = (rho / rho_1) * (alpha / omega);
+        for i = istart:iend
+            p(i) = r(i) + beta * (p(i) - omega * v(i));
+            p_hat(i) = p(i);
+        end
+    else
+        for i = istart:iend
+            p(i) = r(i);
+            p_hat(i) = p(i);
+        end
+    end
+
+    % Compute the preconditioned vector p_hat, using t as the buffer
+    OMP_barrier;
+    OMP_begin_single;
+    if isempty(coder.target)
+        p_hat = ILUsol(M, p_hat);
+    else
+        [p_hat, t, y2] = MILUsolve(M, p_hat, t, y2);
+    end
+    OMP_end_single;
+
+    % v = A*p_hat fused with (r_tld, v)
+    [v, s1] = MILU_prodAxdot_thread(A, op, p_hat, v, r_tld, int32(1));
+    [s1, buf] = MILU_allreduce(s1, buf, int32(2));
+    alpha = rho / s1(1);
+
+    % x = x + alpha*p_hat and s = r - alpha*v fused with ||s||. The vector
+    % s is stored in r, and p_hat is overwritten by s for the next solve.
+    snrm2 = 0.0;
+    for i = istart:iend
+        x(i) = x(i) + alpha * p_hat(i);
+        r(i) = r(i) - alpha * v(i);
+        p_hat(i) = r(i);
+        snrm2 = snrm2 + r(i) * r(i);
+    end
+    [snrm2, buf] = MILU_allreduce(snrm2, buf, int32(1));
+
+    if sqrt(snrm2) / bnrm2 < rtol % early convergence check
+        resid = sqrt(snrm2) / bnrm2;
+        OMP_begin_master;
+        resids(iter) = resid;
+        OMP_end_master;
+        break;
+    end
+
+    % Compute the preconditioned vector s_hat, using t as the buffer
+    OMP_begin_single;
+    if isempty(coder.target)
+        p_hat = ILUsol(M, p_hat);
+    else
+        [p_hat, t, y2] = MILUsolve(M, p_hat, t, y2);
+    end
+    OMP_end_single;
+
+    % t = A*s_hat fused with (t, s) and (t, t)
+    [t, ts] = MILU_prodAxdot_thread(A, op, p_hat, t, r, int32(1));
+    [ts, buf] = MILU_allreduce(ts, buf, int32(2));
+    omega = ts(1) / ts(2);
+
+    % x = x + omega*s_hat and r = s - omega*t fused with ||r|| and the
+    % next (r_tld, r)
+    rr = [0.0; 0.0];
+    for i = istart:iend
+        x(i) = x(i) + omega * p_hat(i);
+        r(i) = r(i) - omega * t(i);
+        rr(1) = rr(1) + r(i) * r(i);
+        rr(2) = rr(2) + r_tld(i) * r(i);
+    end
+    [rr, buf] = MILU_allreduce(rr, buf, int32(1));
+
+    resid = sqrt(rr(1)) / bnrm2; % check convergence
+    rho_1 = rho;
+    rho = rr(2);
+
+    OMP_begin_master;
+    resids(iter) = resid;
+    if verbose > 1 || verbose > 0 && mod(iter, 30) == 0
+        m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
+    end
+    OMP_end_master;
+
+    if resid <= rtol
+        break
+    elseif resid > 100 % diverged
+        flag = int32(-3);
+        break
+    end
+
+    if omega == 0.0
+        break
+    end
+
+    if iter >= maxit
+        break
+    end
+    iter = iter + 1;
+end
+
+if resid <= rtol % converged
+    flag = int32(0);
+elseif omega == 0.0 % breakdown
+    flag = int32(-2);
+elseif rho == 0.0
+    flag = int32(-1);
+elseif flag == 0 % no convergence
+    flag = int32(1);
+end
+
+OMP_begin_master;
+info(1) = flag;
+info(2) = iter;
+OMP_end_master;
+
+end
@@ -1,5 +1,5 @@
 function [x, flag, iter, resids] = bicgstabMILU_kernel(A, b, ...
-    M, rtol, maxit, x0, verbose, nthreads)
+    M, rtol, maxit, x0, verbose, nthreads, op)
 %bicgstabMILU_kernel Kernel of bicgstabMILU
 %
 %   x = bicgstabMILU_kernel(A, b, prec, rtol, maxit, x0, verbose, nthreads)
@@ -8,10 +8,16 @@ function [x, flag, iter, resids] = bicgstabMILU_kernel(A, b, ...
 %
 %   [x, flag, iter, resids] = bicgstabMILU_kernel(...)
 %
+%   [x, flag, iter, resids] = bicgstabMILU_kernel(..., op) multiplies by A
+%     using the partition and the optional SELL-C-sigma representation of
+%     A in op created by MILUoperator.
+%
 % See also: bicgstabMILU
 
 %#codegen -args {crs_matrix, m2c_vec, MILU_Prec, 0., int32(0),
-%#codegen m2c_vec, int32(0), int32(0)}
+%#codegen m2c_vec, int32(0), int32(0), MILU_Op}
+%#codegen bicgstabMILU_kernel_8args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen 0., int32(0), m2c_vec, int32(0), int32(0)}
 
 n = int32(size(b, 1));
 flag = int32(0);
@@ -44,15 +50,19 @@ if nargout > 3
     resids = zeros(maxit, 1);
 end
 
-% Compute the initial residual
+% Partition of the rows among the threads
+if nargin < 9
+    op = MILUoperator(A, nthreads);
+end
+
+% Compute the initial residual fused with its norm
 if vec_sqnorm2(x) > 0
-    r = crs_prodAx(A, x, r, nthreads);
-    r = b - r;
+    [r, rnrm2] = MILU_residual(A, op, x, b, r, nthreads);
+    resid = sqrt(rnrm2) / bnrm2;
 else
     r = b;
+    resid = 1.0;
 end
-
-resid = sqrt(vec_sqnorm2(r)) / bnrm2;
 if resid < rtol
     resids = 0;
     return
@@ -86,8 +96,9 @@ while true
         [p_hat, v, y2] = MILUsolve(M, p_hat, v, y2);
     end
 
-    v = crs_prodAx(A, p_hat, v, nthreads);
-    alpha = rho / (r_tld' * v);
+    % v = A*p_hat fused with (r_tld, v)
+    [v, vs] = MILU_prodAxdot(A, op, p_hat, v, r_tld, nthreads);
+    alpha = rho / vs(1);
     x = x + alpha * p_hat;
     s = r - alpha * v;
     snrm = sqrt(vec_sqnorm2(s));
@@ -106,8 +117,9 @@ while true
         [p_hat, v, y2] = MILUsolve(M, p_hat, v, y2);
     end
 
-    v = crs_prodAx(A, p_hat, v, nthreads);
-    omega = (v' * s) / vec_sqnorm2(v);
+    % t = A*s_hat fused with (t, s) and (t, t), where t is stored in v
+    [v, vs] = MILU_prodAxdot(A, op, p_hat, v, s, nthreads);
+    omega = vs(1) / vs(2);
     x = x + omega * p_hat; % update approximation
 
     r = s - omega * v;
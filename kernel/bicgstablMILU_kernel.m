@@ -0,0 +1,256 @@
+function [x, flag, iter, resids] = bicgstablMILU_kernel(A, b, ...
+    M, ell, rtol, maxit, x0, verbose, nthreads, op)
+%bicgstablMILU_kernel Kernel of bicgstabMILU using BiCGSTAB(ell)
+%
+%   x = bicgstablMILU_kernel(A, b, prec, ell, rtol, maxit, x0, verbose, nthreads)
+%     when uncompiled, call this kernel function by passing the prec
+%     struct returned by MILUfactor. ell is the degree of the minimal
+%     residual polynomial (typically 2 or 4).
+%
+%   [x, flag, iter, resids] = bicgstablMILU_kernel(...)
+%
+%   [x, flag, iter, resids] = bicgstablMILU_kernel(..., op) multiplies by
+%     A using the partition and the optional SELL-C-sigma representation
+%     of A in op created by MILUoperator.
+%
+% See also: bicgstabMILU, bicgstabMILU_kernel, idrsMILU_kernel
+
+% Note: The algorithm is BiCGSTAB(ell) by Sleijpen and Fokkema, applied
+% to A/M with right preconditioning. Each cycle performs ell BiCG steps
+% followed by a minimal residual step over a polynomial of degree ell
+% computed by modified Gram-Schmidt, which does not stagnate as easily
+% as the degree-one step of BiCGSTAB when the spectrum has large
+% imaginary parts. Every BiCG step performs two SpMVs and two
+% preconditioner solves and counts as one iteration. The correction z is
+% kept in the preconditioned space and x = x0 + M\z is formed once at
+% the end, so that the memory does not grow with the iteration count.
+
+%#codegen -args {crs_matrix, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
+%#codegen m2c_vec, int32(0), int32(0), MILU_Op}
+%#codegen bicgstablMILU_kernel_9args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0)}
+
+n = int32(size(b, 1));
+flag = int32(0);
+iter = int32(0);
+
+% If RHS is zero, terminate
+bnrm2 = sqrt(vec_sqnorm2(b));
+if bnrm2 == 0
+    x = zeros(n, 1);
+    resids = 0;
+    return;
+end
+
+% Initialize x
+if isempty(x0)
+    x = zeros(n, 1);
+else
+    x = x0;
+end
+
+% Buffer spaces
+v = zeros(n, 1);
+t = zeros(n, 1);
+if ~isempty(coder.target)
+    y2 = zeros(M(1).negE.nrows, 1);
+else
+    y2 = zeros(0, 1);
+end
+
+if nargout > 3
+    resids = zeros(maxit, 1);
+end
+
+% Partition of the rows among the threads
+if nargin < 10
+    op = MILUoperator(A, nthreads);
+end
+
+% Compute the initial residual fused with its norm
+r = zeros(n, 1);
+if vec_sqnorm2(x) > 0
+    [r, rnrm2] = MILU_residual(A, op, x, b, r, nthreads);
+    resid = sqrt(rnrm2) / bnrm2;
+else
+    r = b;
+    resid = 1.0;
+end
+if resid < rtol
+    resids = 0;
+    return
+end
+
+if ell < 1
+    ell = int32(1);
+end
+
+% Residuals and search directions of the BiCG steps and their images
+% under A/M, the shadow residual, and the correction in the
+% preconditioned space
+R = zeros(n, ell+1);
+U = zeros(n, ell+1);
+R(:, 1) = r;
+r_tld = r;
+z = zeros(n, 1);
+
+% Coefficients of the minimal residual step
+tau = zeros(ell, ell);
+sigma = zeros(ell, 1);
+gamma = zeros(ell, 1);
+gamma1 = zeros(ell, 1);
+gamma2 = zeros(ell, 1);
+
+rho0 = 1.0;
+alpha = 0.0;
+omega = 1.0;
+rho1 = r_tld' * r;
+while true
+    rho0 = -omega * rho0;
+
+    % BiCG part
+    for j = 1:ell
+        if rho0 == 0.0
+            flag = int32(-1);
+            break
+        end
+        beta = alpha * rho1 / rho0;
+        rho0 = rho1;
+        for i = 1:j
+            U(:, i) = R(:, i) - beta * U(:, i);
+        end
+
+        % U(:,j+1) = A*(M\U(:,j)) fused with (r_tld, U(:,j+1))
+        v = U(:, j);
+        [v, t, y2] = apply_prec(M, v, t, y2);
+        [t, s1] = MILU_prodAxdot(A, op, v, t, r_tld, nthreads);
+        U(:, j+1) = t;
+        if s1(1) == 0.0
+            flag = int32(-1);
+            break
+        end
+        alpha = rho0 / s1(1);
+
+        for i = 1:j
+            R(:, i) = R(:, i) - alpha * U(:, i+1);
+        end
+        z = z + alpha * U(:, 1);
+
+        % R(:,j+1) = A*(M\R(:,j)) fused with the next (r_tld, R(:,j+1))
+        v = R(:, j);
+        [v, t, y2] = apply_prec(M, v, t, y2);
+        [t, s1] = MILU_prodAxdot(A, op, v, t, r_tld, nthreads);
+        R(:, j+1) = t;
+        rho1 = s1(1);
+
+        iter = iter + 1;
+        resid = sqrt(vec_sqnorm2(R(:, 1))) / bnrm2; % check convergence
+        if nargout > 3
+            resids(iter) = resid;
+        end
+
+        if verbose > 1 || verbose > 0 && mod(iter, 30) == 0
+            m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
+        end
+
+        if resid <= rtol || iter >= maxit
+            break
+        end
+    end
+
+    if resid <= rtol || iter >= maxit || flag
+        break
+    elseif resid > 100 % diverged
+        flag = int32(-3);
+        break
+    end
+
+    % Minimal residual part. Orthogonalize R(:,2:ell+1) by modified
+    % Gram-Schmidt and minimize ||R(:,1) - R(:,2:ell+1)*gamma||.
+    for j = 1:ell
+        for i = 1:j-1
+            tau(i, j) = (R(:, j+1)' * R(:, i+1)) / sigma(i);
+            R(:, j+1) = R(:, j+1) - tau(i, j) * R(:, i+1);
+        end
+        sigma(j) = vec_sqnorm2(R(:, j+1));
+        if sigma(j) == 0.0
+            flag = int32(-2);
+            break
+        end
+        gamma1(j) = (R(:, 1)' * R(:, j+1)) / sigma(j);
+    end
+    if flag
+        break
+    end
+
+    gamma(ell) = gamma1(ell);
+    omega = gamma(ell);
+    if omega == 0.0
+        flag = int32(-2);
+        break
+    end
+    for j = ell-1:-1:1
+        gamma(j) = gamma1(j);
+        for i = j+1:ell
+            gamma(j) = gamma(j) - tau(j, i) * gamma(i);
+        end
+    end
+    for j = 1:ell-1
+        gamma2(j) = gamma(j+1);
+        for i = j+1:ell-1
+            gamma2(j) = gamma2(j) + tau(j, i) * gamma(i+1);
+        end
+    end
+
+    % Update the correction, the residual, and the search direction
+    z = z + gamma(1) * R(:, 1);
+    R(:, 1) = R(:, 1) - gamma1(ell) * R(:, ell+1);
+    U(:, 1) = U(:, 1) - gamma(ell) * U(:, ell+1);
+    for j = 1:ell-1
+        U(:, 1) = U(:, 1) - gamma(j) * U(:, j+1);
+        z = z + gamma2(j) * R(:, j+1);
+        R(:, 1) = R(:, 1) - gamma1(j) * R(:, j+1);
+    end
+
+    rho1 = r_tld' * R(:, 1);
+    resid = sqrt(vec_sqnorm2(R(:, 1))) / bnrm2; % check convergence
+    if nargout > 3
+        resids(iter) = resid;
+    end
+
+    if resid <= rtol
+        break
+    elseif resid > 100 % diverged
+        flag = int32(-3);
+        break
+    end
+end
+
+% x = x0 + M\z
+[z, t, y2] = apply_prec(M, z, t, y2); %#ok<ASGLU>
+x = x + z;
+
+if nargout > 3
+    resids = resids(1:iter);
+end
+
+if resid <= rtol % converged
+    flag = int32(0);
+elseif flag == 0 % no convergence
+    flag = int32(1);
+end
+
+end
+
+function [v, t, y2] = apply_prec(M, v, t, y2)
+% Compute M\v in place, using t as the buffer
+
+coder.inline('always');
+
+if isempty(coder.target)
+    v = ILUsol(M, v);
+else
+    [v, t, y2] = MILUsolve(M, v, t, y2);
+end
+
+end
@@ -0,0 +1,57 @@
+function Y = crs_prodAxBlock(A, X, Y, ncols, nthreads, part)
+%crs_prodAxBlock Compute Y = A*X for a CRS matrix and a block of vectors
+%
+%   Y = crs_prodAxBlock(A, X, Y, ncols, nthreads) computes the product of
+%   A with the first ncols columns of X and stores it into the first ncols
+%   columns of Y. Each row of A is loaded once for all the columns, so the
+%   memory traffic over A is that of a single crs_prodAx.
+%
+%   Y = crs_prodAxBlock(A, X, Y, ncols, nthreads, part) splits the rows
+%   among the threads using the partition computed by MILU_partition,
+%   such as the field part of the operator created by MILUoperator.
+%
+% See also: crs_prodAx, MILU_prodAx, MILU_range
+
+%#codegen -args {crs_matrix, m2c_mat, m2c_mat, int32(0), int32(0), m2c_intvec}
+%#codegen crs_prodAxBlock_5args -args {crs_matrix, m2c_mat, m2c_mat,
+%#codegen int32(0), int32(0)}
+
+if size(Y, 1) < A.nrows || size(Y, 2) < ncols
+    m2c_error('crs_prodAxBlock:BufferTooSmal', 'Buffer space for output Y is too small.');
+end
+
+if nargin < 6
+    part = zeros(0, 1, 'int32');
+end
+
+if isempty(coder.target) || nthreads <= 1
+    Y = crs_prodAxBlock_kernel(A.row_ptr, A.col_ind, A.val, X, Y, ...
+        A.nrows, ncols, part);
+else
+    %#omp parallel default(shared) num_threads(nthreads)
+    Y = crs_prodAxBlock_kernel(A.row_ptr, A.col_ind, A.val, X, Y, ...
+        A.nrows, ncols, part);
+end
+
+end
+
+function Y = crs_prodAxBlock_kernel(row_ptr, col_ind, val, X, Y, ...
+    nrows, ncols, part)
+coder.inline('never');
+
+[istart, iend] = MILU_range(nrows, part);
+
+for i = istart:iend
+    for c = 1:ncols
+        Y(i, c) = 0;
+    end
+    for j = row_ptr(i):row_ptr(i+1) - 1
+        col = col_ind(j);
+        v = val(j);
+        for c = 1:ncols
+            Y(i, c) = Y(i, c) + v * X(col, c);
+        end
+    end
+end
+
+end
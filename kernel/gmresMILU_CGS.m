@@ -1,5 +1,5 @@
-function [x, flag, iter, resids] = gmresMILU_CGS(A, b, ...
-    M, restart, rtol, maxit, x0, verbose, nthreads)
+function [x, flag, iter, resids, ws] = gmresMILU_CGS(A, b, ...
+    M, restart, rtol, maxit, x0, verbose, nthreads, ws, op)
 %gmresMILU_CGS Kernel of gmresMILU using classical Gram-Schmidt
 %
 %   x = gmresMILU_CGS(A, b, M, restart, rtol, maxit, x0, verbose, nthreads)
@@ -8,6 +8,16 @@ function [x, flag, iter, resids] = gmresMILU_CGS(A, b, ...
 %
 %   [x, flag, iter, resids] = gmresMILU_CGS(...)
 %
+%   [x, flag, iter, resids, ws] = gmresMILU_CGS(..., ws)
+%     uses the buffers in the workspace ws created by gmresMILU_workspace
+%     and returns it for reuse in subsequent solves.
+%
+%   [x, flag, iter, resids, ws] = gmresMILU_CGS(..., ws, op)
+%     multiplies by A using the partition and the optional SELL-C-sigma
+%     representation of A in op created by MILUoperator. If op.poly is
+%     not empty, the preconditioner is M\p(A/M) with the polynomial p
+%     created by MILUpoly. See MILU_polysolve_thread.
+%
 % See also: gmresMILU, gmresMILU_MGS, gmresMILU_HO
 
 % Note: The algorithm uses the classical Gram-Schmidt orthogonalization.
@@ -15,7 +25,11 @@ function [x, flag, iter, resids] = gmresMILU_CGS(A, b, ...
 % It is also less stable than the Householder algorithm.
 
 %#codegen -args {crs_matrix, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
-%#codegen m2c_vec, int32(0), int32(0)}
+%#codegen m2c_vec, int32(0), int32(0), MILU_Workspace, MILU_Op}
+%#codegen gmresMILU_CGS_10args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0), MILU_Workspace}
+%#codegen gmresMILU_CGS_9args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0)}
 
 n = int32(size(b, 1));
 
@@ -26,6 +40,9 @@ if beta0 == 0
     flag = int32(0);
     iter = int32(0);
     resids = 0;
+    if nargin < 10
+        ws = gmresMILU_workspace(n, restart, maxit, M);
+    end
     return;
 end
 
@@ -46,92 +63,167 @@ else
     x = x0;
 end
 
-% Local linear system
-y = zeros(restart+1, 1);
-R = zeros(restart, restart);
+% Krylov subspace, preconditioned subspace, local linear system, Given's
+% rotations, and buffer spaces. Reuse the workspace if given, without
+% clearing it, since every entry is written before it is read.
+if nargin < 10
+    ws = gmresMILU_workspace(n, restart, maxit, M);
+else
+    ws = gmresMILU_workspace(n, restart, maxit, M, ws);
+end
 
-% Orthognalized Krylov subspace
-Q = zeros(n, restart);
+% Partition of the rows among the threads
+if nargin < 11
+    op = MILUoperator(A, nthreads);
+end
 
-% Preconditioned subspace
-Z = zeros(n, restart);
+% Buffers for the polynomial preconditioner
+if ~isempty(op.poly) && size(ws.P, 2) < 2
+    ws.P = coder.nullcopy(zeros(n, 2));
+end
 
-% Given's rotation vectors
-J = zeros(2, restart);
+% Shared buffer for reductions, with one row per entry of the longest
+% reduction (h(1:restart)), and flag and iteration count
+buf = zeros(max(restart, int32(2)), 2 * max(nthreads, int32(1)));
+info = zeros(2, 1, 'int32');
+xnz = vec_sqnorm2(x) > 0;
 
-% Buffer spaces
-v = zeros(n, 1);
-if ~isempty(coder.target)
-    v2 = zeros(M(1).negE.nrows, 1);
+if isempty(coder.target) || nthreads <= 1
+    [x, ws, buf, info] = gmres_cgs_region(A, b, M, op, restart, rtol, ...
+        maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info);
+else
+    %#omp parallel default(shared) num_threads(nthreads)
+    [x, ws, buf, info] = gmres_cgs_region(A, b, M, op, restart, rtol, ...
+        maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info);
 end
 
+flag = info(1);
+iter = info(2);
 if nargout > 3
-    resids = zeros(maxit, 1);
+    resids = ws.resids(1:iter);
 end
 
+end
+
+function [x, ws, buf, info] = gmres_cgs_region(A, b, M, op, restart, rtol, ...
+    maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info)
+% Body of the parallel region, executed by every thread. Each thread owns
+% the rows given by op.part in all vectors, the inner products are summed
+% by MILU_allreduce, and one thread applies the preconditioner and updates
+% the Hessenberg matrix and the Given's rotations in omp single blocks.
+
+coder.inline('never');
+
+[istart, iend] = MILU_range(A.nrows, op.part);
+
+% Column of the Hessenberg matrix, private to each thread
+h = zeros(restart, 1);
+ibuf = int32(1);
+
 flag = int32(0);
 iter = int32(0);
 resid = 1;
+j = int32(1);
 for it_outer = 1:max_outer_iters
-    % Compute the initial residual
-    if it_outer > 1 || vec_sqnorm2(x) > 0
-        v = crs_prodAx(A, x, v, nthreads);
-        v = b - v;
+    % Compute the initial residual fused with its norm
+    beta2 = 0.0;
+    if it_outer > 1 || xnz
+        OMP_barrier;
+        [ws.w, beta2] = MILU_residual_thread(A, op, x, b, ws.w);
     else
-        v = b;
+        for i = istart:iend
+            ws.w(i) = b(i);
+            beta2 = beta2 + ws.w(i) * ws.w(i);
+        end
     end
-
-    beta2 = vec_sqnorm2(v);
+    [beta2, buf] = MILU_allreduce(beta2, buf, ibuf);
+    ibuf = 3 - ibuf;
     beta = sqrt(beta2);
 
     % The first Q vector
-    y(1) = beta;
-    Q(:, 1) = v / beta;
+    for i = istart:iend
+        ws.V(i, 1) = ws.w(i) / beta;
+    end
 
     j = int32(1);
     while true
-        w = Q(:, j);
-        % Compute the preconditioned vector and store into v
-        if isempty(coder.target)
-            w = ILUsol(M, w);
-        else
-            [w, v, v2] = MILUsolve(M, w, v, v2);
+        % Compute the preconditioned vector and store into Z(:, j)
+        for i = istart:iend
+            ws.z(i) = ws.V(i, j);
+        end
+        OMP_barrier;
+        OMP_begin_single;
+        if j == 1
+            ws.y(1) = beta;
+        end
+        if isempty(op.poly) && isempty(coder.target)
+            ws.z = ILUsol(M, ws.z);
+        elseif isempty(op.poly)
+            [ws.z, ws.w, ws.y2] = MILUsolve(M, ws.z, ws.w, ws.y2);
+        end
+        OMP_end_single;
+        if ~isempty(op.poly)
+            ws = MILU_polysolve_thread(A, M, op, ws);
         end
 
-        % Store the preconditioned vector
-        Z(:, j) = w;
-        v = crs_prodAx(A, w, v, nthreads);
+        for i = istart:iend
+            ws.Z(i, j) = ws.z(i);
+        end
+        ws.w = MILU_prodAx_thread(A, op, ws.z, ws.w);
 
-        % Perform classical Gram-Schmidt orthogonalization
-        w = v;
+        % Perform classical Gram-Schmidt orthogonalization with a single
+        % reduction for all inner products, and store column of R in h.
+        % The trailing entries of h are not used, so they are neither
+        % cleared nor reduced.
         for k = 1:j
-            R(k, j) = w' * Q(:, k);
-            v = v - R(k, j) * Q(:, k);
+            s = 0.0;
+            for i = istart:iend
+                s = s + ws.w(i) * ws.V(i, k);
+            end
+            h(k) = s;
         end
-
-        vnorm2 = vec_sqnorm2(v);
+        [h, buf] = MILU_allreduce(h, buf, ibuf, j);
+        ibuf = 3 - ibuf;
+
+        vnorm2 = 0.0;
+        for i = istart:iend
+            s = ws.w(i);
+            for k = 1:j
+                s = s - h(k) * ws.V(i, k);
+            end
+            ws.w(i) = s;
+            vnorm2 = vnorm2 + s * s;
+        end
+        [vnorm2, buf] = MILU_allreduce(vnorm2, buf, ibuf);
+        ibuf = 3 - ibuf;
         vnorm = sqrt(vnorm2);
+
         if j < restart
-            Q(:, j+1) = v / vnorm;
+            for i = istart:iend
+                ws.V(i, j+1) = ws.w(i) / vnorm;
+            end
         end
 
-        %  Apply Given's rotations to R(:,j)
+        OMP_begin_single;
+        %  Apply Given's rotations to h.
         for colJ = 1:j-1
-            tmpv = R(colJ, j);
-            R(colJ, j) = conj(J(1, colJ)) * R(colJ, j) + conj(J(2, colJ)) * R(colJ+1, j);
-            R(colJ+1, j) = - J(2, colJ) * tmpv + J(1, colJ) * R(colJ+1, j);
+            tmpv = h(colJ);
+            h(colJ) = conj(ws.J(1, colJ)) * h(colJ) + conj(ws.J(2, colJ)) * h(colJ+1);
+            h(colJ+1) = - ws.J(2, colJ) * tmpv + ws.J(1, colJ) * h(colJ+1);
         end
 
         %  Compute Given's rotation Jm.
-        rho = sqrt(R(j, j)'*R(j, j)+vnorm2);
-        J(1, j) = R(j, j) ./ rho;
-        J(2, j) = vnorm ./ rho;
-        y(j+1) = - J(2, j) .* y(j);
-        y(j) = conj(J(1, j)) .* y(j);
-        R(j, j) = rho;
+        rho = sqrt(h(j)'*h(j)+vnorm2);
+        ws.J(1, j) = h(j) ./ rho;
+        ws.J(2, j) = vnorm ./ rho;
+        ws.y(j+1) = - ws.J(2, j) .* ws.y(j);
+        ws.y(j) = conj(ws.J(1, j)) .* ws.y(j);
+        h(j) = rho;
+        ws.R(1:j, j) = h(1:j);
+        OMP_end_single;
 
         resid_prev = resid;
-        resid = abs(y(j+1)) / beta0;
+        resid = abs(ws.y(j+1)) / beta0;
         if resid >= resid_prev * (1 - 1.e-8)
             flag = int32(3); % stagnated
             break
@@ -141,14 +233,14 @@ for it_outer = 1:max_outer_iters
         end
         iter = iter + 1;
 
+        OMP_begin_master;
         if verbose > 1
             m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
         end
 
         % save the residual
-        if nargout > 3
-            resids(iter) = resid;
-        end
+        ws.resids(iter) = resid;
+        OMP_end_master;
 
         if resid < rtol || j >= restart
             break;
@@ -156,14 +248,22 @@ for it_outer = 1:max_outer_iters
         j = j + 1;
     end
 
+    OMP_begin_master;
     if verbose == 1 || verbose >1 && flag
         m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
     end
+    OMP_end_master;
 
     % Compute correction vector
-    y = backsolve(R, y, j);
-    for i = 1:j
-        x = x + y(i) * Z(:, i);
+    OMP_barrier;
+    OMP_begin_single;
+    ws.y = backsolve(ws.R, ws.y, j);
+    OMP_end_single;
+
+    for k = 1:j
+        for i = istart:iend
+            x(i) = x(i) + ws.y(k) * ws.Z(i, k);
+        end
     end
 
     if resid < rtol || flag
@@ -171,12 +271,13 @@ for it_outer = 1:max_outer_iters
     end
 end
 
-if nargout > 3
-    resids = resids(1:iter);
-end
-
 if resid <= rtol * (1 + 1.e-8)
     flag = int32(0);
 end
 
+OMP_begin_master;
+info(1) = flag;
+info(2) = iter;
+OMP_end_master;
+
 end
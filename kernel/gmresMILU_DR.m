@@ -0,0 +1,402 @@
+function [x, flag, iter, resids, U, C] = gmresMILU_DR(A, b, ...
+    M, restart, rtol, maxit, x0, verbose, nthreads, k, U0, op)
+%gmresMILU_DR Kernel of gmresMILU with Krylov subspace recycling (GCRO-DR)
+%
+%   x = gmresMILU_DR(A, b, M, restart, rtol, maxit, x0, verbose, nthreads, k, U0)
+%     when uncompiled, call this kernel function by passing the M
+%     struct returned by MILUfactor. k is the dimension of the recycled
+%     subspace, and U0 is the subspace returned by a previous solve (or
+%     an n-by-0 matrix to start from scratch).
+%
+%   [x, flag, iter, resids, U, C] = gmresMILU_DR(...) also returns
+%     the recycled subspace U and C = A*M\U, where C has orthonormal
+%     columns, to be passed to the next solve with a related system.
+%
+%   [x, flag, iter, resids, U, C] = gmresMILU_DR(..., op)
+%     multiplies by A using the partition and the optional SELL-C-sigma
+%     representation of A in op created by MILUoperator.
+%
+% See also: gmresMILU, gmresMILU_MGS
+
+% Note: The algorithm is GCRO-DR of Parks et al. (SISC 2006) with right
+% preconditioning and modified Gram-Schmidt. Each cycle of restart
+% iterations runs restart-k Arnoldi steps with (I-C*C')*A*M^{-1} and then
+% replaces U by the k harmonic Ritz vectors of the cycle with the smallest
+% magnitude. The vectors in U span directions of the preconditioned
+% operator; since A and M may change between solves, C is recomputed from
+% U0 on entry at the cost of k preconditioner solves and k SpMVs.
+
+%#codegen -args {crs_matrix, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
+%#codegen m2c_vec, int32(0), int32(0), int32(0), m2c_mat, MILU_Op}
+%#codegen gmresMILU_DR_11args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0), int32(0), m2c_mat}
+
+n = int32(size(b, 1));
+
+% If RHS is zero, terminate
+beta0 = sqrt(vec_sqnorm2(b));
+if beta0 == 0
+    x = zeros(n, 1);
+    flag = int32(0);
+    iter = int32(0);
+    resids = 0;
+    U = U0;
+    C = zeros(n, size(U0, 2));
+    return;
+end
+
+% Number of inner iterations
+if restart > n
+    restart = n;
+elseif restart <= 0
+    restart = int32(1);
+end
+
+% Dimension of the recycled subspace
+if k >= restart
+    k = restart - 1;
+elseif k < 0
+    k = int32(0);
+end
+
+% Partition of the rows among the threads
+if nargin < 12
+    op = MILUoperator(A, nthreads);
+end
+
+% Initialize x
+if isempty(x0)
+    x = zeros(n, 1);
+else
+    x = x0;
+end
+
+% Local linear system
+y = zeros(restart+1, 1);
+H = zeros(restart+1, restart);
+R = zeros(restart, restart);
+B = zeros(k, restart);
+
+% Orthognalized Krylov subspace
+Q = zeros(n, restart+1);
+
+% Preconditioned subspace
+Z = zeros(n, restart);
+
+% Given's rotation vectors
+J = zeros(2, restart);
+
+% Recycled subspace, its preconditioned image, and C = A*Zu
+U = zeros(n, k);
+Zu = zeros(n, k);
+C = zeros(n, k);
+unorms = zeros(k, 1);
+
+% Buffer spaces
+v = zeros(n, 1);
+if ~isempty(coder.target)
+    y2 = zeros(M(1).negE.nrows, 1);
+end
+
+if nargout > 3
+    resids = zeros(maxit, 1);
+end
+
+% Compute the initial residual
+r = b;
+if vec_sqnorm2(x) > 0
+    r = MILU_residual(A, op, x, b, r, nthreads);
+end
+
+% Recompute C from the recycled subspace for the current A and M
+kk = int32(0);
+if k > 0 && size(U0, 2) > 0
+    for i = 1:min(k, int32(size(U0, 2)))
+        U(:, kk+1) = U0(:, i);
+        w = U0(:, i);
+        if isempty(coder.target)
+            w = ILUsol(M, w);
+        else
+            [w, v, y2] = MILUsolve(M, w, v, y2);
+        end
+        Zu(:, kk+1) = w;
+        v = MILU_prodAx(A, op, w, v, nthreads);
+        C(:, kk+1) = v;
+
+        % Orthonormalize C and apply the same transformation to U and Zu
+        cnorm0 = sqrt(vec_sqnorm2(v));
+        for l = 1:kk
+            t = C(:, kk+1)' * C(:, l);
+            C(:, kk+1) = C(:, kk+1) - t * C(:, l);
+            U(:, kk+1) = U(:, kk+1) - t * U(:, l);
+            Zu(:, kk+1) = Zu(:, kk+1) - t * Zu(:, l);
+        end
+        cnorm = sqrt(vec_sqnorm2(C(:, kk+1)));
+        if cnorm > 1.e-12 * cnorm0
+            kk = kk + 1;
+            C(:, kk) = C(:, kk) / cnorm;
+            U(:, kk) = U(:, kk) / cnorm;
+            Zu(:, kk) = Zu(:, kk) / cnorm;
+        end
+    end
+
+    % Remove the components of the residual in the span of C
+    for i = 1:kk
+        t = C(:, i)' * r;
+        x = x + t * Zu(:, i);
+        r = r - t * C(:, i);
+    end
+end
+
+flag = int32(0);
+iter = int32(0);
+resid = 1;
+while true
+    beta = sqrt(vec_sqnorm2(r));
+
+    % The first Q vector
+    y(:) = 0;
+    y(1) = beta;
+    Q(:, 1) = r / beta;
+
+    for i = 1:kk
+        unorms(i) = sqrt(vec_sqnorm2(U(:, i)));
+    end
+
+    j = int32(1);
+    while true
+        w = Q(:, j);
+        % Compute the preconditioned vector and store into v
+        if isempty(coder.target)
+            w = ILUsol(M, w);
+        else
+            [w, v, y2] = MILUsolve(M, w, v, y2);
+        end
+
+        % Store the preconditioned vector
+        Z(:, j) = w;
+        v = MILU_prodAx(A, op, w, v, nthreads);
+
+        % Project out the recycled subspace
+        for i = 1:kk
+            B(i, j) = v' * C(:, i);
+            v = v - B(i, j) * C(:, i);
+        end
+
+        % Perform Gram-Schmidt orthogonalization and store column of H
+        for i = 1:j
+            H(i, j) = v' * Q(:, i);
+            v = v - H(i, j) * Q(:, i);
+        end
+
+        vnorm2 = vec_sqnorm2(v);
+        vnorm = sqrt(vnorm2);
+        H(j+1, j) = vnorm;
+        if vnorm > 0
+            Q(:, j+1) = v / vnorm;
+        else
+            % Lucky breakdown. The last row of H is zero, so Q(:, j+1)
+            % does not enter the recycled subspace.
+            Q(:, j+1) = 0;
+        end
+
+        %  Apply Given's rotations to a copy of H(:, j)
+        for i = 1:j
+            R(i, j) = H(i, j);
+        end
+        for colJ = 1:j-1
+            tmpv = R(colJ, j);
+            R(colJ, j) = conj(J(1, colJ)) * R(colJ, j) + conj(J(2, colJ)) * R(colJ+1, j);
+            R(colJ+1, j) = - J(2, colJ) * tmpv + J(1, colJ) * R(colJ+1, j);
+        end
+
+        %  Compute Given's rotation Jm.
+        rho = sqrt(R(j, j)'*R(j, j)+vnorm2);
+        J(1, j) = R(j, j) ./ rho;
+        J(2, j) = vnorm ./ rho;
+        y(j+1) = - J(2, j) .* y(j);
+        y(j) = conj(J(1, j)) .* y(j);
+        R(j, j) = rho;
+
+        resid_prev = resid;
+        resid = abs(y(j+1)) / beta0;
+        if resid >= resid_prev * (1 - 1.e-8)
+            flag = int32(3); % stagnated
+            break
+        elseif iter >= maxit
+            flag = int32(1); % reached maxit
+            break
+        end
+        iter = iter + 1;
+
+        if verbose > 1
+            m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
+        end
+
+        % save the residual
+        if nargout > 3
+            resids(iter) = resid;
+        end
+
+        if resid < rtol || j >= restart - kk || vnorm == 0
+            break;
+        end
+        j = j + 1;
+    end
+
+    if verbose == 1 || verbose >1 && flag
+        m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
+    end
+
+    % Compute correction vector. The components along U cancel the
+    % projections onto C, i.e., x += Z*y - Zu*(B*y).
+    y = backsolve(R, y, j);
+    for i = 1:j
+        x = x + y(i) * Z(:, i);
+    end
+    for i = 1:kk
+        t = 0;
+        for l = 1:j
+            t = t + B(i, l) * y(l);
+        end
+        x = x - t * Zu(:, i);
+    end
+
+    % Update the recycled subspace with the harmonic Ritz vectors
+    if k > 0 && kk + j > k
+        [U, Zu, C, kk] = update_recycle(H, B, Q, Z, U, Zu, C, ...
+            unorms, kk, j, k);
+    end
+
+    % Recompute the residual and remove its components in the span of C
+    r = MILU_residual(A, op, x, b, r, nthreads);
+    for i = 1:kk
+        t = C(:, i)' * r;
+        x = x + t * Zu(:, i);
+        r = r - t * C(:, i);
+    end
+
+    if resid < rtol || flag
+        break;
+    end
+end
+
+if nargout > 3
+    resids = resids(1:iter);
+end
+
+if resid <= rtol * (1 + 1.e-8)
+    flag = int32(0);
+end
+
+U = U(:, 1:kk);
+C = C(:, 1:kk);
+
+end
+
+function [U, Zu, C, kk] = update_recycle(H, B, Q, Z, U, Zu, C, ...
+    unorms, kk, j, k)
+% Replace U, Zu and C by the harmonic Ritz vectors of smallest magnitude
+% over the space [U, Q(:, 1:j)] and their images.
+
+coder.inline('never');
+
+mm = kk + j;
+
+% Ghat = [D, B; 0, H] represents A*M^{-1}*[U*D, Q] = [C, Q]*Ghat, where
+% D scales the columns of U to unit length.
+Ghat = zeros(mm+1, mm);
+WV = zeros(mm+1, mm);
+for i = 1:kk
+    Ghat(i, i) = 1 / unorms(i);
+    for l = 1:j
+        Ghat(i, kk+l) = B(i, l);
+    end
+    for l = 1:kk
+        WV(l, i) = (C(:, l)' * U(:, i)) / unorms(i);
+    end
+    for l = 1:j+1
+        WV(kk+l, i) = (Q(:, l)' * U(:, i)) / unorms(i);
+    end
+end
+for l = 1:j
+    for i = 1:l+1
+        Ghat(kk+i, kk+l) = H(i, l);
+    end
+    WV(kk+l, kk+l) = 1;
+end
+
+% Harmonic Ritz pairs: Ghat'*Ghat*p = theta * Ghat'*WV*p
+[P, T] = eig(Ghat' * Ghat, Ghat' * WV);
+theta = diag(T);
+mags = abs(theta);
+for i = 1:mm
+    if ~isfinite(mags(i))
+        mags(i) = inf;
+    end
+end
+[~, perm] = sort(mags);
+
+% Collect a real basis of the k vectors with smallest magnitude. A complex
+% conjugate pair contributes its real and imaginary parts.
+Pk = zeros(mm, k);
+nk = int32(0);
+for i = 1:mm
+    if nk >= k
+        break
+    end
+    idx = perm(i);
+    if imag(theta(idx)) < 0 || ~isfinite(mags(idx))
+        continue
+    end
+    nk = nk + 1;
+    Pk(:, nk) = real(P(:, idx));
+    if imag(theta(idx)) > 0 && nk < k
+        nk = nk + 1;
+        Pk(:, nk) = imag(P(:, idx));
+    end
+end
+
+if nk == 0
+    return
+end
+
+% Orthonormalize Ghat*Pk = Qk*Rk and apply inv(Rk) to Pk, dropping
+% dependent columns
+GP = Ghat * Pk(:, 1:nk);
+nq = int32(0);
+for i = 1:nk
+    gnorm0 = sqrt(GP(:, i)' * GP(:, i));
+    for l = 1:nq
+        t = GP(:, l)' * GP(:, i);
+        GP(:, i) = GP(:, i) - t * GP(:, l);
+        Pk(:, i) = Pk(:, i) - t * Pk(:, l);
+    end
+    gnorm = sqrt(GP(:, i)' * GP(:, i));
+    if gnorm > 1.e-12 * gnorm0
+        nq = nq + 1;
+        GP(:, nq) = GP(:, i) / gnorm;
+        Pk(:, nq) = Pk(:, i) / gnorm;
+    end
+end
+if nq == 0
+    return
+end
+
+% C = [C, Q]*Qk and U = [U*D, Q]*Pk*inv(Rk)
+for i = 1:kk
+    for l = 1:nq
+        Pk(i, l) = Pk(i, l) / unorms(i);
+    end
+end
+
+Cnew = C(:, 1:kk) * GP(1:kk, 1:nq) + Q(:, 1:j+1) * GP(kk+1:mm+1, 1:nq);
+Unew = U(:, 1:kk) * Pk(1:kk, 1:nq) + Q(:, 1:j) * Pk(kk+1:mm, 1:nq);
+Zunew = Zu(:, 1:kk) * Pk(1:kk, 1:nq) + Z(:, 1:j) * Pk(kk+1:mm, 1:nq);
+
+kk = nq;
+C(:, 1:kk) = Cnew;
+U(:, 1:kk) = Unew;
+Zu(:, 1:kk) = Zunew;
+
+end
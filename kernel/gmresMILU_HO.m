@@ -1,5 +1,5 @@
-function [x, flag, iter, resids] = gmresMILU_HO(A, b, ...
-    M, restart, rtol, maxit, x0, verbose, nthreads)
+function [x, flag, iter, resids, ws] = gmresMILU_HO(A, b, ...
+    M, restart, rtol, maxit, x0, verbose, nthreads, ws, op)
 %gmresMILU_HO Kernel of gmresMILU using Householder algorithm
 %
 %   x = gmresMILU_HO(A, b, M, restart, rtol, maxit, x0, verbose, nthreads)
@@ -8,13 +8,27 @@ function [x, flag, iter, resids] = gmresMILU_HO(A, b, ...
 %
 %   [x, flag, iter, resids] = gmresMILU_HO(...)
 %
+%   [x, flag, iter, resids, ws] = gmresMILU_HO(..., ws)
+%     uses the buffers in the workspace ws created by gmresMILU_workspace
+%     and returns it for reuse in subsequent solves.
+%
+%   [x, flag, iter, resids, ws] = gmresMILU_HO(..., ws, op)
+%     multiplies by A using the partition and the optional SELL-C-sigma
+%     representation of A in op created by MILUoperator. If op.poly is
+%     not empty, the preconditioner is M\p(A/M) with the polynomial p
+%     created by MILUpoly. See MILU_polysolve_thread.
+%
 % See also: gmresMILU, gmresMILU_CGS, gmresMILU_MGS
 
 % Note: The algorithm uses Householder reflectors for orthogonalization.
 % It is more expensive than Gram-Schmidt but is more robust.
 
 %#codegen -args {crs_matrix, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
-%#codegen m2c_vec, int32(0), int32(0)}
+%#codegen m2c_vec, int32(0), int32(0), MILU_Workspace, MILU_Op}
+%#codegen gmresMILU_HO_10args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0), MILU_Workspace}
+%#codegen gmresMILU_HO_9args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0)}
 
 n = int32(size(b, 1));
 
@@ -25,6 +39,9 @@ if beta0 == 0
     flag = int32(0);
     iter = int32(0);
     resids = 0;
+    if nargin < 10
+        ws = gmresMILU_workspace(n, restart, maxit, M);
+    end
     return;
 end
 
@@ -45,170 +62,255 @@ else
     x = x0;
 end
 
-% Householder matrix or upper-triangular matix
-V = zeros(n, restart);
-R = zeros(restart, restart);
+% Krylov subspace, preconditioned subspace, local linear system, Given's
+% rotations, and buffer spaces. Reuse the workspace if given, without
+% clearing it, since every entry is written before it is read.
+if nargin < 10
+    ws = gmresMILU_workspace(n, restart, maxit, M);
+else
+    ws = gmresMILU_workspace(n, restart, maxit, M, ws);
+end
+
+% Partition of the rows among the threads
+if nargin < 11
+    op = MILUoperator(A, nthreads);
+end
 
-% Temporary solution
-y = zeros(restart+1, 1);
+% Buffers for the polynomial preconditioner
+if ~isempty(op.poly) && size(ws.P, 2) < 2
+    ws.P = coder.nullcopy(zeros(n, 2));
+end
 
-% Preconditioned subspace
-Z = zeros(n, restart);
+% Shared buffer for reductions and flag and iteration count
+buf = zeros(2, 2 * max(nthreads, int32(1)));
+info = zeros(2, 1, 'int32');
+xnz = vec_sqnorm2(x) > 0;
 
-% Given's rotation vectors
-J = zeros(2, restart);
+if isempty(coder.target) || nthreads <= 1
+    [x, ws, buf, info] = gmres_ho_region(A, b, M, op, restart, rtol, ...
+        maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info);
+else
+    %#omp parallel default(shared) num_threads(nthreads)
+    [x, ws, buf, info] = gmres_ho_region(A, b, M, op, restart, rtol, ...
+        maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info);
+end
 
-% Corrections at outer loop
+flag = info(1);
+iter = info(2);
 if nargout > 3
-    resids = zeros(maxit, 1);
+    resids = ws.resids(1:iter);
 end
 
-w = zeros(n, 1);
-if ~isempty(coder.target)
-    y2 = zeros(M(1).negE.nrows, 1);
 end
 
+function [x, ws, buf, info] = gmres_ho_region(A, b, M, op, restart, rtol, ...
+    maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info)
+% Body of the parallel region, executed by every thread. Each thread owns
+% the rows given by op.part in all vectors, and the inner products with
+% the Householder vectors are summed by MILU_allreduce. Entries that all
+% threads need from a vector owned by one thread, such as the pivot of a
+% reflector, are passed through the same reductions. One thread applies
+% the preconditioner and updates the Given's rotations in omp single blocks.
+
+coder.inline('never');
+
+n = A.nrows;
+[istart, iend] = MILU_range(n, op.part);
+ibuf = int32(1);
+red = zeros(2, 1);
+
 flag = int32(0);
 iter = int32(0);
 resid = 1;
+j = int32(1);
 for it_outer = 1:max_outer_iters
-    % Compute the initial residual
-    if it_outer > 1 || vec_sqnorm2(x) > 0
-        w = crs_prodAx(A, x, w, nthreads);
-        u = b - w;
+    % Compute the initial residual fused with its norm. All of w is
+    % complete after the reduction, so every thread can read w(1).
+    beta2 = 0.0;
+    if it_outer > 1 || xnz
+        OMP_barrier;
+        [ws.w, beta2] = MILU_residual_thread(A, op, x, b, ws.w);
     else
-        u = b;
+        for i = istart:iend
+            ws.w(i) = b(i);
+            beta2 = beta2 + ws.w(i) * ws.w(i);
+        end
     end
+    [beta2, buf] = MILU_allreduce(beta2, buf, ibuf);
+    ibuf = 3 - ibuf;
 
-    beta2 = vec_sqnorm2(u);
     beta = sqrt(beta2);
+    w1 = ws.w(1);
 
     % Prepare the first Householder vector
-    if u(1) < 0
+    if w1 < 0
         beta = -beta;
     end
-    updated_norm = sqrt(2*beta2+2*real(u(1))*beta);
-    u(1) = u(1) + beta;
-    u = u / updated_norm;
-
-    % The first Householder entry
-    y(1) = - beta;
-    V(:, 1) = u;
+    updated_norm = sqrt(2*beta2+2*w1*beta);
+    for i = istart:iend
+        ws.V(i, 1) = ws.w(i) / updated_norm;
+    end
+    if istart <= 1 && 1 <= iend
+        ws.V(1, 1) = (w1 + beta) / updated_norm;
+    end
+    OMP_barrier;
 
     j = int32(1);
     while true
         % Construct the last vector from the Householder reflectors
 
         %  v = Pj*ej = ej - 2*u*u'*ej
-        v = -2 * conj(V(j, j)) * V(:, j);
-        v(j) = v(j) + 1;
+        vjj = ws.V(j, j);
+        for i = istart:iend
+            ws.z(i) = -2 * vjj * ws.V(i, j);
+        end
+        if istart <= j && j <= iend
+            ws.z(j) = ws.z(j) + 1;
+        end
+
         %  v = P1*P2*...Pjm1*(Pj*ej)
-        if isempty(coder.target)
-            % This is faster when interpreted
-            for i = (j - 1): - 1:1
-                v = v - 2 * (V(:, i)' * v) * V(:, i);
+        for k = (j - 1): - 1:1
+            s = 0.0;
+            for i = max(istart, k):iend
+                s = s + ws.V(i, k) * ws.z(i);
             end
-        else
-            % This is faster when compiled
-            for i = (j - 1): - 1:1
-                s = conj(V(i, i)) * v(i);
-                for k = i + 1:n
-                    s = s + conj(V(k, i)) * v(k);
-                end
-                s = 2 * s;
+            [s, buf] = MILU_allreduce(s, buf, ibuf);
+            ibuf = 3 - ibuf;
+            s = 2 * s;
 
-                for k = i:n
-                    v(k) = v(k) - s * V(k, i);
-                end
+            for i = max(istart, k):iend
+                ws.z(i) = ws.z(i) - s * ws.V(i, k);
             end
         end
+
         %  Explicitly normalize v to reduce the effects of round-off.
-        v = v / sqrt(vec_sqnorm2(v));
+        s = 0.0;
+        for i = istart:iend
+            s = s + ws.z(i) * ws.z(i);
+        end
+        [s, buf] = MILU_allreduce(s, buf, ibuf);
+        ibuf = 3 - ibuf;
+        s = sqrt(s);
+        for i = istart:iend
+            ws.z(i) = ws.z(i) / s;
+        end
 
-        % Store the preconditioned vector
-        if isempty(coder.target)
-            v = ILUsol(M, v);
-        else
-            [v, w, y2] = MILUsolve(M, v, w, y2);
+        % Compute the preconditioned vector and store into Z(:, j)
+        OMP_barrier;
+        OMP_begin_single;
+        if j == 1
+            ws.y(1) = - beta;
+        end
+        if isempty(op.poly) && isempty(coder.target)
+            ws.z = ILUsol(M, ws.z);
+        elseif isempty(op.poly)
+            [ws.z, ws.w, ws.y2] = MILUsolve(M, ws.z, ws.w, ws.y2);
+        end
+        OMP_end_single;
+        if ~isempty(op.poly)
+            ws = MILU_polysolve_thread(A, M, op, ws);
+        end
+
+        for i = istart:iend
+            ws.Z(i, j) = ws.z(i);
         end
 
-        Z(:, j) = v;
-        w = crs_prodAx(A, Z(:, j), w, nthreads);
+        % Compute w = A*z fused with V(:,1)'*w for the first reflector
+        [ws.w, s2] = MILU_prodAxdot_thread(A, op, ws.z, ws.w, ws.V, int32(1));
 
         % Orthogonalize the Krylov vector
         %  Form Pj*Pj-1*...P1*Av.
-        if isempty(coder.target)
-            % This is faster when interpreted
-            for i = 1:j
-                w = w - 2 * (V(:, i)' * w) * V(:, i);
-            end
-        else
-            % This is faster when compiled
-            for i = 1:j
-                s = conj(V(i, i)) * w(i);
-                for k = i + 1:n
-                    s = s + conj(V(k, i)) * w(k);
+        for k = 1:j
+            if k == 1
+                s = s2(1);
+            else
+                s = 0.0;
+                for i = max(istart, k):iend
+                    s = s + ws.V(i, k) * ws.w(i);
                 end
-                s = s * 2;
+            end
+            [s, buf] = MILU_allreduce(s, buf, ibuf);
+            ibuf = 3 - ibuf;
+            s = 2 * s;
 
-                for k = i:n
-                    w(k) = w(k) - s * V(k, i);
-                end
+            for i = max(istart, k):iend
+                ws.w(i) = ws.w(i) - s * ws.V(i, k);
             end
         end
 
         % Update the rotators
         % Determine Pj+1.
         if j < n
-            %  Construct u for Householder reflector Pj+1.
-            u(j) = 0;
-            u(j+1) = w(j+1);
-            alpha2 = conj(w(j+1)) * w(j+1);
-            for k = j + 2:n
-                u(k) = w(k);
-                alpha2 = alpha2 + conj(w(k)) * w(k);
+            %  Compute the norm of w(j+1:n) and obtain w(j+1).
+            red(1) = 0.0;
+            red(2) = 0.0;
+            for i = max(istart, j + 1):iend
+                red(1) = red(1) + ws.w(i) * ws.w(i);
+            end
+            if istart <= j + 1 && j + 1 <= iend
+                red(2) = ws.w(j+1);
             end
+            [red, buf] = MILU_allreduce(red, buf, ibuf);
+            ibuf = 3 - ibuf;
+            alpha2 = red(1);
 
             if alpha2 > 0
                 alpha = sqrt(alpha2);
-                if u(j+1) < 0
+                if red(2) < 0
                     alpha = -alpha;
                 end
                 if j < restart
-                    updated_norm = sqrt(2*alpha2+2*real(u(j+1))*alpha);
-                    u(j+1) = u(j+1) + alpha;
-                    for k = j + 1:n
-                        V(k, j+1) = u(k) / updated_norm;
+                    %  Construct u for Householder reflector Pj+1.
+                    updated_norm = sqrt(2*alpha2+2*red(2)*alpha);
+                    for i = istart:min(iend, j)
+                        ws.V(i, j+1) = 0;
+                    end
+                    for i = max(istart, j + 1):iend
+                        ws.V(i, j+1) = ws.w(i) / updated_norm;
+                    end
+                    if istart <= j + 1 && j + 1 <= iend
+                        ws.V(j+1, j+1) = (red(2) + alpha) / updated_norm;
                     end
                 end
 
                 %  Apply Pj+1 to v.
-                w(j+2:end) = 0;
-                w(j+1) = - alpha;
+                for i = max(istart, j + 2):iend
+                    ws.w(i) = 0;
+                end
+                if istart <= j + 1 && j + 1 <= iend
+                    ws.w(j+1) = - alpha;
+                end
             end
         end
 
+        OMP_barrier;
+        OMP_begin_single;
         %  Apply Given's rotations to the newly formed v.
         for colJ = 1:j - 1
-            tmpv = w(colJ);
-            w(colJ) = conj(J(1, colJ)) * w(colJ) + conj(J(2, colJ)) * w(colJ+1);
-            w(colJ+1) = - J(2, colJ) * tmpv + J(1, colJ) * w(colJ+1);
+            tmpv = ws.w(colJ);
+            ws.w(colJ) = conj(ws.J(1, colJ)) * ws.w(colJ) + conj(ws.J(2, colJ)) * ws.w(colJ+1);
+            ws.w(colJ+1) = - ws.J(2, colJ) * tmpv + ws.J(1, colJ) * ws.w(colJ+1);
         end
 
         %  Compute Given's rotation Jm.
         if j < n
-            rho = sqrt(w(j)'*w(j)+w(j+1)'*w(j+1));
-            J(1, j) = w(j) ./ rho;
-            J(2, j) = w(j+1) ./ rho;
-            y(j+1) = - J(2, j) .* y(j);
-            y(j) = conj(J(1, j)) .* y(j);
-            w(j) = rho;
+            rho = sqrt(ws.w(j)'*ws.w(j)+ws.w(j+1)'*ws.w(j+1));
+            ws.J(1, j) = ws.w(j) ./ rho;
+            ws.J(2, j) = ws.w(j+1) ./ rho;
+            ws.y(j+1) = - ws.J(2, j) .* ws.y(j);
+            ws.y(j) = conj(ws.J(1, j)) .* ws.y(j);
+            ws.w(j) = rho;
+        else
+            % The Krylov subspace is the whole space, so the least-squares
+            % residual vanishes. ws.y may hold a stale entry here.
+            ws.y(j+1) = 0;
         end
 
-        R(1:j, j) = w(1:j);
+        ws.R(1:j, j) = ws.w(1:j);
+        OMP_end_single;
 
         resid_prev = resid;
-        resid = abs(y(j+1)) / beta0;
+        resid = abs(ws.y(j+1)) / beta0;
         if resid >= resid_prev * (1 - 1.e-8)
             flag = int32(3); % stagnated
             break
@@ -218,14 +320,14 @@ for it_outer = 1:max_outer_iters
         end
         iter = iter + 1;
 
+        OMP_begin_master;
         if verbose > 1
             m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
         end
 
         % save the residual
-        if nargout > 3
-            resids(iter) = resid;
-        end
+        ws.resids(iter) = resid;
+        OMP_end_master;
 
         if resid < rtol || j >= restart
             break;
@@ -233,14 +335,22 @@ for it_outer = 1:max_outer_iters
         j = j + 1;
     end
 
+    OMP_begin_master;
     if verbose == 1 || verbose >1 && flag
         m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
     end
+    OMP_end_master;
 
     % Compute correction vector
-    y = backsolve(R, y, j);
-    for i = 1:j
-        x = x + y(i) * Z(:, i);
+    OMP_barrier;
+    OMP_begin_single;
+    ws.y = backsolve(ws.R, ws.y, j);
+    OMP_end_single;
+
+    for k = 1:j
+        for i = istart:iend
+            x(i) = x(i) + ws.y(k) * ws.Z(i, k);
+        end
     end
 
     if resid < rtol || flag
@@ -248,12 +358,13 @@ for it_outer = 1:max_outer_iters
     end
 end
 
-if nargout > 3
-    resids = resids(1:iter);
-end
-
 if resid <= rtol * (1 + 1.e-8)
     flag = int32(0);
 end
 
+OMP_begin_master;
+info(1) = flag;
+info(2) = iter;
+OMP_end_master;
+
 end
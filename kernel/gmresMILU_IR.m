@@ -0,0 +1,299 @@
+function [x, flag, iter, resids] = gmresMILU_IR(A, b, ...
+    M, restart, rtol, maxit, x0, verbose, nthreads, op, inner_rtol)
+%gmresMILU_IR Kernel of gmresMILU using mixed-precision iterative refinement
+%
+%   x = gmresMILU_IR(A, b, M, restart, rtol, maxit, x0, verbose, nthreads)
+%     when uncompiled, call this kernel function by passing the M
+%     struct returned by MILUfactor
+%
+%   [x, flag, iter, resids] = gmresMILU_IR(...)
+%
+%   [x, flag, iter, resids] = gmresMILU_IR(..., op) uses the partition
+%     of the rows of A in op created by MILUoperator. Its SELL-C-sigma
+%     representation and its polynomial preconditioner are not used.
+%
+%   [x, flag, iter, resids] = gmresMILU_IR(..., op, inner_rtol) specifies
+%     the relative tolerance of each inner solve. The default is 1.e-4.
+%
+% See also: gmresMILU, gmresMILU_MGS
+
+% Note: The outer loop computes the residual r = b - A*x and updates x in
+% double precision. Each step solves A*d = r approximately by one cycle of
+% restarted GMRES with modified Gram-Schmidt, in which the Krylov bases,
+% the Hessenberg matrix and the products with A use single precision.
+% The preconditioner is applied to single-precision vectors converted to
+% double, since the ILUPACK factors are available in double only. The
+% attainable accuracy is determined by the outer loop, so rtol can be far
+% below the unit roundoff of single precision. Each inner cycle runs in a
+% single parallel region, like gmres_mgs_region in gmresMILU_MGS.
+
+%#codegen -args {crs_matrix, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
+%#codegen m2c_vec, int32(0), int32(0), MILU_Op, 0.}
+%#codegen gmresMILU_IR_10args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0), MILU_Op}
+%#codegen gmresMILU_IR_9args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0)}
+
+n = int32(size(b, 1));
+flag = int32(0);
+iter = int32(0);
+
+% If RHS is zero, terminate
+bnrm2 = sqrt(vec_sqnorm2(b));
+if bnrm2 == 0
+    x = zeros(n, 1);
+    resids = 0;
+    return;
+end
+
+if nargin < 11
+    inner_rtol = 1.e-4;
+end
+
+% Number of inner iterations
+if restart > n
+    restart = n;
+elseif restart <= 0
+    restart = int32(1);
+end
+
+% Initialize x
+if isempty(x0)
+    x = zeros(n, 1);
+else
+    x = x0;
+end
+
+% Partition of the rows among the threads
+if nargin < 10
+    op = MILUoperator(A, nthreads);
+end
+
+% Single-precision copy of the values of A, Krylov subspace, preconditioned
+% subspace, local linear system, Given's rotations, and buffer spaces
+val = single(A.val);
+V = zeros(n, restart, 'single');
+Z = zeros(n, restart, 'single');
+R = zeros(restart, restart, 'single');
+J = zeros(2, restart, 'single');
+y = zeros(restart + 1, 1, 'single');
+w = zeros(n, 1, 'single');
+d = zeros(n, 1, 'single');
+
+% Shared buffer for reductions and iteration count
+buf = zeros(1, 2 * max(nthreads, int32(1)), 'single');
+info = zeros(1, 1, 'int32');
+
+% Double-precision residual and buffers for the preconditioner
+r = zeros(n, 1);
+z = zeros(n, 1);
+y1 = zeros(n, 1);
+if ~isempty(coder.target)
+    y2 = zeros(M(1).negE.nrows, 1);
+else
+    y2 = zeros(0, 1);
+end
+resids = zeros(maxit, 1);
+
+resid = 1;
+while true
+    % Compute the residual and its norm in double precision
+    [r, rnrm2] = MILU_residual(A, op, x, b, r, nthreads);
+    rnrm = sqrt(rnrm2);
+    resid_prev = resid;
+    resid = rnrm / bnrm2;
+
+    if verbose > 0
+        m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
+    end
+
+    if resid <= rtol
+        flag = int32(0);
+        break
+    elseif resid >= resid_prev * (1 - 1.e-8) && iter > 0
+        flag = int32(3); % stagnated
+        break
+    elseif iter >= maxit
+        flag = int32(1); % reached maxit
+        break
+    end
+
+    % Solve A*d = r/||r|| to the inner tolerance in single precision
+    for i = 1:n
+        w(i) = single(r(i) / rnrm);
+    end
+    info(1) = iter;
+    inner = max(inner_rtol, rtol / resid);
+    if isempty(coder.target) || nthreads <= 1
+        [d, V, Z, R, J, y, w, z, y1, y2, resids, buf, info] = ...
+            gmres_single_region(A, val, op, M, restart, inner, maxit, ...
+            verbose, resid, d, V, Z, R, J, y, w, z, y1, y2, resids, buf, info);
+    else
+        %#omp parallel default(shared) num_threads(nthreads)
+        [d, V, Z, R, J, y, w, z, y1, y2, resids, buf, info] = ...
+            gmres_single_region(A, val, op, M, restart, inner, maxit, ...
+            verbose, resid, d, V, Z, R, J, y, w, z, y1, y2, resids, buf, info);
+    end
+    iter = info(1);
+
+    % Update the solution in double precision
+    for i = 1:n
+        x(i) = x(i) + rnrm * double(d(i));
+    end
+end
+
+if nargout > 3
+    resids = resids(1:iter);
+end
+
+end
+
+function [d, V, Z, R, J, y, w, z, y1, y2, resids, buf, info] = ...
+    gmres_single_region(A, val, op, M, restart, rtol, maxit, verbose, ...
+    scale, d, V, Z, R, J, y, w, z, y1, y2, resids, buf, info)
+% One cycle of GMRES in single precision for the right-hand side in w,
+% which must have unit norm. The relative residuals of the inner iterations
+% are multiplied by scale to save those of the original system in resids.
+% The iteration count is passed in and out through info(1).
+%
+% This is the body of the parallel region, executed by every thread. Each
+% thread owns the rows given by op.part in all vectors, the inner products
+% are summed by MILU_allreduce, and one thread applies the preconditioner
+% and updates the Hessenberg matrix and the Given's rotations in omp
+% single blocks.
+
+coder.inline('never');
+
+[istart, iend] = MILU_range(A.nrows, op.part);
+
+% Column of the Hessenberg matrix, private to each thread
+h = zeros(restart, 1, 'single');
+ibuf = int32(1);
+iter = info(1);
+
+% The first Q vector
+for i = istart:iend
+    V(i, 1) = w(i);
+end
+
+resid = single(1);
+j = int32(1);
+while true
+    % Compute the preconditioned vector in double precision
+    for i = istart:iend
+        z(i) = double(V(i, j));
+    end
+    OMP_barrier;
+    OMP_begin_single;
+    if j == 1
+        y(1) = 1;
+    end
+    if isempty(coder.target)
+        z = ILUsol(M, z);
+    else
+        [z, y1, y2] = MILUsolve(M, z, y1, y2);
+    end
+    OMP_end_single;
+
+    % Store the preconditioned vector and compute w = A*z in single
+    % precision. The rows of z are complete after the single block.
+    for i = istart:iend
+        Z(i, j) = single(z(i));
+        t = single(0);
+        for k = A.row_ptr(i):A.row_ptr(i+1) - 1
+            t = t + val(k) * single(z(A.col_ind(k)));
+        end
+        w(i) = t;
+    end
+
+    % Perform Gram-Schmidt orthogonalization and store column of R in h
+    for k = 1:j
+        s = single(0);
+        for i = istart:iend
+            s = s + w(i) * V(i, k);
+        end
+        [s, buf] = MILU_allreduce(s, buf, ibuf);
+        ibuf = 3 - ibuf;
+
+        h(k) = s;
+        for i = istart:iend
+            w(i) = w(i) - s * V(i, k);
+        end
+    end
+
+    vnorm2 = single(0);
+    for i = istart:iend
+        vnorm2 = vnorm2 + w(i) * w(i);
+    end
+    [vnorm2, buf] = MILU_allreduce(vnorm2, buf, ibuf);
+    ibuf = 3 - ibuf;
+    vnorm = sqrt(vnorm2);
+
+    if j < restart && vnorm > 0
+        for i = istart:iend
+            V(i, j+1) = w(i) / vnorm;
+        end
+    end
+
+    OMP_begin_single;
+    %  Apply Given's rotations to h.
+    for colJ = 1:j-1
+        tmpv = h(colJ);
+        h(colJ) = J(1, colJ) * h(colJ) + J(2, colJ) * h(colJ+1);
+        h(colJ+1) = - J(2, colJ) * tmpv + J(1, colJ) * h(colJ+1);
+    end
+
+    %  Compute Given's rotation Jm.
+    rho = sqrt(h(j)*h(j)+vnorm2);
+    J(1, j) = h(j) ./ rho;
+    J(2, j) = vnorm ./ rho;
+    y(j+1) = - J(2, j) .* y(j);
+    y(j) = J(1, j) .* y(j);
+    h(j) = rho;
+    R(1:j, j) = h(1:j);
+    OMP_end_single;
+
+    resid_prev = resid;
+    resid = abs(y(j+1));
+    iter = iter + 1;
+
+    OMP_begin_master;
+    if verbose > 1
+        m2c_printf('At iteration %d, estimated relative residual is %g.\n', ...
+            iter, scale * double(resid));
+    end
+    resids(iter) = scale * double(resid);
+    OMP_end_master;
+
+    if resid < rtol || j >= restart || iter >= maxit || ...
+            resid >= resid_prev * (1 - 1.e-6) || vnorm == 0
+        break;
+    end
+    j = j + 1;
+end
+
+% Solve the upper triangular system and compute the correction
+OMP_barrier;
+OMP_begin_single;
+for k = j:-1:1
+    t = y(k);
+    for i = k+1:j
+        t = t - R(k, i) * y(i);
+    end
+    y(k) = t / R(k, k);
+end
+OMP_end_single;
+
+for i = istart:iend
+    t = single(0);
+    for k = 1:j
+        t = t + y(k) * Z(i, k);
+    end
+    d(i) = t;
+end
+
+OMP_begin_master;
+info(1) = iter;
+OMP_end_master;
+
+end
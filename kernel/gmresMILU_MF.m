@@ -0,0 +1,36 @@
+function [x, flag, iter, resids, ws] = gmresMILU_MF(Afunc, b, ...
+    M, restart, rtol, maxit, x0, verbose, nthreads, ws)
+%gmresMILU_MF Matrix-free kernel of gmresMILU using modified Gram-Schmidt
+%
+%   x = gmresMILU_MF(Afunc, b, M, restart, rtol, maxit, x0, verbose, nthreads)
+%     solves A*x = b, where A is available only through the products
+%     y = A*x. When uncompiled, Afunc is a function handle and M is the
+%     prec struct returned by MILUfactor. When compiled, Afunc is a
+%     MILU_Afunc object wrapping a callback defined in milu_afunc.h, such
+%     as one created by MILUafunc. The preconditioner M can be built from
+%     an assembled approximation of A.
+%
+%   [x, flag, iter, resids] = gmresMILU_MF(...)
+%
+%   [x, flag, iter, resids, ws] = gmresMILU_MF(..., ws)
+%     uses the buffers in the workspace ws created by gmresMILU_workspace
+%     and returns it for reuse in subsequent solves.
+%
+% See also: gmresMILU, gmresMILU_MGS, MILU_Afunc, MILUafunc
+
+% Note: This is gmresMILU_MGS with the argument types of a matrix-free A,
+% so that the compiled kernel has an entry that takes a MILU_Afunc object.
+% The vector operations are split evenly among nthreads threads, and the
+% callback is invoked by the master thread. See MILU_Afunc_thread.
+
+%#codegen -args {MILU_Afunc, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
+%#codegen m2c_vec, int32(0), int32(0), MILU_Workspace}
+%#codegen gmresMILU_MF_9args -args {MILU_Afunc, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0)}
+
+if nargin < 10
+    ws = gmresMILU_workspace(int32(size(b, 1)), restart, maxit, M);
+end
+
+[x, flag, iter, resids, ws] = gmresMILU_MGS(Afunc, b, M, restart, ...
+    rtol, maxit, x0, verbose, nthreads, ws);
@@ -1,5 +1,5 @@
-function [x, flag, iter, resids] = gmresMILU_MGS(A, b, ...
-    M, restart, rtol, maxit, x0, verbose, nthreads)
+function [x, flag, iter, resids, ws] = gmresMILU_MGS(A, b, ...
+    M, restart, rtol, maxit, x0, verbose, nthreads, ws, op)
 %gmresMILU_MGS Kernel of gmresMILU using modified Gram-Schmidt
 %
 %   x = gmresMILU_MGS(A, b, M, restart, rtol, maxit, x0, verbose, nthreads)
@@ -8,14 +8,32 @@ function [x, flag, iter, resids] = gmresMILU_MGS(A, b, ...
 %
 %   [x, flag, iter, resids] = gmresMILU_MGS(...)
 %
-% See also: gmresMILU, gmresMILU_CGS, gmresMILU_HO
+%   [x, flag, iter, resids, ws] = gmresMILU_MGS(..., ws)
+%     uses the buffers in the workspace ws created by gmresMILU_workspace
+%     and returns it for reuse in subsequent solves.
+%
+%   [x, flag, iter, resids, ws] = gmresMILU_MGS(..., ws, op)
+%     multiplies by A using the partition and the optional SELL-C-sigma
+%     representation of A in op created by MILUoperator. If op.poly is
+%     not empty, the preconditioner is M\p(A/M) with the polynomial p
+%     created by MILUpoly. See MILU_polysolve_thread.
+%
+%   A can also be matrix-free, i.e., a function handle when uncompiled or
+%   a MILU_Afunc object when compiled, whose products are computed through
+%   MILU_Afunc_thread. The compiled entry for this case is gmresMILU_MF.
+%
+% See also: gmresMILU, gmresMILU_CGS, gmresMILU_HO, gmresMILU_MF
 
 % Note: The algorithm uses the modified Gram-Schmidt orthogonalization.
 % It has less parallelism than classical Gram-Schmidt but is more stable.
 % It is also less stable than the Householder algorithm.
 
 %#codegen -args {crs_matrix, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
-%#codegen m2c_vec, int32(0), int32(0)}
+%#codegen m2c_vec, int32(0), int32(0), MILU_Workspace, MILU_Op}
+%#codegen gmresMILU_MGS_10args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0), MILU_Workspace}
+%#codegen gmresMILU_MGS_9args -args {crs_matrix, m2c_vec, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_vec, int32(0), int32(0)}
 
 n = int32(size(b, 1));
 
@@ -26,6 +44,9 @@ if beta0 == 0
     flag = int32(0);
     iter = int32(0);
     resids = 0;
+    if nargin < 10
+        ws = gmresMILU_workspace(n, restart, maxit, M);
+    end
     return;
 end
 
@@ -46,92 +67,168 @@ else
     x = x0;
 end
 
-% Local linear system
-y = zeros(restart+1, 1);
-R = zeros(restart, restart);
+% Krylov subspace, preconditioned subspace, local linear system, Given's
+% rotations, and buffer spaces. Reuse the workspace if given, without
+% clearing it, since every entry is written before it is read.
+if nargin < 10
+    ws = gmresMILU_workspace(n, restart, maxit, M);
+else
+    ws = gmresMILU_workspace(n, restart, maxit, M, ws);
+end
 
-% Orthognalized Krylov subspace
-Q = zeros(n, restart);
+% Partition of the rows among the threads
+if nargin < 11
+    op = MILUoperator(A, nthreads);
+end
 
-% Preconditioned subspace
-Z = zeros(n, restart);
+% Buffers for the polynomial preconditioner
+if ~isempty(op.poly) && size(ws.P, 2) < 2
+    ws.P = coder.nullcopy(zeros(n, 2));
+end
 
-% Given's rotation vectors
-J = zeros(2, restart);
+% Shared buffer for reductions and flag and iteration count
+buf = zeros(2, 2 * max(nthreads, int32(1)));
+info = zeros(2, 1, 'int32');
+xnz = vec_sqnorm2(x) > 0;
 
-% Buffer spaces
-v = zeros(n, 1);
-if ~isempty(coder.target)
-    y2 = zeros(M(1).negE.nrows, 1);
+if isempty(coder.target) || nthreads <= 1
+    [x, ws, buf, info] = gmres_mgs_region(A, b, M, op, restart, rtol, ...
+        maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info);
+else
+    %#omp parallel default(shared) num_threads(nthreads)
+    [x, ws, buf, info] = gmres_mgs_region(A, b, M, op, restart, rtol, ...
+        maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info);
 end
 
+flag = info(1);
+iter = info(2);
 if nargout > 3
-    resids = zeros(maxit, 1);
+    resids = ws.resids(1:iter);
+end
+
 end
 
+function [x, ws, buf, info] = gmres_mgs_region(A, b, M, op, restart, rtol, ...
+    maxit, verbose, beta0, max_outer_iters, xnz, x, ws, buf, info)
+% Body of the parallel region, executed by every thread. Each thread owns
+% the rows given by op.part in all vectors, the inner products are summed
+% by MILU_allreduce, and one thread applies the preconditioner and updates
+% the Hessenberg matrix and the Given's rotations in omp single blocks.
+
+coder.inline('never');
+
+[istart, iend] = MILU_range(int32(size(b, 1)), op.part);
+
+% Column of the Hessenberg matrix, private to each thread
+h = zeros(restart, 1);
+ibuf = int32(1);
+
 flag = int32(0);
 iter = int32(0);
 resid = 1;
+j = int32(1);
 for it_outer = 1:max_outer_iters
-    % Compute the initial residual
-    if it_outer > 1 || vec_sqnorm2(x) > 0
-        v = crs_prodAx(A, x, v, nthreads);
-        v = b - v;
+    % Compute the initial residual fused with its norm
+    beta2 = 0.0;
+    if it_outer > 1 || xnz
+        OMP_barrier;
+        [ws.w, beta2] = MILU_residual_thread(A, op, x, b, ws.w);
     else
-        v = b;
+        for i = istart:iend
+            ws.w(i) = b(i);
+            beta2 = beta2 + ws.w(i) * ws.w(i);
+        end
     end
-
-    beta2 = vec_sqnorm2(v);
+    [beta2, buf] = MILU_allreduce(beta2, buf, ibuf);
+    ibuf = 3 - ibuf;
     beta = sqrt(beta2);
 
     % The first Q vector
-    y(1) = beta;
-    Q(:, 1) = v / beta;
+    for i = istart:iend
+        ws.V(i, 1) = ws.w(i) / beta;
+    end
 
     j = int32(1);
     while true
-        w = Q(:, j);
-        % Compute the preconditioned vector and store into v
-        if isempty(coder.target)
-            w = ILUsol(M, w);
-        else
-            [w, v, y2] = MILUsolve(M, w, v, y2);
+        % Compute the preconditioned vector and store into Z(:, j)
+        for i = istart:iend
+            ws.z(i) = ws.V(i, j);
+        end
+        OMP_barrier;
+        OMP_begin_single;
+        if j == 1
+            ws.y(1) = beta;
+        end
+        if isempty(op.poly) && isempty(coder.target)
+            ws.z = ILUsol(M, ws.z);
+        elseif isempty(op.poly)
+            [ws.z, ws.w, ws.y2] = MILUsolve(M, ws.z, ws.w, ws.y2);
+        end
+        OMP_end_single;
+        if ~isempty(op.poly)
+            ws = MILU_polysolve_thread(A, M, op, ws);
+        end
+
+        for i = istart:iend
+            ws.Z(i, j) = ws.z(i);
         end
 
-        % Store the preconditioned vector
-        Z(:, j) = w;
-        v = crs_prodAx(A, w, v, nthreads);
+        % Compute w = A*z fused with the first inner product V(:,1)'*w
+        [ws.w, s2] = MILU_prodAxdot_thread(A, op, ws.z, ws.w, ws.V, int32(1));
 
-        % Perform Gram-Schmidt orthogonalization and store column of R in w
+        % Perform Gram-Schmidt orthogonalization and store column of R in h
         for k = 1:j
-            w(k) = v' * Q(:, k);
-            v = v - w(k) * Q(:, k);
+            if k == 1
+                s = s2(1);
+            else
+                s = 0.0;
+                for i = istart:iend
+                    s = s + ws.w(i) * ws.V(i, k);
+                end
+            end
+            [s, buf] = MILU_allreduce(s, buf, ibuf);
+            ibuf = 3 - ibuf;
+
+            h(k) = s;
+            for i = istart:iend
+                ws.w(i) = ws.w(i) - s * ws.V(i, k);
+            end
         end
 
-        vnorm2 = vec_sqnorm2(v);
+        vnorm2 = 0.0;
+        for i = istart:iend
+            vnorm2 = vnorm2 + ws.w(i) * ws.w(i);
+        end
+        [vnorm2, buf] = MILU_allreduce(vnorm2, buf, ibuf);
+        ibuf = 3 - ibuf;
         vnorm = sqrt(vnorm2);
+
         if j < restart
-            Q(:, j+1) = v / vnorm;
+            for i = istart:iend
+                ws.V(i, j+1) = ws.w(i) / vnorm;
+            end
         end
 
-        %  Apply Given's rotations to w.
+        OMP_begin_single;
+        %  Apply Given's rotations to h.
         for colJ = 1:j-1
-            tmpv = w(colJ);
-            w(colJ) = conj(J(1, colJ)) * w(colJ) + conj(J(2, colJ)) * w(colJ+1);
-            w(colJ+1) = - J(2, colJ) * tmpv + J(1, colJ) * w(colJ+1);
+            tmpv = h(colJ);
+            h(colJ) = conj(ws.J(1, colJ)) * h(colJ) + conj(ws.J(2, colJ)) * h(colJ+1);
+            h(colJ+1) = - ws.J(2, colJ) * tmpv + ws.J(1, colJ) * h(colJ+1);
         end
 
         %  Compute Given's rotation Jm.
-        rho = sqrt(w(j)'*w(j)+vnorm2);
-        J(1, j) = w(j) ./ rho;
-        J(2, j) = vnorm ./ rho;
-        y(j+1) = - J(2, j) .* y(j);
-        y(j) = conj(J(1, j)) .* y(j);
-        w(j) = rho;
-        R(1:j, j) = w(1:j);
+        rho = sqrt(h(j)'*h(j)+vnorm2);
+        ws.J(1, j) = h(j) ./ rho;
+        ws.J(2, j) = vnorm ./ rho;
+        ws.y(j+1) = - ws.J(2, j) .* ws.y(j);
+        ws.y(j) = conj(ws.J(1, j)) .* ws.y(j);
+        h(j) = rho;
+        ws.R(1:j, j) = h(1:j);
+        OMP_end_single;
 
         resid_prev = resid;
-        resid = abs(y(j+1)) / beta0;
+        resid = abs(ws.y(j+1)) / beta0;
         if resid >= resid_prev * (1 - 1.e-8)
             flag = int32(3); % stagnated
             break
@@ -141,14 +238,14 @@ for it_outer = 1:max_outer_iters
         end
         iter = iter + 1;
 
+        OMP_begin_master;
         if verbose > 1
             m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
         end
 
         % save the residual
-        if nargout > 3
-            resids(iter) = resid;
-        end
+        ws.resids(iter) = resid;
+        OMP_end_master;
 
         if resid < rtol || j >= restart
             break;
@@ -156,14 +253,22 @@ for it_outer = 1:max_outer_iters
         j = j + 1;
     end
 
+    OMP_begin_master;
     if verbose == 1 || verbose >1 && flag
         m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
     end
+    OMP_end_master;
 
     % Compute correction vector
-    y = backsolve(R, y, j);
-    for i = 1:j
-        x = x + y(i) * Z(:, i);
+    OMP_barrier;
+    OMP_begin_single;
+    ws.y = backsolve(ws.R, ws.y, j);
+    OMP_end_single;
+
+    for k = 1:j
+        for i = istart:iend
+            x(i) = x(i) + ws.y(k) * ws.Z(i, k);
+        end
     end
 
     if resid < rtol || flag
@@ -171,12 +276,13 @@ for it_outer = 1:max_outer_iters
     end
 end
 
-if nargout > 3
-    resids = resids(1:iter);
-end
-
 if resid <= rtol * (1 + 1.e-8)
     flag = int32(0);
 end
 
+OMP_begin_master;
+info(1) = flag;
+info(2) = iter;
+OMP_end_master;
+
 end
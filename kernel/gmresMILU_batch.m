@@ -0,0 +1,103 @@
+function [x, flags, iters] = gmresMILU_batch(As, b, bptr, Ms, mptr, ...
+    restart, rtol, maxit, nthreads)
+%gmresMILU_batch Kernel of gmresMILUbatch for many independent systems
+%
+%   [x, flags, iters] = gmresMILU_batch(As, b, bptr, Ms, mptr, restart,
+%   rtol, maxit, nthreads) solves As(k)*x_k = b_k for k = 1:numel(As),
+%   where As is an array of crs_matrix, b_k = b(bptr(k):bptr(k+1)-1), and
+%   the preconditioner of the kth system is Ms(mptr(k):mptr(k+1)-1). The
+%   solutions are returned in x with the same layout as b, together with
+%   the flags and iteration counts of gmresMILU_MGS for every system.
+%   When uncompiled, Ms are the prec structs returned by MILUfactor.
+%
+% See also: gmresMILUbatch, gmresMILU_MGS
+
+% Note: Each system is solved by one thread with gmresMILU_MGS, and the
+% threads share no data except the disjoint parts of the outputs. The
+% systems are dealt to the threads round-robin in the order of decreasing
+% numbers of nonzeros to balance the load. Each thread keeps its own
+% workspace, which grows to the largest system it solves. The kernel is
+% called inside a team of one thread, so that its barriers and reductions
+% refer to that thread only and there is no nested parallelism.
+
+%#codegen -args {coder.typeof(crs_matrix, [inf, 1]), m2c_vec, m2c_intvec,
+%#codegen MILU_Prec, m2c_intvec, int32(0), 0., int32(0), int32(0)}
+
+nsys = int32(numel(As));
+x = zeros(size(b, 1), 1);
+flags = zeros(nsys, 1, 'int32');
+iters = zeros(nsys, 1, 'int32');
+if nsys == 0
+    return;
+end
+
+% Deal the systems in the order of decreasing numbers of nonzeros
+nnzs = zeros(nsys, 1);
+for k = 1:nsys
+    nnzs(k) = double(As(k).row_ptr(As(k).nrows+1) - 1);
+end
+[~, order] = sort(nnzs, 'descend');
+order = int32(order);
+
+if isempty(coder.target) || nthreads <= 1
+    [x, flags, iters] = gmres_batch_region(As, b, bptr, Ms, mptr, order, ...
+        restart, rtol, maxit, x, flags, iters);
+else
+    %#omp parallel default(shared) num_threads(min(nthreads, nsys))
+    [x, flags, iters] = gmres_batch_region(As, b, bptr, Ms, mptr, order, ...
+        restart, rtol, maxit, x, flags, iters);
+end
+
+end
+
+function [x, flags, iters] = gmres_batch_region(As, b, bptr, Ms, mptr, ...
+    order, restart, rtol, maxit, x, flags, iters)
+% Body of the parallel region. Each thread solves the systems
+% order(tid+1:nthr:end) and writes their parts of x, flags and iters.
+
+coder.inline('never');
+
+nthr = int32(ompGetNumThreads);
+tid = int32(ompGetThreadNum);
+
+ws = gmresMILU_workspace(int32(0), restart, maxit, Ms);
+for t = tid + 1:nthr:int32(numel(order))
+    k = order(t);
+    [x, ws, flags(k), iters(k)] = gmres_batch_solve(As(k), b, bptr(k), ...
+        bptr(k+1) - 1, Ms(mptr(k):mptr(k+1) - 1), restart, rtol, ...
+        maxit, x, ws);
+end
+
+end
+
+function [x, ws, flag, iter] = gmres_batch_solve(A, b, istart, iend, M, ...
+    restart, rtol, maxit, x, ws)
+% Solve one system in a team of one thread
+
+coder.inline('never');
+
+flag = int32(0);
+iter = int32(0);
+if isempty(coder.target)
+    [x, ws, flag, iter] = gmres_batch_mgs(A, b, istart, iend, M, ...
+        restart, rtol, maxit, x, ws, flag, iter);
+else
+    %#omp parallel default(shared) num_threads(1)
+    [x, ws, flag, iter] = gmres_batch_mgs(A, b, istart, iend, M, ...
+        restart, rtol, maxit, x, ws, flag, iter);
+end
+
+end
+
+function [x, ws, flag, iter] = gmres_batch_mgs(A, b, istart, iend, M, ...
+    restart, rtol, maxit, x, ws, flag, iter)
+coder.inline('never');
+
+n = iend - istart + 1;
+ws = gmresMILU_workspace(n, restart, maxit, M, ws);
+op = MILUoperator(A, int32(1));
+[xk, flag, iter, ~, ws] = gmresMILU_MGS(A, b(istart:iend), M, restart, ...
+    rtol, maxit, zeros(0, 1), int32(0), int32(1), ws, op);
+x(istart:iend) = xk;
+
+end
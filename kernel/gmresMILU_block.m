@@ -0,0 +1,333 @@
+function [X, flag, iter, resids] = gmresMILU_block(A, B, ...
+    M, restart, rtol, maxit, X0, verbose, nthreads, op)
+%gmresMILU_block Kernel of gmresMILU for multiple right-hand sides
+%
+%   X = gmresMILU_block(A, B, M, restart, rtol, maxit, X0, verbose, nthreads)
+%     solves A*X=B for an n-by-k block B. When uncompiled, call this kernel
+%     function by passing the M struct returned by MILUfactor
+%
+%   [X, flag, iter, resids] = gmresMILU_block(...) returns the number of
+%     block iterations in iter and the relative residual of each column
+%     at each block iteration in the iter-by-k matrix resids.
+%
+%   [X, flag, iter, resids] = gmresMILU_block(..., op)
+%     splits the rows of A among the threads using the partition in op
+%     created by MILUoperator. Its SELL-C-sigma representation and its
+%     polynomial preconditioner are not used.
+%
+% See also: gmresMILU, gmresMILU_MGS
+
+% Note: The algorithm is block GMRES with modified Gram-Schmidt for the
+% block Arnoldi process and Householder reflectors for the least-squares
+% problem. All active columns share one block Krylov subspace, so each
+% iteration applies A and M to the whole block with one pass over each.
+% Converged columns are deflated at every restart, and residual columns
+% that are linearly dependent on the others do not enlarge the block.
+
+%#codegen -args {crs_matrix, m2c_mat, MILU_Prec, int32(0), 0., int32(0),
+%#codegen m2c_mat, int32(0), int32(0), MILU_Op}
+%#codegen gmresMILU_block_9args -args {crs_matrix, m2c_mat, MILU_Prec,
+%#codegen int32(0), 0., int32(0), m2c_mat, int32(0), int32(0)}
+
+n = int32(size(B, 1));
+k = int32(size(B, 2));
+
+% Initialize x
+if isempty(X0)
+    X = zeros(n, k);
+else
+    X = X0;
+end
+
+% Norms of the right-hand sides
+bnrms = zeros(k, 1);
+for c = 1:k
+    bnrms(c) = sqrt(vec_sqnorm2(B(:, c)));
+end
+
+% Number of inner block iterations
+if restart * k > n
+    restart = max(idivide(n, k), int32(1));
+elseif restart <= 0
+    restart = int32(1);
+end
+
+% Determine the maximum number of outer iterations
+max_outer_iters = int32(ceil(double(maxit)/double(restart)));
+
+% Partition of the rows among the threads
+if nargin < 10
+    op = MILUoperator(A, nthreads);
+end
+
+% Active (not yet converged) columns and their current residual norms
+act = zeros(k, 1, 'int32');
+rnrms = zeros(k, 1);
+relres = zeros(k, 1);
+
+% Block Krylov subspace and preconditioned subspace
+V = zeros(n, (restart+1)*k);
+Z = zeros(n, restart*k);
+
+% Block Hessenberg matrix, reduced to upper triangular in place
+H = zeros((restart+1)*k, restart*k);
+
+% Right-hand sides of the local least-squares problems
+G = zeros((restart+1)*k, k);
+
+% Householder vectors for the band of H
+U = zeros(k+1, restart*k);
+
+% Buffer spaces
+W = zeros(n, k);
+R = zeros(n, k);
+if ~isempty(coder.target)
+    Y1 = zeros(max(M(1).L.nrows, M(1).negE.nrows), k);
+    Y2 = zeros(M(1).negE.nrows, k);
+end
+
+if nargout > 3
+    resids = zeros(maxit, k);
+end
+
+flag = int32(0);
+iter = int32(0);
+resid = 1;
+for it_outer = 1:max_outer_iters
+    % Compute the residuals of all columns that have not converged yet
+    na = int32(0);
+    for c = 1:k
+        if bnrms(c) == 0
+            X(:, c) = 0;
+            relres(c) = 0;
+        elseif it_outer == 1 || relres(c) >= rtol
+            na = na + 1;
+            act(na) = c;
+            W(:, na) = X(:, c);
+        end
+    end
+
+    if it_outer > 1 || ~isempty(X0)
+        R = crs_prodAxBlock(A, W, R, na, nthreads, op.part);
+    else
+        R(:, 1:na) = 0;
+    end
+
+    % Deflate the columns whose true residuals have converged
+    nb = int32(0);
+    for c = 1:na
+        ic = act(c);
+        for i = 1:n
+            W(i, c) = B(i, ic) - R(i, c);
+        end
+        rnrm = sqrt(vec_sqnorm2(W(:, c)));
+        relres(ic) = rnrm / bnrms(ic);
+        if relres(ic) >= rtol
+            nb = nb + 1;
+            act(nb) = ic;
+            rnrms(nb) = rnrm;
+            if nb < c
+                W(:, nb) = W(:, c);
+            end
+        end
+    end
+    na = nb;
+
+    if na == 0
+        resid = max(relres);
+        break
+    end
+
+    % Orthonormalize the residual block. Columns that are dependent on
+    % the previous ones contribute only to the coefficients in G.
+    G(:, 1:na) = 0;
+    pb = int32(0);
+    for c = 1:na
+        for i = 1:pb
+            G(i, c) = W(:, c)' * V(:, i);
+            W(:, c) = W(:, c) - G(i, c) * V(:, i);
+        end
+        wnorm = sqrt(vec_sqnorm2(W(:, c)));
+        if wnorm > 1.e-12 * rnrms(c)
+            pb = pb + 1;
+            V(:, pb) = W(:, c) / wnorm;
+            G(pb, c) = wnorm;
+        end
+    end
+
+    nv = pb;
+    ncol = int32(0);
+    breakdown = false;
+    j = int32(1);
+    while true
+        % Compute the preconditioned block and store into W
+        for c = 1:pb
+            W(:, c) = V(:, ncol + c);
+        end
+        if isempty(coder.target)
+            for c = 1:pb
+                W(:, c) = ILUsol(M, W(:, c));
+            end
+        else
+            [W, Y1, Y2] = MILUsolveBlock(M, W, Y1, Y2, pb);
+        end
+
+        % Store the preconditioned block
+        for c = 1:pb
+            Z(:, ncol + c) = W(:, c);
+        end
+        R = crs_prodAxBlock(A, W, R, pb, nthreads, op.part);
+
+        % Perform block Arnoldi with modified Gram-Schmidt
+        for c = 1:pb
+            col = ncol + c;
+            rnorm0 = sqrt(vec_sqnorm2(R(:, c)));
+            for i = 1:nv
+                H(i, col) = R(:, c)' * V(:, i);
+                R(:, c) = R(:, c) - H(i, col) * V(:, i);
+            end
+
+            rnorm = sqrt(vec_sqnorm2(R(:, c)));
+            H(nv + 1, col) = rnorm;
+            nv = nv + 1;
+            if rnorm > 1.e-14 * rnorm0
+                V(:, nv) = R(:, c) / rnorm;
+            else
+                V(:, nv) = 0;
+                breakdown = true;
+            end
+        end
+
+        % Reduce the new columns of H to upper triangular form
+        nc = pb;
+        for c = 1:pb
+            col = ncol + c;
+
+            % Apply the previous reflectors
+            for i = 1:col - 1
+                s = 0;
+                for t = 0:pb
+                    s = s + U(t+1, i) * H(i+t, col);
+                end
+                s = 2 * s;
+                for t = 0:pb
+                    H(i+t, col) = H(i+t, col) - s * U(t+1, i);
+                end
+            end
+
+            % Compute the reflector that eliminates H(col+1:col+pb, col)
+            alpha2 = 0;
+            for t = 0:pb
+                alpha2 = alpha2 + H(col+t, col) * H(col+t, col);
+            end
+            alpha = sqrt(alpha2);
+            if H(col, col) > 0
+                alpha = -alpha;
+            end
+            U(1, col) = H(col, col) - alpha;
+            unorm2 = U(1, col) * U(1, col);
+            for t = 1:pb
+                U(t+1, col) = H(col+t, col);
+                unorm2 = unorm2 + U(t+1, col) * U(t+1, col);
+            end
+            if unorm2 == 0
+                % H(col:col+pb, col) is zero, so the block Krylov subspace
+                % is rank deficient. Keep the columns before col, whose
+                % diagonal is nonzero, and end the cycle.
+                nc = c - 1;
+                breakdown = true;
+                break
+            end
+            unorm = sqrt(unorm2);
+            for t = 0:pb
+                U(t+1, col) = U(t+1, col) / unorm;
+            end
+            H(col, col) = alpha;
+            for t = 1:pb
+                H(col+t, col) = 0;
+            end
+
+            % Apply the reflector to the right-hand sides
+            for c2 = 1:na
+                s = 0;
+                for t = 0:pb
+                    s = s + U(t+1, col) * G(col+t, c2);
+                end
+                s = 2 * s;
+                for t = 0:pb
+                    G(col+t, c2) = G(col+t, c2) - s * U(t+1, col);
+                end
+            end
+        end
+        ncol = ncol + nc;
+
+        % Estimate the residual of each active column
+        resid_prev = resid;
+        resid = 0;
+        for c = 1:na
+            s = 0;
+            for t = 1:pb
+                s = s + G(ncol+t, c) * G(ncol+t, c);
+            end
+            relres(act(c)) = sqrt(s) / bnrms(act(c));
+            resid = max(resid, relres(act(c)));
+        end
+
+        if resid >= resid_prev * (1 - 1.e-8)
+            flag = int32(3); % stagnated
+            break
+        elseif iter >= maxit
+            flag = int32(1); % reached maxit
+            break
+        end
+        iter = iter + 1;
+
+        if verbose > 1
+            m2c_printf('At iteration %d, maximum relative residual is %g.\n', iter, resid);
+        end
+
+        % save the residuals
+        if nargout > 3
+            for c = 1:k
+                resids(iter, c) = relres(c);
+            end
+        end
+
+        if resid < rtol || j >= restart || breakdown
+            break;
+        end
+        j = j + 1;
+    end
+
+    if verbose == 1 || verbose >1 && flag
+        m2c_printf('At iteration %d, maximum relative residual is %g.\n', iter, resid);
+    end
+
+    % Compute the correction of each active column
+    for c = 1:na
+        for i = ncol:-1:1
+            G(i, c) = G(i, c) / H(i, i);
+            for t = 1:i-1
+                G(t, c) = G(t, c) - G(i, c) * H(t, i);
+            end
+        end
+        ic = act(c);
+        for i = 1:ncol
+            X(:, ic) = X(:, ic) + G(i, c) * Z(:, i);
+        end
+    end
+
+    if resid < rtol || flag
+        break;
+    end
+end
+
+if nargout > 3
+    resids = resids(1:iter, :);
+end
+
+if resid <= rtol * (1 + 1.e-8)
+    flag = int32(0);
+end
+
+end
@@ -0,0 +1,79 @@
+function ws = gmresMILU_workspace(n, restart, maxit, M, ws)
+%gmresMILU_workspace Create or resize the workspace of the GMRES kernels
+%
+%   ws = gmresMILU_workspace(n, restart, maxit, M) allocates the buffers
+%   used by gmresMILU_HO, gmresMILU_MGS and gmresMILU_CGS for a system of
+%   size n with preconditioner M.
+%
+%   ws = gmresMILU_workspace(n, restart, maxit, M, ws) reuses the buffers
+%   in ws and only reallocates those that are too small. Create the
+%   workspace once and pass it to every solve to avoid allocating and
+%   clearing the Krylov subspaces in each call.
+%
+%   The buffers are not initialized. The kernels overwrite every entry
+%   before reading it. The buffer P for the polynomial preconditioner has
+%   no columns and is allocated by the kernels when needed.
+%
+% See also: gmresMILU, gmresMILU_HO, gmresMILU_MGS, gmresMILU_CGS
+
+%#codegen -args {int32(0), int32(0), int32(0), MILU_Prec, MILU_Workspace}
+%#codegen gmresMILU_workspace_4args -args {int32(0), int32(0), int32(0), MILU_Prec}
+
+if restart > n
+    restart = n;
+elseif restart <= 0
+    restart = int32(1);
+end
+
+if isempty(coder.target)
+    n2 = int32(0);
+else
+    n2 = M(1).negE.nrows;
+end
+
+if nargin < 5
+    ws = struct('V', coder.nullcopy(zeros(n, restart)), ...
+        'Z', coder.nullcopy(zeros(n, restart)), ...
+        'R', coder.nullcopy(zeros(restart, restart)), ...
+        'J', coder.nullcopy(zeros(2, restart)), ...
+        'y', coder.nullcopy(zeros(restart+1, 1)), ...
+        'w', coder.nullcopy(zeros(n, 1)), ...
+        'z', coder.nullcopy(zeros(n, 1)), ...
+        'P', coder.nullcopy(zeros(n, 0)), ...
+        'y2', coder.nullcopy(zeros(n2, 1)), ...
+        'resids', coder.nullcopy(zeros(maxit, 1)));
+    return;
+end
+
+% The vectors of length n must match exactly, since the kernels operate
+% on them as a whole. The other buffers only need to be large enough.
+if size(ws.V, 1) ~= n || size(ws.V, 2) < restart
+    ws.V = coder.nullcopy(zeros(n, restart));
+end
+if size(ws.Z, 1) ~= n || size(ws.Z, 2) < restart
+    ws.Z = coder.nullcopy(zeros(n, restart));
+end
+if size(ws.R, 1) < restart || size(ws.R, 2) < restart
+    ws.R = coder.nullcopy(zeros(restart, restart));
+end
+if size(ws.J, 1) ~= 2 || size(ws.J, 2) < restart
+    ws.J = coder.nullcopy(zeros(2, restart));
+end
+if size(ws.y, 1) < restart + 1
+    ws.y = coder.nullcopy(zeros(restart+1, 1));
+end
+if size(ws.w, 1) ~= n
+    ws.w = coder.nullcopy(zeros(n, 1));
+end
+if size(ws.z, 1) ~= n
+    ws.z = coder.nullcopy(zeros(n, 1));
+end
+if size(ws.P, 1) ~= n
+    ws.P = coder.nullcopy(zeros(n, 0));
+end
+if size(ws.y2, 1) < n2
+    ws.y2 = coder.nullcopy(zeros(n2, 1));
+end
+if size(ws.resids, 1) < maxit
+    ws.resids = coder.nullcopy(zeros(maxit, 1));
+end
@@ -0,0 +1,252 @@
+function [x, flag, iter, resids] = idrsMILU_kernel(A, b, ...
+    M, s, rtol, maxit, x0, verbose, nthreads)
+%idrsMILU_kernel Kernel of idrsMILU
+%
+%   x = idrsMILU_kernel(A, b, prec, s, rtol, maxit, x0, verbose, nthreads)
+%     when uncompiled, call this kernel function by passing the prec
+%     struct returned by MILUfactor
+%
+%   [x, flag, iter, resids] = idrsMILU_kernel(...)
+%
+% See also: idrsMILU, bicgstabMILU_kernel
+
+% Note: The algorithm is the biorthogonal variant of IDR(s) by van Gijzen
+% and Sonneveld, with right preconditioning. U stores the preconditioned
+% search directions and G = A*U, so that x is updated directly. Each
+% iteration performs one SpMV and one preconditioner solve, and every
+% s+1 iterations the last one is the dimension-reduction step, in which
+% omega is computed with the "maintaining the convergence" strategy.
+
+%#codegen -args {crs_matrix, m2c_vec, MILU_Prec, int32(0), 0., int32(0),
+%#codegen m2c_vec, int32(0), int32(0)}
+
+n = int32(size(b, 1));
+flag = int32(0);
+iter = int32(0);
+
+% If RHS is zero, terminate
+bnrm2 = sqrt(vec_sqnorm2(b));
+if bnrm2 == 0
+    x = zeros(n, 1);
+    resids = 0;
+    return;
+end
+
+% Initialize x
+if isempty(x0)
+    x = zeros(n, 1);
+else
+    x = x0;
+end
+
+% Buffer spaces
+r = zeros(n, 1);
+v = zeros(n, 1);
+t = zeros(n, 1);
+if ~isempty(coder.target)
+    y2 = zeros(M(1).negE.nrows, 1);
+end
+
+if nargout > 3
+    resids = zeros(maxit, 1);
+end
+
+% Partition of the rows among the threads
+op = MILUoperator(A, nthreads);
+
+% Compute the initial residual fused with its norm
+if vec_sqnorm2(x) > 0
+    [r, rnrm2] = MILU_residual(A, op, x, b, r, nthreads);
+    resid = sqrt(rnrm2) / bnrm2;
+else
+    r = b;
+    resid = 1.0;
+end
+if resid < rtol
+    resids = 0;
+    return
+end
+
+if s < 1
+    s = int32(1);
+end
+
+% Shadow space, search directions, and their images
+P = shadow_space(n, s);
+U = zeros(n, s);
+G = zeros(n, s);
+
+% Small lower triangular system P'*G, its right-hand side, and coefficients
+Ms = eye(s);
+f = zeros(s, 1);
+c = zeros(s, 1);
+
+kappa = 0.7;
+omega = 1.0;
+while true
+    % f = P'*r
+    for i = 1:s
+        f(i) = P(:, i)' * r;
+    end
+
+    for k = 1:s
+        % Solve the lower triangular system Ms(k:s,k:s)*c = f(k:s)
+        for i = k:s
+            ci = f(i);
+            for j = k:i-1
+                ci = ci - Ms(i, j) * c(j);
+            end
+            c(i) = ci / Ms(i, i);
+        end
+
+        % v = r - G(:,k:s)*c
+        v = r;
+        for j = k:s
+            v = v - c(j) * G(:, j);
+        end
+
+        % Compute the preconditioned vector and store into v, using t as
+        % the buffer
+        if isempty(coder.target)
+            v = ILUsol(M, v);
+        else
+            [v, t, y2] = MILUsolve(M, v, t, y2);
+        end
+
+        % U(:,k) = U(:,k:s)*c + omega*v
+        U(:, k) = c(k) * U(:, k) + omega * v;
+        for j = k+1:s
+            U(:, k) = U(:, k) + c(j) * U(:, j);
+        end
+
+        t = MILU_prodAx(A, op, U(:, k), t, nthreads);
+        G(:, k) = t;
+
+        % Make G(:,k) orthogonal to P(:,1:k-1)
+        for i = 1:k-1
+            alpha = (P(:, i)' * G(:, k)) / Ms(i, i);
+            G(:, k) = G(:, k) - alpha * G(:, i);
+            U(:, k) = U(:, k) - alpha * U(:, i);
+        end
+
+        % Ms(k:s,k) = P(:,k:s)'*G(:,k)
+        for i = k:s
+            Ms(i, k) = P(:, i)' * G(:, k);
+        end
+
+        if Ms(k, k) == 0.0
+            flag = int32(-1);
+            break
+        end
+
+        % Make r orthogonal to P(:,1:k)
+        beta = f(k) / Ms(k, k);
+        r = r - beta * G(:, k);
+        x = x + beta * U(:, k);
+        for i = k+1:s
+            f(i) = f(i) - beta * Ms(i, k);
+        end
+
+        iter = iter + 1;
+        resid = sqrt(vec_sqnorm2(r)) / bnrm2; % check convergence
+        if nargout > 3
+            resids(iter) = resid;
+        end
+
+        if verbose > 1 || verbose > 0 && mod(iter, 30) == 0
+            m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
+        end
+
+        if resid <= rtol || iter >= maxit
+            break
+        end
+    end
+
+    if resid <= rtol || iter >= maxit || flag
+        break
+    elseif resid > 100 % diverged
+        flag = int32(-3);
+        break
+    end
+
+    % Dimension-reduction step. Compute the preconditioned vector and
+    % store into v, using t as the buffer
+    if isempty(coder.target)
+        v = ILUsol(M, r);
+    else
+        v = r;
+        [v, t, y2] = MILUsolve(M, v, t, y2);
+    end
+
+    % t = A*v fused with (t, r) and (t, t)
+    [t, tr] = MILU_prodAxdot(A, op, v, t, r, nthreads);
+    tnrm = sqrt(tr(2));
+    rnrm = resid * bnrm2;
+    ts = tr(1);
+    if tnrm == 0.0
+        omega = 0.0;
+    else
+        omega = ts / (tnrm * tnrm);
+        rho = abs(ts / (tnrm * rnrm));
+        if rho < kappa
+            omega = omega * kappa / rho;
+        end
+    end
+
+    if omega == 0.0
+        flag = int32(-2);
+        break
+    end
+
+    r = r - omega * t;
+    x = x + omega * v; % update approximation
+
+    iter = iter + 1;
+    resid = sqrt(vec_sqnorm2(r)) / bnrm2; % check convergence
+    if nargout > 3
+        resids(iter) = resid;
+    end
+
+    if verbose > 1 || verbose > 0 && mod(iter, 30) == 0
+        m2c_printf('At iteration %d, relative residual is %g.\n', iter, resid);
+    end
+
+    if resid <= rtol || iter >= maxit
+        break
+    end
+end
+
+if nargout > 3
+    resids = resids(1:iter);
+end
+
+if resid <= rtol % converged
+    flag = int32(0);
+elseif flag == 0 % no convergence
+    flag = int32(1);
+end
+
+end
+
+function P = shadow_space(n, s)
+% Orthonormal basis of a pseudo-random shadow space. A linear congruential
+% generator is used so that the compiled and interpreted kernels use the
+% same space and produce the same iterates.
+
+P = zeros(n, s);
+seed = 1;
+for j = 1:s
+    for i = 1:n
+        seed = mod(seed * 69069 + 1, 4294967296);
+        P(i, j) = seed / 4294967296 - 0.5;
+    end
+end
+
+for j = 1:s
+    for i = 1:j-1
+        P(:, j) = P(:, j) - (P(:, i)' * P(:, j)) * P(:, i);
+    end
+    P(:, j) = P(:, j) / sqrt(vec_sqnorm2(P(:, j)));
+end
+
+end
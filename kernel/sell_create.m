@@ -0,0 +1,91 @@
+function S = sell_create(A, C, sigma)
+%sell_create Convert a CRS matrix into the SELL-C-sigma format
+%
+%   S = sell_create(A) converts a crs_matrix A into the sell_matrix S
+%   with slices of 8 rows and a sorting window of 256 rows.
+%
+%   S = sell_create(A, C, sigma) specifies the number of rows per slice C
+%   (at most 16) and the sorting window sigma (rounded up to a multiple
+%   of C). Larger sigma reduces the padding for irregular matrices at the
+%   cost of less locality in the accesses to the output vector.
+%
+%   The padding ratio numel(S.val) / nnz(A) indicates whether the format
+%   pays off. It is close to 1 for matrices with uniform row lengths.
+%
+% See also: sell_matrix, sell_prodAx
+
+%#codegen -args {crs_matrix, int32(0), int32(0)}
+%#codegen sell_create_1arg -args {crs_matrix}
+
+if nargin < 2 || C <= 0
+    C = int32(8);
+elseif C > 16
+    m2c_error('sell_create:InvalidSliceSize', ...
+        'The number of rows per slice must be at most 16.');
+end
+if nargin < 3 || sigma <= 0
+    sigma = int32(256);
+end
+sigma = C * idivide(sigma + C - 1, C);
+
+n = A.nrows;
+nslices = idivide(n + C - 1, C);
+
+% Sort the rows by decreasing length within each window
+row_perm = zeros(nslices * C, 1, 'int32');
+lens = zeros(nslices * C, 1, 'int32');
+for i = 1:n
+    row_perm(i) = i;
+    lens(i) = A.row_ptr(i+1) - A.row_ptr(i);
+end
+
+for w0 = 1:sigma:n
+    w1 = min(w0 + sigma - 1, n);
+    [sorted, idx] = sort(lens(w0:w1), 'descend');
+    perm = row_perm(w0:w1);
+    for k = 1:w1 - w0 + 1
+        lens(w0 + k - 1) = sorted(k);
+        row_perm(w0 + k - 1) = perm(idx(k));
+    end
+end
+
+% Determine the width and the offset of each slice
+slice_ptr = zeros(nslices + 1, 1, 'int32');
+slice_ptr(1) = 1;
+for s = 1:nslices
+    width = int32(0);
+    for r = (s - 1) * C + 1:s * C
+        width = max(width, lens(r));
+    end
+    slice_ptr(s + 1) = slice_ptr(s) + width * C;
+end
+
+% Fill in the slices column by column. Padding entries have zero values
+% and repeat a valid column index, so they need no special treatment.
+nnz_padded = slice_ptr(nslices + 1) - 1;
+col_ind = ones(nnz_padded, 1, 'int32');
+val = zeros(nnz_padded, 1);
+for s = 1:nslices
+    for r = 1:C
+        row = row_perm((s - 1) * C + r);
+        if row == 0
+            continue
+        end
+        k = slice_ptr(s) + r - 1;
+        for j = A.row_ptr(row):A.row_ptr(row+1) - 1
+            col_ind(k) = A.col_ind(j);
+            val(k) = A.val(j);
+            k = k + C;
+        end
+        if A.row_ptr(row+1) > A.row_ptr(row)
+            last = A.col_ind(A.row_ptr(row+1) - 1);
+            while k < slice_ptr(s + 1)
+                col_ind(k) = last;
+                k = k + C;
+            end
+        end
+    end
+end
+
+S = struct('slice_ptr', slice_ptr, 'row_perm', row_perm, ...
+    'col_ind', col_ind, 'val', val, 'nrows', n, 'ncols', A.ncols, 'C', C);
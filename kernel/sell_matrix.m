@@ -0,0 +1,20 @@
+function type = sell_matrix
+% Data type definition for a sparse matrix in the SELL-C-sigma format
+%
+% The rows are sorted by decreasing length within windows of sigma rows
+% and grouped into slices of C rows. Each slice is stored column-major
+% with the width of its longest row, so that the C rows of a slice are
+% processed together in unit stride. row_perm maps the rows of the
+% slices to the rows of the original matrix (0 for padding rows), and
+% the entries of slice s are val(slice_ptr(s):slice_ptr(s+1)-1).
+%
+% See also: sell_create, sell_prodAx
+
+type = coder.typeof(...
+    struct('slice_ptr', m2c_intvec, ...
+    'row_perm', m2c_intvec, ...
+    'col_ind', m2c_intvec, ...
+    'val', m2c_vec, ...
+    'nrows', int32(0), ...
+    'ncols', int32(0), ...
+    'C', int32(0)));
@@ -0,0 +1,42 @@
+function y = sell_prodAx(S, x, y, nthreads, part)
+%sell_prodAx Compute y = A*x for a matrix A in the SELL-C-sigma format
+%
+%   y = sell_prodAx(S, x, y, nthreads) computes the product of the
+%   sell_matrix S created by sell_create with x and stores it into y.
+%
+%   The C rows of each slice are accumulated together in a fixed-size
+%   buffer, and the innermost loop over them has unit stride and no
+%   dependencies, so that the compiler vectorizes it. The slices are
+%   partitioned evenly among the threads.
+%
+%   y = sell_prodAx(S, x, y, nthreads, part) partitions the slices
+%   according to part computed by MILU_partition from S.slice_ptr.
+%
+% See also: sell_create, crs_prodAx
+
+%#codegen -args {sell_matrix, m2c_vec, m2c_vec, int32(0), m2c_intvec}
+%#codegen sell_prodAx_4args -args {sell_matrix, m2c_vec, m2c_vec, int32(0)}
+
+if size(y, 1) < S.nrows
+    m2c_error('sell_prodAx:BufferTooSmal', 'Buffer space for output y is too small.');
+end
+
+if nargin < 5
+    part = zeros(0, 1, 'int32');
+end
+
+if isempty(coder.target) || nthreads <= 1
+    y = sell_prodAx_kernel(S, x, y, part);
+else
+    %#omp parallel default(shared) num_threads(nthreads)
+    y = sell_prodAx_kernel(S, x, y, part);
+end
+
+end
+
+function y = sell_prodAx_kernel(S, x, y, part)
+coder.inline('never');
+
+y = sell_prodAx_thread(S, x, y, part);
+
+end
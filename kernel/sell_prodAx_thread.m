@@ -0,0 +1,31 @@
+function y = sell_prodAx_thread(S, x, y, part)
+%sell_prodAx_thread Compute the slices of y = A*x owned by the calling thread
+%
+%   y = sell_prodAx_thread(S, x, y, part) must be called by all threads of
+%   a parallel region, or outside of a parallel region to compute all of
+%   y. The slices are split among the threads by MILU_range with part.
+%
+% See also: sell_prodAx, MILU_prodAx_thread
+
+coder.inline('always');
+
+C = S.C;
+[sstart, send] = MILU_range(int32(numel(S.slice_ptr)) - 1, part);
+
+t = zeros(16, 1);
+for s = sstart:send
+    for r = 1:C
+        t(r) = 0;
+    end
+    for k = S.slice_ptr(s):C:S.slice_ptr(s+1) - 1
+        for r = 1:C
+            t(r) = t(r) + S.val(k + r - 1) * x(S.col_ind(k + r - 1));
+        end
+    end
+    for r = 1:C
+        row = S.row_perm((s - 1) * C + r);
+        if row > 0
+            y(row) = t(r);
+        end
+    end
+end
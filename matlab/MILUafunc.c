@@ -0,0 +1,283 @@
+/* ========================================================================== */
+/* === MILUafunc mexFunction ================================================ */
+/* ========================================================================== */
+
+/*
+    Usage:
+
+    creates a matrix-free operator for the compiled kernels gmresMILU_MF
+    and bicgstabMILU_MF, i.e. a MILU_Afunc_t (see include/milu_afunc.h)
+    wrapped into an m2c opaque object, and applies or frees it.
+
+    For a function handle Afunc, the callback evaluates Afunc(x) in MATLAB.
+    For a real sparse matrix A, the callback is a C function that computes
+    A*x with a copy of A in compressed rows, without calling back into
+    MATLAB. The objects stay valid until they are freed, and the MEX file
+    is locked in memory as long as any of them exists.
+
+    Example:
+
+    op = MILUafunc(Afunc);     % or op = MILUafunc(A)
+    y = MILUafunc(op, x);      % y = A*x through the function pointer
+    MILUafunc(op);             % frees op
+*/
+
+/* ========================================================================== */
+/* === Include files and prototypes ========================================= */
+/* ========================================================================== */
+
+#include "matrix.h"
+#include "mex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "milu_afunc.h"
+
+#define AFUNC_TYPE "MILU_Afunc_t *"
+
+/* The operator starts with its MILU_Afunc_t, so that a pointer to it is
+   also a pointer to the MILU_Afunc_t seen by the kernels. */
+typedef struct AfuncObj {
+  MILU_Afunc_t base;
+  mxArray *handle;     /* function handle, or NULL for a sparse matrix */
+  size_t n;            /* number of rows and columns */
+  mwIndex *ptr, *ind;  /* compressed rows of the sparse matrix */
+  double *val;
+  struct AfuncObj *next;
+} AfuncObj;
+
+static AfuncObj *objs = NULL; /* all objects that have not been freed */
+
+/* ========================================================================== */
+/* === callbacks ============================================================ */
+/* ========================================================================== */
+
+static void apply_handle(void *ctx, const double *x, double *y, int n) {
+  AfuncObj *op = (AfuncObj *)ctx;
+  mxArray *rhs[2], *lhs = NULL;
+
+  rhs[0] = op->handle;
+  rhs[1] = mxCreateDoubleMatrix((mwSize)n, 1, mxREAL);
+  memcpy(mxGetPr(rhs[1]), x, (size_t)n * sizeof(double));
+  mexCallMATLAB(1, &lhs, 2, rhs, "feval");
+  mxDestroyArray(rhs[1]);
+
+  if (!mxIsDouble(lhs) || mxIsComplex(lhs) || mxIsSparse(lhs) ||
+      mxGetNumberOfElements(lhs) != (size_t)n) {
+    mxDestroyArray(lhs);
+    mexErrMsgTxt("The function handle must return a real vector of the "
+                 "length of its input.");
+  }
+  memcpy(y, mxGetPr(lhs), (size_t)n * sizeof(double));
+  mxDestroyArray(lhs);
+}
+
+static void apply_sparse(void *ctx, const double *x, double *y, int n) {
+  AfuncObj *op = (AfuncObj *)ctx;
+  int i;
+  mwIndex k;
+  double t;
+
+#pragma omp parallel for private(k, t) schedule(static)
+  for (i = 0; i < n; i++) {
+    t = 0.0;
+    for (k = op->ptr[i]; k < op->ptr[i + 1]; k++)
+      t += op->val[k] * x[op->ind[k]];
+    y[i] = t;
+  }
+}
+
+/* ========================================================================== */
+/* === object management ==================================================== */
+/* ========================================================================== */
+
+static void free_obj(AfuncObj *op) {
+  if (op->handle)
+    mxDestroyArray(op->handle);
+  free(op->ptr);
+  free(op->ind);
+  free(op->val);
+  free(op);
+}
+
+static void free_all(void) {
+  AfuncObj *op;
+  while (objs) {
+    op = objs;
+    objs = op->next;
+    free_obj(op);
+  }
+}
+
+static void register_obj(AfuncObj *op) {
+  if (!objs) {
+    mexAtExit(free_all);
+    mexLock();
+  }
+  op->base.ctx = op;
+  op->next = objs;
+  objs = op;
+}
+
+static void unregister_obj(AfuncObj *op) {
+  AfuncObj **p;
+  for (p = &objs; *p != op; p = &(*p)->next)
+    ;
+  *p = op->next;
+  free_obj(op);
+  if (!objs)
+    mexUnlock();
+}
+
+static AfuncObj *create_handle(const mxArray *fh) {
+  AfuncObj *op = (AfuncObj *)calloc(1, sizeof(AfuncObj));
+  if (!op)
+    mexErrMsgTxt("Out of memory.");
+  op->handle = mxDuplicateArray(fh);
+  mexMakeArrayPersistent(op->handle);
+  op->base.apply = apply_handle;
+  return op;
+}
+
+static AfuncObj *create_sparse(const mxArray *A) {
+  AfuncObj *op;
+  mwIndex *jc = mxGetJc(A), *ir = mxGetIr(A);
+  double *pr = mxGetPr(A);
+  size_t n = mxGetN(A), nnz = jc[n], i, j;
+  mwIndex k;
+
+  op = (AfuncObj *)calloc(1, sizeof(AfuncObj));
+  if (!op)
+    mexErrMsgTxt("Out of memory.");
+  op->n = n;
+  op->ptr = (mwIndex *)calloc(n + 1, sizeof(mwIndex));
+  op->ind = (mwIndex *)malloc((nnz ? nnz : 1) * sizeof(mwIndex));
+  op->val = (double *)malloc((nnz ? nnz : 1) * sizeof(double));
+  if (!op->ptr || !op->ind || !op->val) {
+    free_obj(op);
+    mexErrMsgTxt("Out of memory.");
+  }
+
+  /* transpose the compressed columns of A into compressed rows */
+  for (k = 0; k < nnz; k++)
+    op->ptr[ir[k] + 1]++;
+  for (i = 0; i < n; i++)
+    op->ptr[i + 1] += op->ptr[i];
+  for (j = 0; j < n; j++)
+    for (k = jc[j]; k < jc[j + 1]; k++) {
+      i = ir[k];
+      op->ind[op->ptr[i]] = j;
+      op->val[op->ptr[i]++] = pr[k];
+    }
+  for (i = n; i > 0; i--)
+    op->ptr[i] = op->ptr[i - 1];
+  op->ptr[0] = 0;
+
+  op->base.apply = apply_sparse;
+  return op;
+}
+
+/* ========================================================================== */
+/* === m2c opaque objects =================================================== */
+/* ========================================================================== */
+
+/* An m2c opaque object is a struct with the bytes of the pointer in the
+   uint8 vector data, the C type in type, and the number of items. */
+static mxArray *wrap_obj(AfuncObj *op) {
+  const char *fields[] = {"data", "type", "nitems"};
+  mxArray *obj = mxCreateStructMatrix(1, 1, 3, fields), *data, *nitems;
+  MILU_Afunc_t *p = &op->base;
+
+  data = mxCreateNumericMatrix(sizeof(p), 1, mxUINT8_CLASS, mxREAL);
+  memcpy(mxGetData(data), &p, sizeof(p));
+  nitems = mxCreateNumericMatrix(1, 1, mxINT32_CLASS, mxREAL);
+  *(int *)mxGetData(nitems) = 1;
+
+  mxSetField(obj, 0, "data", data);
+  mxSetField(obj, 0, "type", mxCreateString(AFUNC_TYPE));
+  mxSetField(obj, 0, "nitems", nitems);
+  return obj;
+}
+
+/* Returns the live object wrapped in obj, or NULL if obj is not one. */
+static AfuncObj *unwrap_obj(const mxArray *obj) {
+  mxArray *data, *type;
+  char buf[sizeof(AFUNC_TYPE)];
+  MILU_Afunc_t *p;
+  AfuncObj *op;
+
+  if (!mxIsStruct(obj) || mxGetNumberOfElements(obj) != 1)
+    return NULL;
+  data = mxGetField(obj, 0, "data");
+  type = mxGetField(obj, 0, "type");
+  if (!data || !type || mxGetClassID(data) != mxUINT8_CLASS ||
+      mxGetNumberOfElements(data) != sizeof(p) || !mxIsChar(type) ||
+      mxGetString(type, buf, sizeof(buf)) || strcmp(buf, AFUNC_TYPE))
+    return NULL;
+
+  memcpy(&p, mxGetData(data), sizeof(p));
+  for (op = objs; op; op = op->next)
+    if (&op->base == p)
+      return op;
+  return NULL;
+}
+
+/* ========================================================================== */
+/* === mexFunction ========================================================== */
+/* ========================================================================== */
+
+void mexFunction(
+    /* === Parameters ======================================================= */
+
+    int nlhs,             /* number of left-hand sides */
+    mxArray *plhs[],      /* left-hand side matrices */
+    int nrhs,             /* number of right--hand sides */
+    const mxArray *prhs[] /* right-hand side matrices */
+    ) {
+  AfuncObj *op = NULL;
+  size_t n;
+
+  if (nrhs < 1 || nrhs > 2)
+    mexErrMsgTxt("One or two input arguments required.");
+
+  if (mxIsStruct(prhs[0])) {
+    op = unwrap_obj(prhs[0]);
+    if (!op)
+      mexErrMsgTxt("First input is not a valid MILU_Afunc object.");
+
+    if (nrhs == 1) {
+      if (nlhs > 0)
+        mexErrMsgTxt("No output arguments are returned.");
+      unregister_obj(op);
+      return;
+    }
+
+    n = mxGetNumberOfElements(prhs[1]);
+    if (!mxIsDouble(prhs[1]) || mxIsComplex(prhs[1]) || mxIsSparse(prhs[1]))
+      mexErrMsgTxt("Second input must be a real full vector.");
+    else if (op->handle == NULL && n != op->n)
+      mexErrMsgTxt("Second input must have as many entries as A has columns.");
+
+    plhs[0] = mxCreateDoubleMatrix((mwSize)n, 1, mxREAL);
+    MILU_Afunc_apply(&op->base, mxGetPr(prhs[1]), mxGetPr(plhs[0]), (int)n);
+    return;
+  }
+
+  if (nrhs != 1)
+    mexErrMsgTxt("Only one input argument is allowed to create an operator.");
+  else if (nlhs > 1)
+    mexErrMsgTxt("Only one output argument is returned.");
+
+  if (mxGetClassID(prhs[0]) == mxFUNCTION_CLASS)
+    op = create_handle(prhs[0]);
+  else if (mxIsSparse(prhs[0]) && mxIsDouble(prhs[0]) &&
+           !mxIsComplex(prhs[0]) && mxGetM(prhs[0]) == mxGetN(prhs[0]))
+    op = create_sparse(prhs[0]);
+  else
+    mexErrMsgTxt("Input must be a function handle or a real square sparse "
+                 "matrix.");
+
+  register_obj(op);
+  plhs[0] = wrap_obj(op);
+}
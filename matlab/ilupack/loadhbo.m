@@ -6,7 +6,8 @@ function [A,rhs,rhstyp]=loadhbo(filename)
 %
 % Input
 % -----
-% filename   name of the file without extension
+% filename   name of the file without extension, or of a binary .csrb
+%            file written by savehbo (then rhs is empty)
 %
 % Output
 % ------
@@ -31,6 +32,13 @@ if nargout~=3
    error('three output parameters requried');
 end
 
+if length(filename)>=5 && strcmp(filename(end-4:end),'.csrb')
+   A=loadcsrb(filename);
+   rhs=[];
+   rhstyp='   ';
+   return
+end
+
 if length(filename)>=3
    if filename(end-2)=='.' && filename(end-1)=='r' && filename(end)=='b'
       fp=fopen(filename);
@@ -6,11 +6,22 @@ function savehbo(filename, A,b,x0,x)
 % 
 % save matrix A and optionally right hand side b, initial guess x0 and
 % exact solution x
+%
+% If filename ends with '.csrb', A alone is saved in the binary format
+% read by loadhbo and the ITSOL drivers (see savecsrb).
 
 
 if (nargin<2)
    error('at least two input parameters required!');
 end
+
+if length(filename)>=5 && strcmp(filename(end-4:end),'.csrb')
+   if nargin>2
+      error('the .csrb format stores the matrix only');
+   end
+   savecsrb(filename, A);
+   return
+end
 [m,n]=size(A);
 
 if nargin>=3
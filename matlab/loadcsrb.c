@@ -0,0 +1,183 @@
+/* ========================================================================== */
+/* === loadcsrb mexFunction ================================================= */
+/* ========================================================================== */
+
+/*
+    Usage:
+
+    loads a sparse matrix from a binary .csrb file written by savecsrb or
+    by ITSOL (writecsrb). The file is mapped and its checksum verified;
+    compressed columns are copied into A directly, compressed rows are
+    transposed on the fly. See ITSOL_2/INC/csrbin.h for the layout.
+
+    Example:
+
+    A = loadcsrb(filename);
+*/
+
+/* ========================================================================== */
+/* === Include files and prototypes ========================================= */
+/* ========================================================================== */
+
+#include "matrix.h"
+#include "mex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ITSOL_2/INC/csrbin.h"
+
+/* ========================================================================== */
+/* === check_offsets ======================================================== */
+/* ========================================================================== */
+
+/* Checks that the np+1 offsets of m start at 0, end at nz and are
+   nondecreasing, and that the indices are below nind. For compressed
+   columns the row indices must also increase within each column, as
+   MATLAB requires. Returns 0 if the sections are consistent. */
+static int check_offsets(const CsrbMap *m, size_t np, size_t nind, int csc) {
+  uint32_t w = m->h->idxw;
+  size_t nz = (size_t)m->h->nnz, j;
+  int64_t k, k1, k2, i, iprev;
+
+  if (csrb_get(m->ptr, w, 0) != 0 || csrb_get(m->ptr, w, np) != (int64_t)nz)
+    return 1;
+  for (j = 0; j < np; j++) {
+    k1 = csrb_get(m->ptr, w, j);
+    k2 = csrb_get(m->ptr, w, j + 1);
+    if (k2 < k1 || k2 > (int64_t)nz)
+      return 1;
+    iprev = -1;
+    for (k = k1; k < k2; k++) {
+      i = csrb_get(m->ind, w, k);
+      if (i < 0 || i >= (int64_t)nind || (csc && i <= iprev))
+        return 1;
+      iprev = i;
+    }
+  }
+  return 0;
+}
+
+/* ========================================================================== */
+/* === mexFunction ========================================================== */
+/* ========================================================================== */
+
+void mexFunction(
+    /* === Parameters ======================================================= */
+
+    int nlhs,             /* number of left-hand sides */
+    mxArray *plhs[],      /* left-hand side matrices */
+    int nrhs,             /* number of right--hand sides */
+    const mxArray *prhs[] /* right-hand side matrices */
+    ) {
+  CsrbMap m;
+  CsrbHead *h;
+  char *fname;
+  int ierr, cplx;
+  uint32_t w;
+  mwSize buflen;
+  mwIndex *irs, *jcs, *next;
+  size_t i, j, k, nr, nc, nz;
+  double *sr, *si;
+  mxArray *fout;
+
+  if (nrhs != 1)
+    mexErrMsgTxt("Only one input argument required.");
+  else if (nlhs > 1)
+    mexErrMsgTxt("Only one output argument is returned.");
+  else if (mxGetClassID(prhs[0]) != mxCHAR_CLASS)
+    mexErrMsgTxt("Input must be a string.");
+
+  /* get filename */
+  buflen = mxGetM(prhs[0]) * mxGetN(prhs[0]) + 1;
+  fname = (char *)mxCalloc((size_t)buflen, (size_t)sizeof(char));
+  mxGetString(prhs[0], fname, buflen);
+
+  ierr = csrb_open(fname, &m, 1);
+  if (ierr) {
+    switch (ierr) {
+    case 1:
+      mexPrintf(" file %s", fname);
+      mexErrMsgTxt(" not found");
+      break;
+    case 2:
+      mexErrMsgTxt("not a .csrb file of this version and byte order\n");
+      break;
+    case 3:
+      mexErrMsgTxt("file is truncated\n");
+      break;
+    default:
+      mexErrMsgTxt("checksum mismatch\n");
+      break;
+    }
+    return;
+  }
+  h = m.h;
+  w = h->idxw;
+  nr = (size_t)h->nrow;
+  nc = (size_t)h->ncol;
+  nz = (size_t)h->nnz;
+  cplx = (h->flags & CSRB_COMPLEX) != 0;
+
+  /* the checksum only guards against corruption, so check the structure
+     before creating the sparse matrix from it */
+  if ((h->flags & CSRB_CSC) ? check_offsets(&m, nc, nr, 1)
+                            : check_offsets(&m, nr, nc, 0)) {
+    csrb_close(&m);
+    mexErrMsgTxt("inconsistent offsets or indices\n");
+    return;
+  }
+
+  fout = mxCreateSparse((mwSize)nr, (mwSize)nc, (mwSize)(nz > 0 ? nz : 1),
+                        cplx ? mxCOMPLEX : mxREAL);
+  sr = (double *)mxGetPr(fout);
+  si = cplx ? (double *)mxGetPi(fout) : NULL;
+  irs = (mwIndex *)mxGetIr(fout);
+  jcs = (mwIndex *)mxGetJc(fout);
+
+  if (h->flags & CSRB_CSC) {
+    /* compressed columns: copy, converting the indices if necessary */
+    if (w == sizeof(mwIndex)) {
+      memcpy(jcs, m.ptr, (nc + 1) * sizeof(mwIndex));
+      memcpy(irs, m.ind, nz * sizeof(mwIndex));
+    } else {
+      for (j = 0; j <= nc; j++)
+        jcs[j] = (mwIndex)csrb_get(m.ptr, w, j);
+      for (k = 0; k < nz; k++)
+        irs[k] = (mwIndex)csrb_get(m.ind, w, k);
+    }
+    if (cplx)
+      for (k = 0; k < nz; k++) {
+        sr[k] = m.val[2 * k];
+        si[k] = m.val[2 * k + 1];
+      }
+    else
+      memcpy(sr, m.val, nz * sizeof(double));
+  } else {
+    /* compressed rows: transpose by counting the entries per column */
+    for (j = 0; j <= nc; j++)
+      jcs[j] = 0;
+    for (k = 0; k < nz; k++)
+      jcs[(size_t)csrb_get(m.ind, w, k) + 1]++;
+    for (j = 0; j < nc; j++)
+      jcs[j + 1] += jcs[j];
+    next = (mwIndex *)mxMalloc((nc + 1) * sizeof(mwIndex));
+    memcpy(next, jcs, (nc + 1) * sizeof(mwIndex));
+    for (i = 0; i < nr; i++)
+      for (k = (size_t)csrb_get(m.ptr, w, i);
+           k < (size_t)csrb_get(m.ptr, w, i + 1); k++) {
+        j = next[csrb_get(m.ind, w, k)]++;
+        irs[j] = i;
+        if (cplx) {
+          sr[j] = m.val[2 * k];
+          si[j] = m.val[2 * k + 1];
+        } else
+          sr[j] = m.val[k];
+      }
+    mxFree(next);
+  }
+
+  csrb_close(&m);
+  mxFree(fname);
+  plhs[0] = fout;
+}
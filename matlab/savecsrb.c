@@ -0,0 +1,99 @@
+/* ========================================================================== */
+/* === savecsrb mexFunction ================================================= */
+/* ========================================================================== */
+
+/*
+    Usage:
+
+    saves the sparse matrix A (real or complex) to a binary .csrb file,
+    which loadcsrb and the ITSOL readers map back without parsing. The
+    columns of A are stored as they are (compressed columns, 0-based,
+    mwIndex-wide), see ITSOL_2/INC/csrbin.h for the layout.
+
+    Example:
+
+    savecsrb(filename, A);
+*/
+
+/* ========================================================================== */
+/* === Include files and prototypes ========================================= */
+/* ========================================================================== */
+
+#include "matrix.h"
+#include "mex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ITSOL_2/INC/csrbin.h"
+
+/* ========================================================================== */
+/* === mexFunction ========================================================== */
+/* ========================================================================== */
+
+void mexFunction(
+    /* === Parameters ======================================================= */
+
+    int nlhs,             /* number of left-hand sides */
+    mxArray *plhs[],      /* left-hand side matrices */
+    int nrhs,             /* number of right--hand sides */
+    const mxArray *prhs[] /* right-hand side matrices */
+    ) {
+  CsrbHead h;
+  CsrbMap m;
+  char *fname;
+  mwSize buflen;
+  mwIndex *irs, *jcs;
+  size_t k, ncols;
+  double *sr, *si;
+  const mxArray *A_input;
+
+  if (nrhs != 2)
+    mexErrMsgTxt("Two input arguments required.");
+  else if (nlhs > 0)
+    mexErrMsgTxt("No output arguments are returned.");
+  else if (mxGetClassID(prhs[0]) != mxCHAR_CLASS)
+    mexErrMsgTxt("First input must be a string.");
+  else if (!mxIsSparse(prhs[1]) || !mxIsDouble(prhs[1]))
+    mexErrMsgTxt("Second input must be a sparse matrix.");
+
+  /* get filename */
+  buflen = mxGetM(prhs[0]) * mxGetN(prhs[0]) + 1;
+  fname = (char *)mxCalloc((size_t)buflen, (size_t)sizeof(char));
+  mxGetString(prhs[0], fname, buflen);
+
+  A_input = prhs[1];
+  ncols = mxGetN(A_input);
+  irs = (mwIndex *)mxGetIr(A_input);
+  jcs = (mwIndex *)mxGetJc(A_input);
+  sr = (double *)mxGetPr(A_input);
+  si = mxIsComplex(A_input) ? (double *)mxGetPi(A_input) : NULL;
+
+  memset(&h, 0, sizeof(h));
+  h.idxw = sizeof(mwIndex);
+  h.flags = CSRB_CSC | (si ? CSRB_COMPLEX : 0);
+  h.nrow = (int64_t)mxGetM(A_input);
+  h.ncol = (int64_t)ncols;
+  h.nnz = (int64_t)jcs[ncols];
+
+  if (csrb_create(fname, &h, &m)) {
+    mexPrintf(" file %s", fname);
+    mexErrMsgTxt(" cannot be created");
+    return;
+  }
+
+  /* the index arrays of A are copied as they are */
+  memcpy(m.ptr, jcs, (ncols + 1) * sizeof(mwIndex));
+  memcpy(m.ind, irs, (size_t)h.nnz * sizeof(mwIndex));
+  if (si) {
+    for (k = 0; k < (size_t)h.nnz; k++) {
+      m.val[2 * k] = sr[k];
+      m.val[2 * k + 1] = si[k];
+    }
+  } else
+    memcpy(m.val, sr, (size_t)h.nnz * sizeof(double));
+
+  if (csrb_close(&m))
+    mexErrMsgTxt("error writing the matrix.");
+  mxFree(fname);
+}
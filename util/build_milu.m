@@ -14,6 +14,8 @@ end
 
 m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
     ['-L', LIBDIR], '-lilupack', 'MILUsolve');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'MILUoperator');
 m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
     ['-L', LIBDIR], '-lilupack', 'gmresMILU_HO');
 m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
@@ -22,5 +24,25 @@ m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
     ['-L', LIBDIR], '-lilupack', 'gmresMILU_CGS');
 m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
     ['-L', LIBDIR], '-lilupack', 'bicgstabMILU_kernel');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'bicgstabMILU_fused');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'bicgstablMILU_kernel');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'idrsMILU_kernel');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'gmresMILU_MF');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'gmresMILU_IR');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'bicgstabMILU_MF');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'gmresMILU_workspace');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'gmresMILU_block');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'gmresMILU_batch');
+m2c('-mex', '-omp', '-O3', varargin{:}, ['-I', miluroot, '/include'], ...
+    ['-L', LIBDIR], '-lilupack', 'gmresMILU_DR');
 
 end